@@ -0,0 +1,120 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "CommandStatus.h"
+
+// Per-room counters collected across sessions
+enum class RoomCounter {
+    VISITS,         // entries into the room
+    TURNS,          // commands issued while standing in it
+    FAILED_TURNS,   // ... that did not succeed (where players get stuck)
+    ITEM_DROPS,
+    DEATHS
+};
+
+constexpr size_t ROOM_COUNTER_COUNT = static_cast<size_t>(RoomCounter::DEATHS) + 1;
+
+// Gameplay statistics shared by every session of a process. Each thread
+// counts into its own cache-line-aligned block: room ids below DENSE_ROOMS
+// and the first LOCAL_VERBS verbs it sees index plain arrays of counters
+// that only that thread writes, so the hot path takes no lock and stores
+// no strings. A block is folded into the totals by its thread every
+// MERGE_THRESHOLD events, and by merge() (before saving or reading) at any
+// time: each merge adds what a counter gained since the previous one.
+// Larger room ids, verbs beyond the first LOCAL_VERBS and item drops go to
+// small per-block maps under the block's own mutex.
+//
+// The saved file is columnar, all integers LEB128 varints, strings
+// length-prefixed:
+//   "FIAN" version
+//   rooms:    n, room ids[n] (ascending), then ROOM_COUNTER_COUNT columns of n counts
+//   commands: n, verbs[n] (sorted), then COMMAND_STATUS_COUNT columns of n counts
+//   drops:    n, item names[n] (sorted), counts[n]
+// Column order follows the RoomCounter and CommandStatus enums.
+class Analytics {
+private:
+    static constexpr size_t MERGE_THRESHOLD = 256;
+    static constexpr size_t DENSE_ROOMS = 256; // room ids counted in arrays
+    static constexpr size_t LOCAL_VERBS = 64;  // verbs a thread counts in arrays
+    static constexpr size_t MAX_VERBS = 4096;  // unknown input is free text; cap its cardinality
+    static constexpr size_t MAX_VERB_LENGTH = 24;
+    
+    using RoomRow = std::array<uint64_t, ROOM_COUNTER_COUNT>;
+    using CommandRow = std::array<uint64_t, COMMAND_STATUS_COUNT>;
+    template <size_t N> using LiveRow = std::array<std::atomic<uint64_t>, N>;
+    
+    // One thread's counters. The arrays are written by that thread only
+    // (merges just read them); the mutex guards the maps.
+    struct alignas(64) LocalCounters {
+        std::thread::id owner;
+        size_t events = 0; // since the owner last merged
+        std::array<LiveRow<ROOM_COUNTER_COUNT>, DENSE_ROOMS> rooms{};
+        std::array<LiveRow<COMMAND_STATUS_COUNT>, LOCAL_VERBS> commands{};
+        std::unordered_map<std::string, uint32_t> verbIds; // owner only
+        std::array<std::string, LOCAL_VERBS> verbs;        // fixed once counted in
+        std::atomic<uint32_t> verbCount{0};
+        
+        // What the totals already hold of the arrays; under totalsMutex
+        std::array<RoomRow, DENSE_ROOMS> roomsMerged{};
+        std::array<CommandRow, LOCAL_VERBS> commandsMerged{};
+        
+        std::mutex mutex;
+        std::unordered_map<int, RoomRow> otherRooms;
+        std::unordered_map<std::string, CommandRow> otherCommands;
+        std::unordered_map<std::string, uint64_t> drops;
+    };
+    
+    const uint64_t instance; // tells the thread-local lookup apart from other Analytics
+    std::mutex localsMutex;
+    std::vector<std::unique_ptr<LocalCounters>> locals;
+    
+    // Merged totals, kept ordered for the columnar export
+    mutable std::mutex totalsMutex;
+    std::map<int, RoomRow> roomTotals;
+    std::map<std::string, CommandRow> commandTotals;
+    std::map<std::string, uint64_t> dropTotals;
+    std::string path;
+    
+    LocalCounters& localCounters();
+    void eventRecorded(LocalCounters& local);
+    void mergeLocal(LocalCounters& local); // holding local.mutex
+    void addCommands(const std::string& verb, const CommandRow& counts);
+    void load();
+
+public:
+    // Counts from an existing file at filePath are loaded and added to;
+    // an empty path keeps statistics in memory only
+    explicit Analytics(const std::string& filePath = "");
+    ~Analytics();
+    
+    Analytics(const Analytics&) = delete;
+    Analytics& operator=(const Analytics&) = delete;
+    
+    // Hot path; thread-safe
+    void recordRoom(int roomId, RoomCounter counter);
+    void recordCommand(const std::string& verb, CommandStatus status);
+    void recordDrop(const std::string& itemName);
+    
+    // Folds every thread's counters into the totals
+    void merge();
+    
+    // Writes the columnar file (to a temporary name, then renamed)
+    void save();
+    
+    // Merged totals, for tools and tests
+    uint64_t getRoomCount(int roomId, RoomCounter counter);
+    uint64_t getCommandCount(const std::string& verb, CommandStatus status);
+    uint64_t getDropCount(const std::string& itemName);
+};
+
+#endif // ANALYTICS_H
@@ -0,0 +1,27 @@
+#ifndef COMMAND_STATUS_H
+#define COMMAND_STATUS_H
+
+#include <cstddef>
+
+// Outcome of one command, reported to machine clients
+enum class CommandStatus {
+    OK,
+    UNKNOWN_COMMAND,
+    MISSING_TARGET,
+    NO_EXIT,
+    NO_ROOM,
+    LOCKED,
+    ITEM_NOT_FOUND,
+    CANNOT_TAKE,
+    INVENTORY_FULL,
+    CANNOT_USE,
+    NO_CREATURE,
+    QUIT,
+    GAME_OVER
+};
+
+constexpr size_t COMMAND_STATUS_COUNT = static_cast<size_t>(CommandStatus::GAME_OVER) + 1;
+
+const char* commandStatusName(CommandStatus status);
+
+#endif // COMMAND_STATUS_H
@@ -0,0 +1,32 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Small LZ77 codec (LZ4-style sequences of literals and back-references).
+// An optional dictionary is treated as data preceding the input, so a
+// buffer that mostly repeats the dictionary compresses to a few bytes;
+// decompression must be given the same dictionary.
+std::string lzCompress(std::string_view input, std::string_view dictionary = std::string_view());
+std::string lzDecompress(std::string_view compressed, std::string_view dictionary = std::string_view());
+
+// A dictionary indexed once, for compressing many small inputs against it
+// without rehashing the dictionary every time. Output is interchangeable
+// with lzCompress/lzDecompress using the same dictionary bytes.
+class LzDictionary {
+private:
+    std::string data;
+    std::vector<int32_t> table; // hash of 4 bytes -> last dictionary position
+
+public:
+    explicit LzDictionary(std::string dictionary = std::string());
+    
+    const std::string& bytes() const { return data; }
+    std::string compress(std::string_view input) const;
+    std::string decompress(std::string_view compressed) const { return lzDecompress(compressed, data); }
+};
+
+#endif // COMPRESSION_H
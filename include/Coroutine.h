@@ -0,0 +1,88 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <string>
+
+// A lazily started coroutine. A Task can be co_awaited from another Task,
+// which resumes once the inner one finishes, so multi-step dialogs can be
+// written as ordinary nested functions.
+class Task {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+        
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    std::coroutine_handle<> next = handle.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+    
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+
+public:
+    Task(Task&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    Task& operator=(Task&& other) noexcept;
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task();
+    
+    // Runs the coroutine until its first suspension point
+    void start();
+    bool done() const { return !handle || handle.done(); }
+    void rethrowIfFailed() const;
+    
+    // Awaiting a Task runs it and resumes the awaiter when it completes
+    bool await_ready() const noexcept { return done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept;
+    void await_resume();
+};
+
+// Input lines for one session. The session coroutine suspends in next()
+// until the driver (console, socket event loop) pushes a line; a closed
+// channel yields std::nullopt so the session can wind down.
+class LineChannel {
+private:
+    std::deque<std::string> lines;
+    std::coroutine_handle<> waiter;
+    bool closed;
+
+public:
+    struct Awaiter {
+        LineChannel& channel;
+        
+        bool await_ready() const noexcept { return !channel.lines.empty() || channel.closed; }
+        void await_suspend(std::coroutine_handle<> handle) noexcept { channel.waiter = handle; }
+        std::optional<std::string> await_resume();
+    };
+    
+    LineChannel() : closed(false) {}
+    
+    Awaiter next() { return Awaiter{*this}; }
+    
+    // Queues a line and resumes the waiting coroutine, which runs until it suspends again
+    void push(std::string line);
+    void close();
+    bool isWaiting() const { return static_cast<bool>(waiter); }
+    bool isClosed() const { return closed; }
+};
+
+#endif // COROUTINE_H
@@ -5,35 +5,131 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <chrono>
 #include "Player.h"
 #include "Room.h"
 #include "Item.h"
+#include "WorldFile.h"
+#include "RegionPager.h"
+#include "Simulation.h"
+#include "Coroutine.h"
+#include "Leaderboard.h"
+#include "Analytics.h"
+#include "CommandStatus.h"
+#include "Spelling.h"
+#include "Script.h"
+#include "Trace.h"
+#include "MemoryUsage.h"
+#include "Random.h"
 
-class Game {
+// Game is also the ScriptHost of the scripts it runs (privately: scripts
+// reach the game only through the events below)
+class Game : private ScriptHost {
 private:
     std::unique_ptr<Player> player;
     std::map<int, std::unique_ptr<Room>> rooms;
+    
+    // Paged world loaded from a file; when set, rooms are served by the pager instead of the map
+    std::unique_ptr<WorldFile> worldFile;
+    std::unique_ptr<RegionPager> regionPager;
     int currentRoomId;
     bool gameRunning;
+    bool quitRequested;
+    bool roomRenderSuppressed; // inside a command batch, only the last step renders rooms
+    bool roomRenderPending;
+    std::ostream* output;
     
     // Game state tracking
     std::map<std::string, bool> gameFlags;
     int gameScore;
     
+    // Creatures and hazards, advanced at a fixed tick rate between commands
+    WorldSimulation simulation;
+    std::chrono::steady_clock::time_point lastTickTime;
+    int ticksPerCommand; // 0 advances by real time
+    
+    // The session's random numbers (see Random.h), saved with its state
+    Random random;
+    static constexpr int MAX_TICKS_PER_COMMAND = 50;
+    static constexpr int UNARMED_DAMAGE = 2;
+    
+    // Where final scores go when the game ends (not owned; may be null)
+    Leaderboard* leaderboard;
+    bool scoreRecorded;
+    Analytics* analytics; // gameplay statistics (not owned; may be null)
+    
+    // Every item name in the world, shared by all games on the same world, for typo correction
+    std::shared_ptr<const SpellingIndex> itemNames;
+    
+    // Scripts attached to item and room events, shared by all games on the same world
+    std::shared_ptr<const ScriptBook> scripts;
+    
+    // Span tracing (see Trace.h): the id spans are tagged with, and whether every command is traced
+    uint64_t traceSession;
+    bool tracing;
+    
+    // Memory accounting: as of the last command and the high-water marks since begin()
+    MemoryUsage memoryUsage;
+    MemoryUsage memoryPeak; // per category
+    size_t memoryPeakTotal;
+    size_t bufferBytes;     // I/O buffers the owner holds for this session
+    
     // Private helper methods
     void initializeRooms();
     void initializeItems();
-    void processCommand(const std::string& command);
+    void initializeCreatures();
+    Room* findRoom(int roomId);
+    CommandStatus processCommand(const std::string& command);
+    CommandStatus dispatchCommand(const std::string& action, const std::string& target);
     void displayHelp();
     void displayInventory();
     void displayRoom();
-    void handleMovement(const std::string& direction);
-    void handleExamine(const std::string& target);
-    void handleTake(const std::string& itemName);
-    void handleUse(const std::string& itemName);
-    void handleDrop(const std::string& itemName);
+    CommandStatus handleMovement(const std::string& direction);
+    CommandStatus handleExamine(const std::string& target);
+    CommandStatus handleTake(const std::string& itemName);
+    CommandStatus handleUse(const std::string& itemName);
+    CommandStatus handleDrop(const std::string& itemName);
+    CommandStatus handleAttack(const std::string& target);
+    void displayLeaderboard();
+    void displayRank();
+    void displayMemoryStats();
+    void noteMemoryUsage();
+    
+    // Typo correction: the closest names within the edit distance allowed
+    // for the word's length (only equally close ones, at most three).
+    // Items must be in the current room and/or the inventory.
+    std::vector<std::string> guessVerb(const std::string& verb) const;
+    std::vector<std::string> guessItem(const std::string& name, bool inRoom, bool inInventory);
+    const std::string& announceGuess(const std::string& guess);
+    void suggestGuesses(const std::vector<std::string>& guesses);
+    
+    // Runs the script for an event, if any; true when it cancelled the event
+    bool runItemScript(ScriptEvent event, const std::string& itemName);
+    bool runEnterScript(int roomId);
+    
+    // ScriptHost
+    bool scriptGetFlag(const std::string& flag) override { return getFlag(flag); }
+    void scriptSetFlag(const std::string& flag, bool value) override { setFlag(flag, value); }
+    int scriptGetHealth() override { return player->getHealth(); }
+    void scriptHeal(int amount) override { player->heal(amount, *output); }
+    void scriptHurt(int amount) override { player->takeDamage(amount, *output); }
+    int scriptGetScore() override { return gameScore; }
+    void scriptAddScore(int points) override { gameScore += points; }
+    int scriptGetRoom() override { return currentRoomId; }
+    int scriptRandom(int bound) override { return bound > 0 ? static_cast<int>(random.below(static_cast<uint32_t>(bound))) : 0; }
+    bool scriptHasItem(const std::string& itemName) override { return player->hasItem(itemName); }
+    void scriptDestroyItem(const std::string& itemName) override;
+    bool scriptIsLocked(int roomId) override;
+    void scriptSetLocked(int roomId, bool locked) override;
+    void scriptSay(const std::string& message) override { *output << message << "\n"; }
+    
+    // Multi-step dialogs, suspended while waiting for the next input line
+    Task readPlayerName(LineChannel& input);
+    Task confirmQuit(LineChannel& input);
     
     // Game logic methods
+    void finishTurn();
+    void finishBatch();
     void checkWinCondition();
     void updateGameState();
     std::string toLowerCase(const std::string& str);
@@ -41,16 +137,66 @@ private:
 
 public:
     Game();
+    Game(const std::string& worldPath, size_t regionBudgetBytes);
     ~Game();
     
+    // Console play: drives play() from std::cin
     void startGame();
-    void gameLoop();
-    void endGame();
+    
+    // Starts a game without the name dialog, for machine clients
+    void begin(const std::string& playerName);
+    
+    // Runs a command line, possibly a chained batch, with the end-of-turn
+    // updates after each step. Stops at the first step that does not succeed;
+    // quit takes effect immediately.
+    CommandStatus executeCommand(const std::string& command, int* stepsExecuted = nullptr);
+    static std::vector<std::string> parseCommandBatch(const std::string& line);
+    
+    // Compact image of everything a turn can change (player, rooms, flags,
+    // creatures), used to reset a used game to a pristine one without
+    // rebuilding the world. In-memory worlds only.
+    std::string saveState();
+    void restoreState(const std::string& state);
+    
+    // Console session coroutines; each line startGame() pushes into input resumes them
+    Task play(LineChannel& input);
+    Task gameLoop(LineChannel& input);
+    void endGame(); // also records the final score
+    
+    // Where all game text is written (std::cout by default)
+    void setOutput(std::ostream& os) { output = &os; }
+    std::ostream& getOutput() const { return *output; }
+    bool isRunning() const { return gameRunning; }
+    void setLeaderboard(Leaderboard* board) { leaderboard = board; }
+    void setAnalytics(Analytics* stats) { analytics = stats; }
+    void setSeed(uint64_t seed, uint64_t stream = 0) { random.reseed(seed, stream); }
+    // Advances the world a fixed number of ticks per command instead of by
+    // real time, so automated play and replays do not depend on the clock
+    void setTicksPerCommand(int ticks) { ticksPerCommand = ticks; }
+    Random& getRandom() { return random; }
+    void setTraceSession(uint64_t id) { traceSession = id; }
+    void setTracing(bool enabled) { tracing = enabled; }
+    uint64_t getTraceSession() const { return traceSession; }
+    bool isTracing() const { return tracing; }
+    
+    // Memory held by this session, by category (see MemoryUsage.h). The
+    // usage is measured after every command; measureMemory() walks it now.
+    MemoryUsage measureMemory() const;
+    const MemoryUsage& getMemoryUsage() const { return memoryUsage; }
+    const MemoryUsage& getMemoryPeak() const { return memoryPeak; }
+    size_t getMemoryPeakTotal() const { return memoryPeakTotal; }
+    void setBufferBytes(size_t bytes) { bufferBytes = bytes; }
     
     // Getters
     Player* getPlayer() const { return player.get(); }
-    Room* getCurrentRoom() const;
+    Room* getCurrentRoom();
+    const Room* peekCurrentRoom() const; // no paging side effects
+    const Room* peekRoom(int roomId) const; // likewise; null when not resident
+    bool isRoomLocked(int roomId) const;    // likewise, also for rooms not resident
+    RegionPager* getRegionPager() const { return regionPager.get(); }
+    WorldSimulation& getSimulation() { return simulation; }
     int getScore() const { return gameScore; }
+    int getCurrentRoomId() const { return currentRoomId; }
     
     // Game flag management
     void setFlag(const std::string& flag, bool value) { gameFlags[flag] = value; }
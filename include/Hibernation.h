@@ -0,0 +1,61 @@
+#ifndef HIBERNATION_H
+#define HIBERNATION_H
+
+#include "Compression.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+// Holds the saved state of idle sessions whose live Game has been freed.
+// States are LZ-compressed against the pristine game image, so a session
+// that changed little shrinks to a few dozen bytes. Blobs stay in memory,
+// or go to a spill file when one is configured. The space of discarded
+// blobs in the spill file is kept in a free list, coalesced and reused
+// best-fit, and the file shrinks when its tail is freed, so it stays about
+// as large as the blobs it holds. A store belongs to one server worker and
+// is not thread-safe.
+class HibernationStore {
+public:
+    struct Ticket {
+        std::string blob;     // in-memory storage
+        int64_t offset = -1;  // spill file storage
+        uint32_t length = 0;
+    };
+
+private:
+    LzDictionary dictionary;
+    int spillFd;
+    uint64_t spillEnd;    // size of the spill file
+    uint64_t diskBytes;   // compressed bytes live in the spill file
+    uint64_t memoryBytes; // compressed bytes held in memory
+    std::map<uint64_t, uint64_t> freeExtents;           // offset -> length, below spillEnd
+    std::set<std::pair<uint64_t, uint64_t>> freeBySize; // length, offset
+    
+    uint64_t allocate(uint64_t length); // an offset in the spill file
+    void release(uint64_t offset, uint64_t length);
+    void addExtent(uint64_t offset, uint64_t length);
+    void removeExtent(std::map<uint64_t, uint64_t>::iterator extent);
+
+public:
+    // An empty spillPath keeps blobs in memory. The spill file is unlinked
+    // as soon as it is open, so it disappears with the process.
+    HibernationStore(const std::string& pristineState, const std::string& spillPath);
+    ~HibernationStore();
+    
+    HibernationStore(const HibernationStore&) = delete;
+    HibernationStore& operator=(const HibernationStore&) = delete;
+    
+    Ticket store(const std::string& state);
+    std::string load(Ticket& ticket); // also releases the ticket's storage
+    void discard(Ticket& ticket);
+    
+    uint64_t getLiveBytes() const { return diskBytes + memoryBytes; }
+    uint64_t getDiskBytes() const { return diskBytes; }
+    uint64_t getMemoryBytes() const { return memoryBytes; }
+    uint64_t getSpillFileBytes() const { return spillEnd; }
+    bool isSpilling() const { return spillFd >= 0; }
+};
+
+#endif // HIBERNATION_H
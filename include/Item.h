@@ -2,6 +2,9 @@
 #define ITEM_H
 
 #include <string>
+#include <memory>
+#include <iostream>
+#include "TextStore.h"
 
 enum class ItemType {
     GENERIC,
@@ -15,7 +18,7 @@ enum class ItemType {
 class Item {
 protected:
     std::string name;
-    std::string description;
+    Text description;
     ItemType type;
     bool canTake;
     bool canUse;
@@ -26,8 +29,9 @@ public:
     virtual ~Item() = default;
     
     // Getters
-    std::string getName() const { return name; }
-    std::string getDescription() const { return description; }
+    const std::string& getName() const { return name; }
+    std::string getDescription() const { return description.str(); }
+    const Text& getDescriptionText() const { return description; }
     ItemType getType() const { return type; }
     bool getCanTake() const { return canTake; }
     bool getCanUse() const { return canUse; }
@@ -37,21 +41,23 @@ public:
     void setCanTake(bool take) { canTake = take; }
     void setCanUse(bool use) { canUse = use; }
     void setValue(int val) { value = val; }
-    void setDescription(const std::string& desc) { description = desc; }
+    void setDescription(Text desc) { description = std::move(desc); }
     
     // Virtual methods for different item behaviors
     virtual std::string use();
-    virtual void examine() const;
+    virtual void examine(std::ostream& os = std::cout) const;
     
     // Utility methods
     std::string getTypeString() const;
+    virtual size_t memoryFootprint() const;
+    size_t textFootprint() const { return name.capacity() + description.memoryFootprint(); }
 };
 
 // Specialized item classes
 class Key : public Item {
 private:
     std::string unlocks; // What this key unlocks
-    
+
 public:
     Key(const std::string& keyName, const std::string& desc, const std::string& unlocksWhat);
     std::string getUnlocks() const { return unlocks; }
@@ -61,7 +67,7 @@ public:
 class Weapon : public Item {
 private:
     int damage;
-    
+
 public:
     Weapon(const std::string& weaponName, const std::string& desc, int dmg);
     int getDamage() const { return damage; }
@@ -71,7 +77,7 @@ public:
 class Consumable : public Item {
 private:
     int healAmount;
-    
+
 public:
     Consumable(const std::string& consumableName, const std::string& desc, int heal);
     int getHealAmount() const { return healAmount; }
@@ -81,7 +87,13 @@ public:
 class Treasure : public Item {
 public:
     Treasure(const std::string& treasureName, const std::string& desc, int worth);
-    void examine() const override;
+    void examine(std::ostream& os = std::cout) const override;
 };
 
+// Item factory used by world files and saved state.
+// param holds what a key unlocks, or the damage, heal amount or worth of the item.
+std::unique_ptr<Item> createItem(ItemType type, const std::string& name, const std::string& desc,
+                                 const std::string& param);
+ItemType parseItemType(const std::string& typeName);
+
 #endif // ITEM_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ScoreEntry {
+    std::string name;
+    int score;
+    uint64_t sequence; // order of submission; earlier games win ties
+};
+
+// Final scores of every recorded game. Sessions submit into one of several
+// sharded buffers so concurrent submitters rarely meet on a lock; buffers
+// are merged into a Fenwick tree of score counts (rank queries in
+// O(log MAX_SCORE)) plus the best TOP_K entries. Merged batches are appended
+// to a compact log file that is replayed on startup.
+class Leaderboard {
+public:
+    static constexpr int MAX_SCORE = 65535; // higher scores are clamped
+    static constexpr size_t TOP_K = 10;
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t FLUSH_THRESHOLD = 64;
+    
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<ScoreEntry> pending;
+    };
+    std::array<Shard, SHARD_COUNT> shards;
+    
+    // Everything below is guarded by mergeMutex
+    mutable std::mutex mergeMutex;
+    std::vector<uint64_t> tree; // Fenwick tree, 1-based, index = score + 1
+    std::vector<ScoreEntry> top; // sorted best first
+    uint64_t totalGames;
+    std::string path;
+    
+    void merge(std::vector<ScoreEntry>& batch);
+    void insert(const ScoreEntry& entry);
+    void insertTop(const ScoreEntry& entry);
+    uint64_t countAtMost(int score) const;
+    void load();
+    void append(const std::vector<ScoreEntry>& batch);
+
+public:
+    // An empty path keeps the leaderboard in memory only
+    explicit Leaderboard(const std::string& filePath = "");
+    ~Leaderboard();
+    
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+    
+    // Thread-safe; the score becomes visible to queries at the next flush
+    void submit(const std::string& name, int score);
+    
+    // Merges every shard's pending scores (queries do this themselves)
+    void flush();
+    
+    // Best entries, at most TOP_K
+    std::vector<ScoreEntry> getTop(size_t count = TOP_K);
+    
+    // 1 + number of recorded games that scored strictly higher
+    uint64_t getRank(int score);
+    uint64_t getTotalGames();
+};
+
+#endif // LEADERBOARD_H
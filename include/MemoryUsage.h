@@ -0,0 +1,42 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+
+// What a session's memory is spent on
+enum class MemoryCategory {
+    WORLD,     // rooms, exits, items lying in rooms, creatures, paged regions
+    INVENTORY, // items the player carries
+    TEXT,      // names and descriptions owned by the session (stored text is shared)
+    FLAGS,     // game flags
+    BUFFERS    // protocol and connection buffers held for the session
+};
+
+constexpr size_t MEMORY_CATEGORY_COUNT = static_cast<size_t>(MemoryCategory::BUFFERS) + 1;
+
+const char* memoryCategoryName(MemoryCategory category);
+
+// Approximate bytes (objects plus the heap they own) by category. These
+// are estimates in the style of Room::memoryFootprint(): container nodes
+// and string capacities are counted, allocator overhead is not.
+struct MemoryUsage {
+    std::array<size_t, MEMORY_CATEGORY_COUNT> bytes{};
+    
+    size_t& operator[](MemoryCategory category) { return bytes[static_cast<size_t>(category)]; }
+    size_t operator[](MemoryCategory category) const { return bytes[static_cast<size_t>(category)]; }
+    size_t total() const;
+    
+    void add(const MemoryUsage& other);
+    void subtract(const MemoryUsage& other);
+    void raiseTo(const MemoryUsage& other); // per category maximum
+    
+    // "world 1234, inventory 56, ..." (bytes per category)
+    void print(std::ostream& os) const;
+};
+
+// std::map and std::set nodes carry three pointers and a color flag on top of the value
+constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+#endif // MEMORY_USAGE_H
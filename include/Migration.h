@@ -0,0 +1,50 @@
+#ifndef MIGRATION_H
+#define MIGRATION_H
+
+#include <cstdint>
+#include <string>
+
+// Control channel between a server, its admin tools and other servers: a
+// Unix SOCK_SEQPACKET socket, so every message arrives whole. A message is
+// either a text command ("drain <control socket>", "stats", "stop"), a
+// text reply, or a session handed over by another server.
+//
+// A session message carries the client connection itself as an SCM_RIGHTS
+// file descriptor, so the client stays connected to the same socket and
+// never notices the move; its compact game state (Game::saveState()) and
+// any bytes still in flight travel in the body:
+//   'S' version, trace session, tracing, state, pending input, unsent output
+// (integers varints, strings length-prefixed).
+struct MigratedSession {
+    std::string state;   // Game::saveState()
+    std::string input;   // received bytes not yet forming a complete request
+    std::string output;  // replies not yet written to the client
+    uint64_t traceSession = 0;
+    bool tracing = false;
+    int fd = -1;         // the client connection
+};
+
+namespace migration {
+    const char SESSION_MESSAGE = 'S';
+    
+    // Largest message accepted; a session with more unsent output stays where it is
+    const size_t MAX_MESSAGE = 1024 * 1024;
+    
+    enum class Receive {
+        MESSAGE,
+        WOULD_BLOCK,
+        CLOSED
+    };
+    
+    // Connects to a control socket; the connection blocks, with timeoutMs on every send and receive
+    int connectControl(const std::string& path, int timeoutMs);
+    
+    // Throw std::runtime_error on failure; passFd (if not -1) travels with the message
+    void sendMessage(int socketFd, const std::string& payload, int passFd = -1);
+    Receive receiveMessage(int socketFd, std::string& payload, int& passedFd);
+    
+    std::string encodeSession(const MigratedSession& session);
+    MigratedSession decodeSession(const std::string& payload, int fd); // throws std::runtime_error
+}
+
+#endif // MIGRATION_H
@@ -0,0 +1,25 @@
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <string>
+#include <streambuf>
+
+// Stream buffer that appends straight into a reusable std::string, so
+// rendering game text into an std::ostream costs no allocation once the
+// string has grown to its working size.
+class OutputBuffer : public std::streambuf {
+private:
+    std::string text;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+public:
+    const std::string& str() const { return text; }
+    bool empty() const { return text.empty(); }
+    void clear() { text.clear(); } // keeps capacity
+    size_t capacity() const { return text.capacity(); }
+};
+
+#endif // OUTPUTBUFFER_H
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <iostream>
 #include "Item.h"
 
 class Player {
@@ -19,26 +20,34 @@ public:
     ~Player();
     
     // Getters
-    std::string getName() const { return name; }
+    const std::string& getName() const { return name; }
     int getHealth() const { return health; }
     int getMaxHealth() const { return maxHealth; }
     int getInventorySize() const { return inventory.size(); }
     int getMaxInventorySize() const { return maxInventorySize; }
+    const std::vector<std::unique_ptr<Item>>& getInventory() const { return inventory; }
+    
+    // Setters (used when a saved state is restored)
+    void setName(const std::string& playerName) { name = playerName; }
+    void setHealth(int value) { health = value < 0 ? 0 : (value > maxHealth ? maxHealth : value); }
     
     // Health management
-    void heal(int amount);
-    void takeDamage(int amount);
+    void heal(int amount, std::ostream& os = std::cout);
+    void takeDamage(int amount, std::ostream& os = std::cout);
     bool isAlive() const { return health > 0; }
     
     // Inventory management
     bool addItem(std::unique_ptr<Item> item);
+    void clearInventory() { inventory.clear(); }
     std::unique_ptr<Item> removeItem(const std::string& itemName);
     Item* findItem(const std::string& itemName) const;
     bool hasItem(const std::string& itemName) const;
-    void displayInventory() const;
+    std::vector<std::string> getItemNames() const;
+    Weapon* getBestWeapon() const;
+    void displayInventory(std::ostream& os = std::cout) const;
     
     // Utility methods
-    void displayStatus() const;
+    void displayStatus(std::ostream& os = std::cout) const;
 };
 
 #endif // PLAYER_H
\ No newline at end of file
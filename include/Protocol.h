@@ -0,0 +1,91 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include "Game.h"
+#include "OutputBuffer.h"
+
+class StateHistory;
+
+// Writes JSON straight into an output buffer: numbers go through
+// std::to_chars and strings are escaped in place, so once the buffer has
+// grown no allocation happens per reply.
+class JsonWriter {
+private:
+    static constexpr int MAX_DEPTH = 8;
+    std::string& out;
+    bool needComma[MAX_DEPTH];
+    int depth;
+    
+    void separator();
+    void writeKey(std::string_view name);
+
+public:
+    explicit JsonWriter(std::string& buffer);
+    
+    void beginObject();
+    void beginObject(std::string_view name);
+    void endObject();
+    void beginArray(std::string_view name);
+    void endArray();
+    
+    void field(std::string_view name, long long value);
+    void field(std::string_view name, int value) { field(name, static_cast<long long>(value)); }
+    void field(std::string_view name, bool value);
+    void field(std::string_view name, std::string_view value);
+    void field(std::string_view name, const char* value) { field(name, std::string_view(value)); }
+    void rawField(std::string_view name, std::string_view json); // value is already JSON
+    void element(std::string_view value);
+    void element(long long value);
+    
+    void string(std::string_view value);
+};
+
+// JSON-lines protocol for machine clients. Each request is one object:
+//   {"id": 7, "cmd": "take seashell", "text": true}
+// and produces exactly one reply line carrying the same id:
+//   {"id":7,"status":"ok","steps":1,"room":1,"health":100,"health_delta":0,
+//    "score":10,"score_delta":10,"running":true,
+//    "room_items":["driftwood"],"inventory":["seashell"],"text":"..."}
+// "id" may be a JSON number, string or null and is echoed back (any other
+// id gets a "bad_request" reply with a null id); "text"
+// asks for the rendered prose; "trace": true (or false) switches span
+// tracing of the session on from this request (see Trace.h); "session":
+// true adds the session number spectators watch it by (see Server.h).
+// "ack": <version> asks for delta mode: in place of the state and its
+// deltas, the reply carries a "version" and only what changed since the
+// acknowledged one, or a keyframe (see StateDelta.h); ack 0 to begin. A chained "cmd" ("n.n.w") runs as one batch
+// that stops at the first failing step; "steps" counts the steps run. Clients may pipeline any number of requests
+// without waiting; replies come back in request order.
+class ProtocolSession {
+private:
+    Game& game;
+    OutputBuffer textBuffer;
+    std::ostream textStream;
+    std::string command; // decoded "cmd", reused between requests
+    std::unique_ptr<StateHistory> history; // from the first delta-mode request
+
+public:
+    explicit ProtocolSession(Game& sessionGame);
+    ~ProtocolSession();
+    
+    // Handles one request line and appends one reply line to out
+    void handleLine(std::string_view line, std::string& out);
+    
+    // The last request's command and the prose it rendered, until the next request
+    const std::string& getCommand() const { return command; }
+    const std::string& getText() const { return textBuffer.str(); }
+    
+    // Appends the structured state of the game (room, health, items...) to an open object
+    static void writeState(JsonWriter& writer, const Game& game);
+};
+
+// Serves the protocol over a pair of streams. Replies are flushed whenever
+// no further request is already buffered, so a burst of pipelined requests
+// costs a single write.
+void runJsonProtocol(Game& game, std::istream& in, std::ostream& out);
+
+#endif // PROTOCOL_H
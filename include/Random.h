@@ -0,0 +1,59 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class ByteWriter;
+class ByteReader;
+
+// Counter-based random numbers (Philox4x32-10, from Salmon et al.,
+// "Parallel Random Numbers: As Easy as 1, 2, 3"). Draw n of a stream is a
+// pure function of (seed, stream, n): ten rounds of multiply-and-xor over
+// the counter. There is no hidden state to share, so every session owns
+// its generator (seeded by the server, stream = session number) and
+// replays identically from its seed and command log; skipping ahead is
+// setting n.
+//
+// Each counter value gives a block of four 32-bit draws. fill() computes
+// eight blocks side by side in plain arrays, which the compiler turns
+// into vector multiplies.
+class Random {
+public:
+    using Block = std::array<uint32_t, 4>;
+    
+    static Block block(uint64_t seed, uint64_t stream, uint64_t blockIndex);
+
+private:
+    uint64_t seed;
+    uint64_t stream;
+    uint64_t position; // draws made
+    Block cached;      // the block holding position, when cachedIndex matches
+    uint64_t cachedIndex;
+
+public:
+    explicit Random(uint64_t seedValue = 0, uint64_t streamId = 0);
+    
+    // Starts the given stream from its first draw
+    void reseed(uint64_t seedValue, uint64_t streamId = 0);
+    
+    uint64_t getSeed() const { return seed; }
+    uint64_t getStream() const { return stream; }
+    uint64_t getPosition() const { return position; }
+    void seek(uint64_t draw) { position = draw; }
+    void skip(uint64_t draws) { position += draws; }
+    
+    uint32_t next();
+    uint32_t below(uint32_t bound); // uniform in [0, bound); 0 when bound is 0
+    double unit();                  // uniform in [0, 1), from two draws
+    
+    // The next count draws, as count calls to next() would return them
+    void fill(uint32_t* out, size_t count);
+    
+    // Seed, stream and position, as varints
+    void save(ByteWriter& writer) const;
+    void load(ByteReader& reader);
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,80 @@
+#ifndef REGIONPAGER_H
+#define REGIONPAGER_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "Room.h"
+#include "WorldFile.h"
+
+// Keeps only the regions around the player resident. Regions are loaded from
+// the world file on demand, neighbouring regions are prefetched through the
+// exits of the current room, and cold regions are evicted in LRU order once
+// the resident size exceeds the memory budget. Modified rooms of an evicted
+// region are written back as a compact blob and re-applied on the next load.
+// While a command runs, evictions are held back, so the rooms it has looked
+// up stay valid even when a script pages in other regions.
+class RegionPager {
+private:
+    struct Region {
+        std::vector<std::unique_ptr<Room>> rooms;
+        size_t bytes;
+    };
+    
+    WorldFile& world;
+    size_t memoryBudget;
+    std::unordered_map<int, Region> resident;
+    std::unordered_map<int, Room*> roomLookup;
+    std::list<int> lru; // front = most recently used region
+    std::unordered_map<int, std::list<int>::iterator> lruPosition;
+    std::unordered_map<int, std::string> writeBack; // region id -> saved room state
+    std::unordered_map<int, bool> savedLocks;       // room id -> locked, for saved rooms
+    int pinnedRegion;
+    size_t residentBytes;
+    int evictionHolds;     // commands in progress
+    bool evictionPending;  // over budget while held
+    
+    // Statistics
+    size_t regionLoads;
+    size_t regionEvictions;
+    size_t writeBackBytes;
+    
+    Region& loadRegion(int regionId);
+    void evictRegion(int regionId);
+    void enforceBudget();
+    void touch(int regionId);
+    std::string saveRegionState(const Region& region) const;
+    void applyRegionState(const std::string& state);
+
+public:
+    RegionPager(WorldFile& worldFile, size_t budgetBytes);
+    ~RegionPager();
+    
+    // Returns the room, loading its region if needed; nullptr if it does not exist
+    Room* getRoom(int roomId);
+    
+    // Returns the room only if it is resident; never loads or evicts
+    Room* peekRoom(int roomId) const;
+    
+    // Whether the room is locked, resident or not; never loads or evicts
+    bool isLocked(int roomId) const;
+    
+    // Pins the region of the player's room and prefetches the regions its exits lead to
+    void enterRoom(int roomId);
+    
+    // Rooms returned between these calls are not evicted before the last release
+    void holdEvictions() { ++evictionHolds; }
+    void releaseEvictions();
+    
+    // Getters
+    size_t getResidentBytes() const { return residentBytes; }
+    size_t getMemoryBudget() const { return memoryBudget; }
+    int getResidentRegionCount() const { return static_cast<int>(resident.size()); }
+    size_t getRegionLoads() const { return regionLoads; }
+    size_t getRegionEvictions() const { return regionEvictions; }
+    size_t getWriteBackBytes() const { return writeBackBytes; }
+};
+
+#endif // REGIONPAGER_H
@@ -5,19 +5,29 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <iostream>
 #include "Item.h"
+#include "TextStore.h"
+#include "MemoryUsage.h"
 
 class Room {
 private:
     int id;
     std::string name;
     std::string description;
-    std::string longDescription;
+    Text longDescription;
     std::map<std::string, int> exits; // direction -> room_id
     std::vector<std::unique_ptr<Item>> items;
     bool visited;
     bool locked;
+    bool modified; // Set when visited/locked/items change, used for write-back
     std::string unlockKey; // Item name required to unlock
+    
+    // Footprints, measured on demand and kept until the room changes
+    mutable size_t cachedFootprint;
+    mutable size_t cachedTextFootprint;
+    mutable bool footprintValid;
+    void measureFootprint() const;
 
 public:
     Room(int roomId, const std::string& roomName, const std::string& desc);
@@ -26,17 +36,22 @@ public:
     
     // Getters
     int getId() const { return id; }
-    std::string getName() const { return name; }
+    const std::string& getName() const { return name; }
     std::string getDescription() const;
     bool isVisited() const { return visited; }
     bool isLocked() const { return locked; }
     std::string getUnlockKey() const { return unlockKey; }
     
+    bool isModified() const { return modified; }
+    const std::vector<std::unique_ptr<Item>>& getItems() const { return items; }
+    
     // Setters
-    void setVisited(bool vis) { visited = vis; }
-    void setLocked(bool lock) { locked = lock; }
-    void setUnlockKey(const std::string& key) { unlockKey = key; }
-    void setLongDescription(const std::string& longDesc) { longDescription = longDesc; }
+    void setVisited(bool vis) { modified = modified || visited != vis; visited = vis; }
+    void setLocked(bool lock) { modified = modified || locked != lock; locked = lock; }
+    void markModified() { modified = true; }
+    void clearModified() { modified = false; }
+    void setUnlockKey(const std::string& key) { unlockKey = key; footprintValid = false; }
+    void setLongDescription(Text longDesc) { longDescription = std::move(longDesc); footprintValid = false; }
     
     // Exit management
     void addExit(const std::string& direction, int roomId);
@@ -47,11 +62,16 @@ public:
     void addItem(std::unique_ptr<Item> item);
     std::unique_ptr<Item> removeItem(const std::string& itemName);
     Item* findItem(const std::string& itemName) const;
-    void displayItems() const;
+    void clearItems();
+    void displayItems(std::ostream& os = std::cout) const;
     
     // Display methods
-    void displayRoom() const;
-    void displayExits() const;
+    void displayRoom(std::ostream& os = std::cout) const;
+    void displayExits(std::ostream& os = std::cout) const;
+    
+    // Approximate heap + object size, used by memory budgets
+    size_t memoryFootprint() const;
+    size_t textFootprint() const; // the part held by names and descriptions, items' included
 };
 
 #endif // ROOM_H
\ No newline at end of file
@@ -0,0 +1,155 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Events content can attach scripts to. use, take and examine scripts
+// belong to an item name; enter scripts belong to a room. A script runs
+// before the game's own handling of the event and can cancel it.
+enum class ScriptEvent {
+    USE,
+    TAKE,
+    ENTER,
+    EXAMINE
+};
+
+bool parseScriptEvent(const std::string& name, ScriptEvent& event);
+
+// The game state a script may read and change
+class ScriptHost {
+public:
+    virtual ~ScriptHost() = default;
+    
+    virtual bool scriptGetFlag(const std::string& flag) = 0;
+    virtual void scriptSetFlag(const std::string& flag, bool value) = 0;
+    virtual int scriptGetHealth() = 0;
+    virtual void scriptHeal(int amount) = 0;
+    virtual void scriptHurt(int amount) = 0;
+    virtual int scriptGetScore() = 0;
+    virtual void scriptAddScore(int points) = 0;
+    virtual int scriptGetRoom() = 0;
+    virtual int scriptRandom(int bound) = 0; // from the session's generator, in [0, bound)
+    virtual bool scriptHasItem(const std::string& itemName) = 0;
+    virtual void scriptDestroyItem(const std::string& itemName) = 0; // from the inventory, else the room
+    virtual bool scriptIsLocked(int roomId) = 0;
+    virtual void scriptSetLocked(int roomId, bool locked) = 0;
+    virtual void scriptSay(const std::string& message) = 0;
+};
+
+enum class ScriptResult {
+    FINISHED,
+    CANCELLED,    // the game skips its own handling of the event
+    OUT_OF_BUDGET // stopped after its instruction budget; treated as finished
+};
+
+// A compiled script. Source is a list of statements separated by ';':
+//   say <text>                    set <flag>        clear <flag>
+//   heal <expr>   hurt <expr>     score <expr>      (adds points)
+//   lock <expr>   unlock <expr>   (room ids)        destroy <item name>
+//   consume       (removes the item the event is about)
+//   cancel        stop            budget <n>        (instructions per run)
+//   if <condition> ... [else ...] end              repeat <expr> ... end
+// repeat runs its body <expr> times, not at all when that is zero or less.
+// Expressions add and subtract integers (saturating at the int32 range),
+// health, score, room (the current room id) and random <value> (0 up to value - 1, drawn from the
+// session's seeded generator so a replay gives the same rolls). Conditions are flag <flag>, has <item name>,
+// locked <expr> or two expressions compared with < <= > >= == !=, each
+// optionally preceded by not.
+//
+// Statements compile to a register machine. The interpreter uses direct
+// threading where the compiler supports it (each instruction holds the
+// address of its handler), and every run stops after the script's
+// instruction budget so no content can stall a session.
+class Script {
+public:
+    static constexpr uint32_t DEFAULT_BUDGET = 1000;
+    static constexpr int REGISTER_COUNT = 16;
+    
+    enum class Opcode : uint8_t {
+        LOAD_CONST,   // r[a] = operand
+        LOAD_HEALTH,  // r[a] = health
+        LOAD_SCORE,   // r[a] = score
+        LOAD_ROOM,    // r[a] = current room id
+        RANDOM,       // r[a] = random in [0, r[b])
+        ADD,          // r[a] = r[b] + r[c], clamped to the int32 range
+        SUBTRACT,     // r[a] = r[b] - r[c], likewise
+        LESS,         // r[a] = r[b] < r[c]
+        LESS_EQUAL,   // r[a] = r[b] <= r[c]
+        EQUAL,        // r[a] = r[b] == r[c]
+        NOT_EQUAL,    // r[a] = r[b] != r[c]
+        NOT,          // r[a] = !r[b]
+        GET_FLAG,     // r[a] = flag strings[operand]
+        HAS_ITEM,     // r[a] = carrying strings[operand]
+        IS_LOCKED,    // r[a] = room r[b] is locked
+        JUMP,         // continue at operand
+        JUMP_IF_ZERO, // continue at operand if r[a] == 0
+        JUMP_IF_NOT_POSITIVE, // continue at operand if r[a] <= 0
+        DECREMENT,    // --r[a]
+        SET_FLAG,     // flag strings[operand] = a
+        HEAL,         // heal r[a]
+        HURT,         // damage r[a]
+        ADD_SCORE,    // score += r[a]
+        SET_LOCKED,   // room r[a] locked = b
+        DESTROY,      // remove item strings[operand]
+        CONSUME,      // remove the event's item
+        SAY,          // print strings[operand]
+        CANCEL,       // end, cancelling the event
+        HALT,         // end
+        OPCODE_COUNT
+    };
+    
+    struct Instruction {
+        const void* handler; // interpreter label for op, when threaded
+        Opcode op;
+        uint8_t a;
+        uint8_t b;
+        uint8_t c;
+        int32_t operand;
+    };
+
+private:
+    std::vector<Instruction> code;
+    std::vector<std::string> strings;
+    uint32_t budget;
+    
+    friend class ScriptCompiler;
+    Script() : budget(DEFAULT_BUDGET) {}
+    void link();
+
+public:
+    // Throws std::runtime_error describing the first error in the source
+    static Script compile(std::string_view source);
+    
+    // subject is the item the event is about (empty for enter)
+    ScriptResult run(ScriptHost& host, const std::string& subject) const;
+    
+    size_t getInstructionCount() const { return code.size(); }
+    uint32_t getBudget() const { return budget; }
+};
+
+// The scripts of one world, compiled when it is loaded and shared
+// read-only by every game on that world
+class ScriptBook {
+private:
+    std::unordered_map<std::string, Script> itemScripts[3]; // use, take, examine by item name
+    std::map<int, Script> enterScripts;                     // by room id
+    
+    static size_t itemSlot(ScriptEvent event);
+
+public:
+    // Replaces any earlier script for the same event and target
+    void addItemScript(ScriptEvent event, const std::string& itemName, Script script);
+    void addEnterScript(int roomId, Script script);
+    
+    const Script* findItemScript(ScriptEvent event, const std::string& itemName) const;
+    const Script* findEnterScript(int roomId) const;
+    bool empty() const;
+};
+
+#endif // SCRIPT_H
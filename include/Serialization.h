@@ -0,0 +1,48 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "Item.h"
+
+// Compact binary encoding for state that has to leave its live objects
+// (evicted world regions, saved sessions). Integers are LEB128 varints.
+class ByteWriter {
+private:
+    std::string& buffer;
+
+public:
+    explicit ByteWriter(std::string& out) : buffer(out) {}
+    
+    void writeByte(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void writeVarint(uint64_t value);
+    void writeInt(int64_t value); // zigzag encoded
+    void writeString(const std::string& str);
+};
+
+class ByteReader {
+private:
+    const std::string& buffer;
+    size_t pos;
+
+public:
+    explicit ByteReader(const std::string& in) : buffer(in), pos(0) {}
+    
+    uint8_t readByte();
+    uint64_t readVarint();
+    int64_t readInt();
+    std::string readString();
+    bool atEnd() const { return pos >= buffer.size(); }
+    size_t position() const { return pos; }
+};
+
+// Items are written with their type, flags and type-specific parameter.
+// Given the TextStore the items were loaded from, descriptions held in it
+// are written as their id and read back as references into the store
+// (only for data that stays in this process); others are written inline.
+void writeItem(ByteWriter& writer, const Item& item, const TextStore* store = nullptr);
+std::unique_ptr<Item> readItem(ByteReader& reader, const std::shared_ptr<const TextStore>& store = nullptr);
+
+#endif // SERIALIZATION_H
@@ -0,0 +1,141 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "SessionPool.h"
+#include "Leaderboard.h"
+#include "Analytics.h"
+
+class ServerWorker;
+
+// Serves the JSON-lines protocol (see Protocol.h) to many clients over a
+// Unix domain socket. Each connection is its own game taken from a
+// SessionPool; it is closed once that game ends. Every worker runs an
+// epoll loop over the connections it accepted, so a session is only ever
+// touched by one thread.
+//
+// With hibernation on, a session idle for longer than the threshold is
+// saved to a compressed state blob (see Hibernation.h) and its Game goes
+// back to the pool; the next request from that client restores it first.
+// A session that cannot be restored (its spill file cannot be read back)
+// gets a {"id":null,"status":"session_lost"} line and is disconnected.
+//
+// With a control socket (see Migration.h), admin tools can ask for stats,
+// stop the server, or drain it: every worker freezes its sessions between
+// requests and hands them, client connection included, to another server's
+// control socket, all workers in parallel. A drained server keeps
+// accepting on its own socket but hands each new client over at once.
+//
+// With a spectator socket, anyone can watch a live session read-only:
+// they send its number (a request with "session": true reveals it) and
+// receive each command and the prose it rendered as the player sees it.
+// The number includes a random id of the server that started the session
+// and stays with it when it is drained, so it names one session across
+// all servers and is also the session's random stream.
+// Output is rendered once and shared by all of a session's spectators;
+// slow ones skip ahead or are dropped (see Spectator.h). A session's
+// spectators are served by its worker and let go when it ends or moves.
+//
+// printStats() also reports the memory of the awake sessions by category
+// (see MemoryUsage.h), with the process and per-session high-water marks.
+class GameServer {
+private:
+    std::string socketPath;
+    int listenFd;
+    SessionPool& pool;
+    Leaderboard* leaderboard;
+    Analytics* analytics;
+    std::vector<std::unique_ptr<ServerWorker>> workers;
+    std::atomic<bool> stopping;
+    std::atomic<bool> statsRequested;
+    
+    // Idle-session hibernation; zero disables it
+    std::chrono::steady_clock::duration hibernateAfter;
+    std::string spillPath;
+    
+    // Where SIGUSR1 also writes the span trace (see Trace.h); empty for none
+    std::string traceFile;
+    
+    // Sessions draw random numbers from stream <session number> under this seed
+    uint64_t seed;
+    
+    // Random per process, so a session keeps a number no other server
+    // uses when it is drained: server id * 2^32 + guest number
+    static constexpr uint32_t SERVER_IDS = (1u << 20) - 1; // numbers stay below 2^52, exact in JSON
+    uint32_t serverId;
+    uint64_t sessionNumber(int guest) const { return (static_cast<uint64_t>(serverId) << 32) | static_cast<uint32_t>(guest); }
+    
+    // Summed over workers
+    std::atomic<uint64_t> hibernations;
+    std::atomic<uint64_t> rehydrations;
+    std::atomic<uint64_t> rehydrateNanosTotal;
+    std::atomic<uint64_t> rehydrateNanosMax;
+    std::atomic<uint64_t> memoryHighWater; // of awake sessions, all workers together
+    
+    // Control socket; -1 without one
+    std::string controlPath;
+    int controlFd;
+    
+    // Drains: the worker taking the request publishes the target and wakes
+    // the others; the last to finish wakes it again to send the reply
+    std::mutex drainMutex;
+    std::string drainTarget;
+    std::chrono::steady_clock::time_point drainStart;
+    std::atomic<uint64_t> drainGeneration;
+    std::atomic<int> drainPending;
+    std::atomic<bool> drainRunning;
+    std::atomic<uint64_t> drainMigrated;
+    std::atomic<uint64_t> drainFailed;
+    std::atomic<uint64_t> drainPauseMax; // longest handover of one session, nanoseconds
+    std::atomic<uint64_t> migratedOut;
+    std::atomic<uint64_t> migratedIn;
+    
+    // Spectator socket; -1 without one. Sessions register the worker that
+    // serves them, so a spectator accepted by any worker reaches its session
+    std::string spectatePath;
+    int spectateFd;
+    std::mutex sessionsMutex;
+    std::unordered_map<uint64_t, int> sessionWorkers; // session number -> worker index
+    std::atomic<uint64_t> spectatorCount;
+    std::atomic<uint64_t> spectatorsDropped; // for falling too far behind
+    std::atomic<uint64_t> spectatorSkips;    // responses skipped by slow spectators
+    
+    friend class ServerWorker;
+
+public:
+    GameServer(const std::string& path, SessionPool& sessionPool,
+               Leaderboard* board = nullptr, Analytics* stats = nullptr);
+    ~GameServer();
+    
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+    
+    // Serves until stop() is called; workerCount 0 means one per core
+    void run(int workerCount = 0);
+    
+    // Call before run(). Each worker spills to spillFilePrefix.<n> when a
+    // prefix is given and keeps blobs in memory otherwise.
+    void setHibernation(double idleSeconds, const std::string& spillFilePrefix = "");
+    void setTraceFile(const std::string& path) { traceFile = path; }
+    void setSeed(uint64_t value) { seed = value; } // before run()
+    uint32_t getServerId() const { return serverId; }
+    void setControlSocket(const std::string& path); // before run()
+    void setSpectatorSocket(const std::string& path); // before run()
+    
+    // Safe to call from a signal handler's thread or any other thread
+    void stop() { stopping = true; }
+    void requestStats() { statsRequested = true; } // printed to std::cerr by a worker, with the trace export
+    
+    size_t getConnectionCount() const;
+    void printStats(std::ostream& os) const;
+};
+
+#endif // SERVER_H
@@ -0,0 +1,46 @@
+#ifndef SESSION_POOL_H
+#define SESSION_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Game.h"
+
+// Keeps finished games around so a new session does not pay for building
+// the world again. A returned game is reset by decoding the pristine state
+// image captured from a freshly built game, which only touches the few
+// things a playthrough can change (O(items), not O(world)).
+class SessionPool {
+private:
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Game>> idle;
+    std::string pristineState;
+    size_t maxIdle;
+    
+    // Statistics
+    size_t gamesBuilt;
+    size_t gamesReused;
+
+public:
+    // Builds `prewarm` games up front; at most `maxIdle` are kept idle
+    explicit SessionPool(size_t prewarm = 0, size_t maxIdle = 256);
+    
+    // A game in its initial state, not yet begun, writing to std::cout
+    std::unique_ptr<Game> acquire();
+    
+    // A game restored from a saved state image instead
+    std::unique_ptr<Game> acquire(const std::string& state);
+    
+    // Returns a game for reuse; it is reset on its next acquire()
+    void release(std::unique_ptr<Game> game);
+    
+    // Statistics
+    size_t getIdleCount() const;
+    size_t getGamesBuilt() const;
+    size_t getGamesReused() const;
+    size_t getStateSize() const { return pristineState.size(); }
+    const std::string& getPristineState() const { return pristineState; }
+};
+
+#endif // SESSION_POOL_H
@@ -0,0 +1,60 @@
+#ifndef SHAREDWORLD_H
+#define SHAREDWORLD_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include "Room.h"
+#include "WorldFile.h"
+
+class Actor;
+class RoomActor;
+class PlayerActor;
+class ActorWorker;
+
+// One world shared by many players. Every room and every player is an actor
+// that owns its state and processes its mailbox on a single worker thread.
+// Taking, dropping and moving are messages between actors, so items change
+// hands without any global lock: an item is always owned by exactly one
+// room, one player or one message in flight.
+class SharedWorld {
+private:
+    std::map<int, std::unique_ptr<RoomActor>> roomActors; // fixed after construction
+    std::vector<std::unique_ptr<ActorWorker>> workers;
+    std::list<std::unique_ptr<PlayerActor>> players;
+    std::mutex playersMutex; // guards joins only, never message delivery
+    int startRoomId;
+    int nextPlayerId;
+    
+    void startWorkers(int workerCount);
+
+public:
+    using OutputHandler = std::function<void(const std::string&)>;
+    
+    SharedWorld(WorldFile& world, int workerCount = 0);
+    ~SharedWorld();
+    
+    // Adds a player in the start room; output receives every reply, on a worker thread
+    PlayerActor* addPlayer(const std::string& name, OutputHandler output);
+    
+    // Queues a command line (go/n/s/e/w/u/d, take, drop, look, inventory) for a player
+    void submit(PlayerActor* player, const std::string& command);
+    
+    // Blocks until every mailbox is drained. Callers must stop submitting first.
+    void waitForQuiescence() const;
+    
+    // Counts every item by name across rooms and inventories; call after waitForQuiescence()
+    std::map<std::string, int> countItems() const;
+    
+    int getWorkerCount() const { return static_cast<int>(workers.size()); }
+    int getRoomCount() const { return static_cast<int>(roomActors.size()); }
+    RoomActor* findRoomActor(int roomId) const;
+    ActorWorker& workerFor(int actorId) const;
+};
+
+#endif // SHAREDWORLD_H
@@ -0,0 +1,126 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+class ByteWriter;
+class ByteReader;
+
+// Archetype shared by every creature of one kind
+struct CreatureSpecies {
+    std::string name;
+    int maxHealth;
+    int damage;       // damage per attack
+    int attackPeriod; // ticks between attacks
+    int aggression;   // 0-255; at HOSTILE_AGGRESSION or above the creature attacks on sight
+};
+
+// Environmental hazard such as falling rocks, hurting everyone in its room
+struct HazardKind {
+    std::string name;
+    std::string message;
+    int damage;
+    int period; // ticks between strikes
+};
+
+// What the player experienced while the world advanced
+struct TickReport {
+    int damageToPlayer = 0;
+    std::vector<std::string> messages;
+};
+
+// Fixed-rate simulation of creatures and hazards. Entities are stored as
+// structure-of-arrays columns sorted by room, so every room owns a
+// contiguous range that is advanced with branch-free loops. Rooms holding a
+// player are advanced every tick; all other rooms are caught up lazily, in
+// one closed-form pass, the next time a player enters them or when
+// settleAll() sweeps the whole store.
+class WorldSimulation {
+public:
+    static constexpr int TICKS_PER_SECOND = 10;
+    static constexpr int HOSTILE_AGGRESSION = 128;
+    static constexpr int REGEN_PERIOD = 50; // ticks per point of creature health regained
+
+private:
+    struct RoomEntities {
+        uint32_t creatureBegin = 0, creatureEnd = 0;
+        uint32_t hazardBegin = 0, hazardEnd = 0;
+        uint64_t lastTick = 0;
+        bool occupied = false;
+    };
+    
+    std::vector<CreatureSpecies> species;
+    std::vector<HazardKind> hazardKinds;
+    
+    // Creature columns
+    std::vector<int32_t> creatureRoom;
+    std::vector<int32_t> creatureSpecies;
+    std::vector<int32_t> creatureHealth;
+    std::vector<int32_t> creatureMaxHealth;
+    std::vector<int32_t> creatureAggression;
+    std::vector<int32_t> creatureDamage;
+    std::vector<int32_t> creaturePeriod;
+    std::vector<int32_t> creatureTimer;
+    
+    // Hazard columns
+    std::vector<int32_t> hazardRoom;
+    std::vector<int32_t> hazardKind;
+    std::vector<int32_t> hazardDamage;
+    std::vector<int32_t> hazardPeriod;
+    std::vector<int32_t> hazardTimer;
+    
+    std::unordered_map<int, RoomEntities> rooms;
+    std::vector<int> occupiedRooms;
+    std::vector<int32_t> firedScratch;
+    uint64_t currentTick;
+    bool indexDirty;
+    
+    void rebuildIndex();
+    void simulateRoom(RoomEntities& room, TickReport* report); // report is null for rooms without players
+    RoomEntities* roomEntities(int roomId);
+
+public:
+    WorldSimulation();
+    
+    // Content
+    int addSpecies(const CreatureSpecies& creature);
+    int addHazardKind(const HazardKind& hazard);
+    void spawnCreature(int speciesId, int roomId);
+    void spawnHazard(int kindId, int roomId);
+    
+    // Occupied rooms are simulated every tick; entering one first catches it up
+    void setRoomOccupied(int roomId, bool occupied);
+    
+    // Advances the clock; only occupied rooms do work now
+    TickReport advance(int ticks);
+    
+    // Brings every unoccupied room up to the current tick in one sweep
+    void settleAll();
+    
+    // Combat: returns the creature index or -1, and the creature's remaining health
+    int findCreature(int roomId, const std::string& name);
+    int damageCreature(int creatureIndex, int amount);
+    std::string getCreatureName(int creatureIndex) const;
+    std::vector<int> livingCreatures(int roomId); // creature indices
+    
+    // Lines describing the living creatures and hazards of a room
+    std::vector<std::string> describeRoom(int roomId);
+    
+    // Mutable entity state (health, aggression, timers, clock) for session
+    // snapshots; restoring requires the same content to have been spawned
+    void saveState(ByteWriter& writer);
+    void restoreState(ByteReader& reader);
+    
+    // Getters
+    uint64_t getCurrentTick() const { return currentTick; }
+    size_t getCreatureCount() const { return creatureRoom.size(); }
+    size_t getHazardCount() const { return hazardRoom.size(); }
+    
+    // Approximate heap + object size of the entity store
+    size_t memoryFootprint() const;
+};
+
+#endif // SIMULATION_H
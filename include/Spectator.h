@@ -0,0 +1,52 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+// One command's rendered output, built once per command and shared by
+// every spectator of the session; a spectator holds a reference until the
+// last byte is written, so nothing is copied per spectator.
+using OutputChunk = std::shared_ptr<const std::string>;
+
+// The unsent output of one read-only spectator connection (see Server.h).
+// Chunks go out with a single gathering send straight from the shared
+// buffers. A spectator never slows the session it watches: when its
+// backlog would pass MAX_BACKLOG, the queued responses it has not started
+// are dropped and it skips ahead to the newest one, with a note of how
+// many it missed. One that has not taken a byte since it last skipped
+// ahead is not keeping up at all, and push() asks for it to be dropped.
+class SpectatorQueue {
+public:
+    static constexpr size_t MAX_BACKLOG = 256 * 1024;
+    
+    enum class Send {
+        DONE,    // everything queued is written
+        BLOCKED, // the socket is full; wait until it is writable
+        FAILED   // the spectator went away
+    };
+
+private:
+    int fd;
+    std::deque<OutputChunk> chunks;
+    size_t frontSent;     // bytes of the first chunk already written
+    size_t queuedBytes;   // unsent bytes
+    uint64_t skipped;     // responses dropped so far
+    bool progressed;      // bytes were written since the last skip
+
+public:
+    explicit SpectatorQueue(int socketFd);
+    
+    // Queues a chunk, skipping ahead if the backlog is full; false when the spectator should be dropped
+    bool push(const OutputChunk& chunk);
+    Send send();
+    
+    int getFd() const { return fd; }
+    bool empty() const { return chunks.empty(); }
+    size_t getQueuedBytes() const { return queuedBytes; }
+    uint64_t getSkipped() const { return skipped; }
+};
+
+#endif // SPECTATOR_H
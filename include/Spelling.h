@@ -0,0 +1,58 @@
+#ifndef SPELLING_H
+#define SPELLING_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Typo correction by symmetric deletes (SymSpell). Every word is indexed
+// under each string left by deleting up to MAX_DISTANCE of its characters.
+// A misspelling within that distance shares at least one such delete with
+// the word, so a lookup generates only the input's own deletes and checks
+// the few words filed under them. Deletes are taken from the first
+// PREFIX_LENGTH characters only, so the cost of a lookup is bounded and
+// does not depend on the size of the vocabulary.
+class SpellingIndex {
+public:
+    static constexpr int MAX_DISTANCE = 2;
+    static constexpr size_t PREFIX_LENGTH = 10;
+    static constexpr size_t MAX_WORD_LENGTH = 48; // longer words are kept but never suggested
+    
+    struct Match {
+        std::string_view word;
+        int distance; // edits, counting a swap of neighbouring letters as one
+    };
+
+private:
+    // Open-addressed table from the hash of a delete to the words under it.
+    // Most deletes belong to a single word, which is stored inline, so a
+    // probe usually touches one cache line.
+    struct Bucket {
+        uint64_t hash; // 0 = empty
+        uint32_t count;
+        uint32_t value; // the word id when count == 1, else an index into overflow
+    };
+    std::vector<Bucket> buckets;
+    std::vector<std::vector<uint32_t>> overflow;
+    size_t usedBuckets = 0;
+    
+    std::deque<std::string> words; // stable storage for the views below
+    std::vector<uint8_t> lengths; // by id, capped at 255, to skip candidates before comparing
+    std::unordered_map<std::string_view, uint32_t> ids;
+    
+    void insert(uint64_t hash, uint32_t id);
+    void grow();
+
+public:
+    void add(std::string_view word); // repeated words are indexed once
+    
+    // Words within maxDistance of input, nearest first (ties in the order they were added)
+    std::vector<Match> lookup(std::string_view input, int maxDistance = MAX_DISTANCE) const;
+    
+    size_t size() const { return words.size(); }
+};
+
+#endif // SPELLING_H
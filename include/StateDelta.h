@@ -0,0 +1,60 @@
+#ifndef STATE_DELTA_H
+#define STATE_DELTA_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Protocol.h"
+
+// What a graphical client draws of a session, captured after a command
+struct StateSnapshot {
+    uint64_t version = 0;
+    int room = 0;
+    int health = 0;
+    int score = 0;
+    bool running = true;
+    std::vector<std::string> roomItems;
+    std::vector<std::string> inventory;
+    std::vector<std::string> exits;       // directions out of the room
+    std::vector<std::string> lockedExits; // those into a locked room
+    
+    void capture(const Game& game); // reuses the lists' storage
+    size_t memoryFootprint() const;
+};
+
+// Versioned state updates for the JSON protocol's delta mode (see
+// Protocol.h). Every reply captures a new version and sends only what
+// changed since the version the client acknowledges, e.g.
+//   "version":42,"base":40,"health":85,"inventory_added":["machete"]
+// ("base", the acknowledged version, is left out when it is version - 1).
+// Item and exit lists change by "_added"/"_removed" (and exits by
+// "_unlocked"/"_locked"), scalars only appear when they changed, and a
+// new room sends its lists whole. A keyframe ("keyframe":true) carries
+// everything; it is sent when the acknowledged version is no longer held
+// and every KEYFRAME_INTERVAL versions, so a client can always resync.
+//
+// Versions begin at the monotonic clock's microseconds when the history
+// is created, so a session rebuilt after hibernation or migration never
+// reuses a version an older client could still acknowledge.
+class StateHistory {
+public:
+    static constexpr size_t KEPT = 16; // versions a client can acknowledge
+    static constexpr uint64_t KEYFRAME_INTERVAL = 64;
+
+private:
+    std::array<StateSnapshot, KEPT> snapshots; // version v at v % KEPT
+    uint64_t latest;       // newest version; none yet when 0
+    uint64_t lastKeyframe;
+
+public:
+    StateHistory();
+    
+    // Captures the game as a new version and writes its update against
+    // acked (0: the client has none) into an open reply object
+    void writeUpdate(JsonWriter& writer, const Game& game, uint64_t acked);
+    
+    size_t memoryFootprint() const;
+};
+
+#endif // STATE_DELTA_H
@@ -0,0 +1,96 @@
+#ifndef TEXTSTORE_H
+#define TEXTSTORE_H
+
+#include "Compression.h"
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct TextStoreStats {
+    size_t texts = 0;             // distinct texts stored
+    uint64_t rawBytes = 0;        // their uncompressed size
+    uint64_t compressedBytes = 0; // their compressed size
+    uint64_t dictionaryBytes = 0;
+    uint64_t views = 0;           // get() calls
+    uint64_t cacheHits = 0;
+    uint64_t decompressNanos = 0; // spent on cache misses
+    uint64_t cachedBytes = 0;
+};
+
+// Descriptions of a large world, stored compressed against one dictionary
+// trained on the world's own text (recurring phrases), so each text keeps
+// only what is unusual about it. Identical texts are stored once. A small
+// LRU cache keeps recently viewed texts decompressed. Thread-safe.
+class TextStore {
+private:
+    struct Entry {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t rawLength;
+    };
+    
+    struct CachedText {
+        std::shared_ptr<const std::string> text;
+        std::list<uint32_t>::iterator lruPosition;
+    };
+    
+    LzDictionary dictionary;
+    size_t cacheCapacity; // bytes of decompressed text
+    
+    mutable std::mutex mutex;
+    std::string arena; // compressed texts back to back
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> byHash; // of the compressed bytes
+    mutable std::unordered_map<uint32_t, CachedText> cache;
+    mutable std::list<uint32_t> lru; // most recently viewed first
+    mutable TextStoreStats stats;
+
+public:
+    static constexpr size_t DEFAULT_DICTIONARY_BYTES = 32 * 1024;
+    static constexpr size_t DEFAULT_CACHE_BYTES = 256 * 1024;
+    
+    // Builds a dictionary from the phrases (runs of words) that save the most bytes across the samples
+    static std::string trainDictionary(const std::vector<std::string>& samples,
+                                       size_t maxBytes = DEFAULT_DICTIONARY_BYTES);
+    
+    explicit TextStore(std::string trainedDictionary, size_t cacheBytes = DEFAULT_CACHE_BYTES);
+    
+    uint32_t add(std::string_view text);
+    std::shared_ptr<const std::string> get(uint32_t id) const;
+    
+    TextStoreStats getStats() const;
+};
+
+// A piece of descriptive text: either held directly, or a reference into a
+// shared TextStore that is decompressed when the text is shown.
+class Text {
+private:
+    std::string plain;
+    std::shared_ptr<const TextStore> store;
+    uint32_t id;
+
+public:
+    Text() : id(0) {}
+    Text(const std::string& text) : plain(text), id(0) {}
+    Text(const char* text) : plain(text), id(0) {}
+    Text(std::shared_ptr<const TextStore> textStore, uint32_t textId) : store(std::move(textStore)), id(textId) {}
+    
+    std::string str() const;
+    bool empty() const;
+    bool isStored() const { return store != nullptr; }
+    const TextStore* getStore() const { return store.get(); }
+    uint32_t getId() const { return id; } // within getStore()
+    
+    // Heap bytes owned by this object; stored text is accounted by its TextStore
+    size_t memoryFootprint() const { return plain.capacity(); }
+    
+    friend std::ostream& operator<<(std::ostream& os, const Text& text);
+};
+
+#endif // TEXTSTORE_H
@@ -0,0 +1,105 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Scoped timing spans over the command pipeline, exported in the Chrome
+// trace-event format (open the file in Perfetto or chrome://tracing).
+//
+// Spans are only recorded inside an active TraceScope: one is opened per
+// command (or per burst of requests on the server) and is active when the
+// session asked for tracing or the command was picked by the sampling
+// rate. Outside of one, a TraceSpan costs a thread-local load and a branch.
+//
+// Each thread records into its own ring of RING_SIZE spans, overwriting the
+// oldest; the ring has a single writer and needs no locks. Rings outlive
+// their threads so an export after shutdown still sees every worker.
+class Tracer {
+public:
+    static constexpr size_t RING_SIZE = 1 << 14; // spans kept per thread
+    
+    // Fraction of commands traced in sessions that did not ask for it (0 disables sampling)
+    static void setSampleRate(double rate);
+    
+    // Writes every span still held in the rings; safe while threads record
+    static void exportJson(std::ostream& os);
+    static void exportFile(const std::string& path); // throws std::runtime_error
+    
+    // Nanoseconds since the first call in this process
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+private:
+    friend class TraceScope;
+    friend class TraceSpan;
+    
+    static const std::chrono::steady_clock::time_point epoch;
+    static std::atomic<uint32_t> sampleThreshold; // of 2^32; 0 never samples
+    
+    // Per thread: the session being traced (0 when not tracing) and whether a scope is open
+    static inline thread_local uint64_t activeSession = 0;
+    static inline thread_local bool inScope = false;
+    
+    static bool sampled();
+    static void prepareThread(); // sets up the thread's ring before any span is timed
+    static void record(const char* name, uint64_t start, uint64_t end);
+};
+
+// Decides whether one command (or request burst) is traced. Scopes do not
+// nest: an inner scope keeps the outer decision, so a command is sampled once.
+class TraceScope {
+private:
+    bool owner;
+
+public:
+    TraceScope(uint64_t session, bool sessionTracing) : owner(!Tracer::inScope) {
+        if (owner) {
+            Tracer::inScope = true;
+            if (sessionTracing || (Tracer::sampleThreshold.load(std::memory_order_relaxed) && Tracer::sampled())) {
+                Tracer::activeSession = session;
+                Tracer::prepareThread();
+            }
+        }
+    }
+    ~TraceScope() {
+        if (owner) {
+            Tracer::inScope = false;
+            Tracer::activeSession = 0;
+        }
+    }
+    
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+// Times the enclosing block under name, which must be a string literal
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t start;
+
+public:
+    explicit TraceSpan(const char* spanName) : name(spanName), start(0) {
+        if (Tracer::activeSession != 0) {
+            start = Tracer::now();
+        } else {
+            name = nullptr;
+        }
+    }
+    ~TraceSpan() {
+        if (name) {
+            Tracer::record(name, start, Tracer::now());
+        }
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,92 @@
+#ifndef WORLD_ANALYZER_H
+#define WORLD_ANALYZER_H
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Checks the structure of a world file before it is deployed, without
+// loading it as a game (see WorldFile.h for the format). Exits are
+// resolved to rooms, then:
+//   - rooms no path of exits reaches from the start room are unreachable;
+//   - a walk from the start room that opens a lock only once its key can
+//     be picked up, as Game::move requires, finds locks whose key is
+//     missing or lies behind the doors it opens, and the rooms they seal;
+//   - searching forward and backward from the start room gives its
+//     strongly connected component; the reachable rooms outside it are
+//     one-way, and their components with no exit out are dead ends.
+// Scripts that lock or unlock rooms are not modelled.
+//
+// The file is mapped and parsed in slices, one per thread, and the
+// searches go level by level with large levels split among the threads,
+// so a world of millions of rooms is checked in seconds.
+class WorldAnalyzer {
+public:
+    enum class Problem {
+        DUPLICATE_ROOM,  // a room id defined again
+        MISSING_ROOM,    // an exit to a room id that does not exist
+        UNREACHABLE,     // no exits lead there from the start room
+        MISSING_KEY,     // locked with an item no room holds as takeable
+        KEY_BEHIND_DOOR, // every such item lies beyond locks that cannot be opened first
+        LOCKED_OUT,      // reachable only through such locks
+        DEAD_END,        // rooms that can be entered but never left (a warning)
+        PROBLEM_COUNT
+    };
+    static constexpr size_t PROBLEM_COUNT = static_cast<size_t>(Problem::PROBLEM_COUNT);
+    static constexpr size_t EXAMPLES_PER_PROBLEM = 10;
+    
+    struct Finding {
+        Problem problem;
+        int roomId;
+        int otherId;     // missing exit target, key location or dead end size
+        std::string key; // lock problems
+    };
+    
+    // When a lock's key first becomes available on the walk from the start room
+    struct KeyPickup {
+        std::string key;
+        int roomId;
+        size_t moves;
+    };
+
+private:
+    std::string path;
+    unsigned threadCount;
+    size_t roomCount;
+    size_t exitCount;
+    size_t lockedCount;
+    int startRoomId;
+    size_t reachableCount;      // following exits, all locks open
+    size_t openableCount;       // opening locks in key order
+    size_t startComponentSize;  // rooms reachable from the start room and back
+    size_t oneWayCount;         // reachable rooms with no way back
+    double seconds;
+    std::array<size_t, PROBLEM_COUNT> counts;
+    std::vector<Finding> findings; // the first EXAMPLES_PER_PROBLEM of each, in file order
+    std::vector<KeyPickup> keyOrder; // the first few, in pickup order
+    
+    void analyze();
+
+public:
+    // Parses and checks the file; threads 0 uses every core.
+    // Throws std::runtime_error if the file cannot be read or parsed
+    explicit WorldAnalyzer(const std::string& worldPath, unsigned threads = 0);
+    
+    size_t count(Problem problem) const { return counts[static_cast<size_t>(problem)]; }
+    const std::vector<Finding>& getFindings() const { return findings; }
+    const std::vector<KeyPickup>& getKeyOrder() const { return keyOrder; }
+    bool hasErrors() const; // any problem but dead ends
+    
+    size_t getRoomCount() const { return roomCount; }
+    size_t getReachableCount() const { return reachableCount; }
+    size_t getOpenableCount() const { return openableCount; }
+    size_t getStartComponentSize() const { return startComponentSize; }
+    
+    void print(std::ostream& os) const;
+    
+    static const char* problemName(Problem problem);
+};
+
+#endif // WORLD_ANALYZER_H
@@ -0,0 +1,95 @@
+#ifndef WORLDFILE_H
+#define WORLDFILE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <unordered_map>
+#include "Room.h"
+#include "Simulation.h"
+#include "TextStore.h"
+#include "Spelling.h"
+#include "Script.h"
+
+// A world described in a text file. Only a small index (file offset, exits
+// and region of every room) is kept in memory; room text and items are
+// parsed from disk whenever a room is loaded. Long room descriptions and
+// item descriptions are kept compressed in a TextStore whose dictionary is
+// trained on a sample of the file's own text, so reloading a room does not
+// re-read its prose as plain strings.
+//
+// File format, one directive per line, fields separated by '|':
+//   start <room id>
+//   room <id>|<name>|<short description>|<long description>
+//   exit <direction>|<room id>
+//   lock <key item name>
+//   item <type>|<name>|<description>|<value>|<flags>|<param>
+//   creature <name>|<health>|<damage>|<attack period>|<aggression>
+//   hazard <name>|<message>|<damage>|<period>
+//   on <event>|<script>
+// exit, lock and item apply to the preceding room. <type> is one of item,
+// weapon, key, consumable, treasure or tool; <flags> may contain 't' (can
+// take) and 'u' (can use); <param> is what a key unlocks or the damage,
+// heal amount or worth of the item. Creature and hazard periods are in
+// simulation ticks. on attaches a script (see Script.h) to the preceding
+// item for use, take and examine, or to the preceding room for enter;
+// scripts are compiled while the file is indexed. Lines starting with '#'
+// are comments.
+class WorldFile {
+private:
+    struct RoomIndex {
+        std::streamoff offset;
+        int region;
+        std::vector<int> neighbours;
+        std::vector<uint32_t> texts; // stored descriptions in file order, once first loaded
+        bool textsStored = false;
+        bool locked = false;         // has a lock line
+    };
+    
+    std::string path;
+    std::ifstream stream;
+    std::unordered_map<int, RoomIndex> index;
+    std::vector<std::vector<int>> regions; // region id -> room ids
+    int startRoomId;
+    std::shared_ptr<TextStore> textStore;
+    std::shared_ptr<SpellingIndex> itemNames;
+    std::shared_ptr<ScriptBook> scripts;
+    
+    // Creatures and hazards are small and always resident in the simulation
+    std::vector<CreatureSpecies> species;
+    std::vector<HazardKind> hazardKinds;
+    std::vector<std::pair<int, int>> creatureSpawns; // room id, species index
+    std::vector<std::pair<int, int>> hazardSpawns;   // room id, hazard kind index
+    
+    void buildIndex(std::vector<std::string>& textSamples);
+    void partitionRegions(size_t roomsPerRegion);
+    [[noreturn]] void parseError(const std::string& message, size_t lineNumber) const;
+    int parseNumber(const std::string& text, const std::string& what, size_t lineNumber) const;
+
+public:
+    WorldFile(const std::string& filePath, size_t roomsPerRegion = 64);
+    
+    // Index queries
+    bool hasRoom(int roomId) const { return index.count(roomId) != 0; }
+    int getStartRoomId() const { return startRoomId; }
+    int getRoomCount() const { return static_cast<int>(index.size()); }
+    int getRegionCount() const { return static_cast<int>(regions.size()); }
+    int getRegion(int roomId) const;
+    const std::vector<int>& getRegionRooms(int regionId) const { return regions.at(regionId); }
+    const std::vector<int>& getNeighbours(int roomId) const;
+    bool isLocked(int roomId) const; // as the file describes it, before any play
+    
+    const TextStore& getTextStore() const { return *textStore; }
+    std::shared_ptr<const TextStore> shareTextStore() const { return textStore; }
+    std::shared_ptr<const SpellingIndex> getItemNames() const { return itemNames; }
+    std::shared_ptr<const ScriptBook> getScripts() const { return scripts; }
+    
+    // Parse a room, including its exits and items, from disk
+    std::unique_ptr<Room> loadRoom(int roomId);
+    
+    // Spawns the world's creatures and hazards
+    void populate(WorldSimulation& simulation) const;
+};
+
+#endif // WORLDFILE_H
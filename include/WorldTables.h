@@ -0,0 +1,159 @@
+#ifndef WORLD_TABLES_H
+#define WORLD_TABLES_H
+
+#include <string_view>
+#include <cstddef>
+#include "Item.h"
+#include "Script.h"
+
+// Records for content compiled into the game (the built-in island). Tables
+// of these are constexpr, so they live in read-only data, and the checks
+// below run at compile time: broken content fails the build.
+struct RoomRecord {
+    int id;
+    std::string_view name;
+    std::string_view description;
+    std::string_view longDescription;
+    std::string_view unlockKey; // empty when the room is open
+};
+
+struct ExitRecord {
+    int from;
+    std::string_view direction;
+    int to;
+};
+
+struct ItemRecord {
+    int room;
+    ItemType type;
+    std::string_view name;
+    std::string_view description;
+    int value;
+    bool canTake;
+    bool canUse;
+    int amount;                // weapon damage, healing or treasure worth
+    std::string_view unlocks;  // keys only
+};
+
+struct CreatureRecord {
+    int room;
+    std::string_view name;
+    int maxHealth;
+    int damage;
+    int attackPeriod; // ticks
+    int aggression;
+};
+
+struct HazardRecord {
+    int room;
+    std::string_view name;
+    std::string_view message;
+    int damage;
+    int period; // ticks
+};
+
+// Compiled when the first game is created. room is used by enter scripts,
+// item by the others.
+struct ScriptRecord {
+    ScriptEvent event;
+    int room;
+    std::string_view item;
+    std::string_view source;
+};
+
+namespace worldcheck {
+    constexpr bool isDirection(std::string_view direction) {
+        return direction == "north" || direction == "south" || direction == "east" ||
+               direction == "west" || direction == "up" || direction == "down";
+    }
+    
+    template <size_t R>
+    constexpr bool hasRoom(const RoomRecord (&rooms)[R], int id) {
+        for (const RoomRecord& room : rooms) {
+            if (room.id == id) return true;
+        }
+        return false;
+    }
+    
+    template <size_t R>
+    constexpr bool roomIdsUnique(const RoomRecord (&rooms)[R]) {
+        for (size_t i = 0; i < R; ++i) {
+            for (size_t j = i + 1; j < R; ++j) {
+                if (rooms[i].id == rooms[j].id) return false;
+            }
+        }
+        return true;
+    }
+    
+    // Both ends exist, the direction is one the parser knows, and no room
+    // has two exits the same way
+    template <size_t R, size_t E>
+    constexpr bool exitsResolve(const RoomRecord (&rooms)[R], const ExitRecord (&exits)[E]) {
+        for (size_t i = 0; i < E; ++i) {
+            if (!hasRoom(rooms, exits[i].from) || !hasRoom(rooms, exits[i].to) ||
+                !isDirection(exits[i].direction)) {
+                return false;
+            }
+            for (size_t j = i + 1; j < E; ++j) {
+                if (exits[i].from == exits[j].from && exits[i].direction == exits[j].direction) return false;
+            }
+        }
+        return true;
+    }
+    
+    template <size_t R, size_t I>
+    constexpr bool itemsPlaced(const RoomRecord (&rooms)[R], const ItemRecord (&items)[I]) {
+        for (size_t i = 0; i < I; ++i) {
+            if (!hasRoom(rooms, items[i].room)) return false;
+            for (size_t j = i + 1; j < I; ++j) {
+                if (items[i].name == items[j].name) return false; // commands find items by name
+            }
+        }
+        return true;
+    }
+    
+    // Every locked room names a takeable key that is not inside the room it opens
+    template <size_t R, size_t I>
+    constexpr bool locksHaveKeys(const RoomRecord (&rooms)[R], const ItemRecord (&items)[I]) {
+        for (const RoomRecord& room : rooms) {
+            if (room.unlockKey.empty()) continue;
+            bool found = false;
+            for (const ItemRecord& item : items) {
+                if (item.name == room.unlockKey && item.type == ItemType::KEY &&
+                    item.canTake && item.room != room.id) {
+                    found = true;
+                }
+            }
+            if (!found) return false;
+        }
+        return true;
+    }
+    
+    // Enter scripts name an existing room; the others an existing item
+    template <size_t R, size_t I, size_t S>
+    constexpr bool scriptsAttached(const RoomRecord (&rooms)[R], const ItemRecord (&items)[I],
+                                   const ScriptRecord (&scripts)[S]) {
+        for (const ScriptRecord& script : scripts) {
+            if (script.event == ScriptEvent::ENTER) {
+                if (!hasRoom(rooms, script.room) || !script.item.empty()) return false;
+                continue;
+            }
+            bool found = false;
+            for (const ItemRecord& item : items) {
+                if (item.name == script.item) found = true;
+            }
+            if (!found) return false;
+        }
+        return true;
+    }
+    
+    template <size_t R, typename Spawn, size_t S>
+    constexpr bool spawnsPlaced(const RoomRecord (&rooms)[R], const Spawn (&spawns)[S]) {
+        for (const Spawn& spawn : spawns) {
+            if (!hasRoom(rooms, spawn.room)) return false;
+        }
+        return true;
+    }
+}
+
+#endif // WORLD_TABLES_H
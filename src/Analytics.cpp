@@ -0,0 +1,308 @@
+#include "Analytics.h"
+#include "Serialization.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    const char FILE_MAGIC[] = {'F', 'I', 'A', 'N', 1};
+    const char OTHER_VERB[] = "<other>";
+    
+    std::atomic<uint64_t> nextInstance{1};
+    
+    // Owner-only increment: no other thread writes the counter, so no locked instruction is needed
+    void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+Analytics::Analytics(const std::string& filePath)
+    : instance(nextInstance.fetch_add(1, std::memory_order_relaxed)), path(filePath) {
+    if (!path.empty()) {
+        load();
+    }
+}
+
+Analytics::~Analytics() {
+    try {
+        save();
+    } catch (...) {
+        // Statistics are best effort; never fail shutdown over them
+    }
+}
+
+Analytics::LocalCounters& Analytics::localCounters() {
+    thread_local uint64_t cachedInstance = 0;
+    thread_local LocalCounters* cached = nullptr;
+    if (cachedInstance == instance) {
+        return *cached;
+    }
+    
+    // First event of this thread here (or it last counted for another Analytics)
+    std::lock_guard<std::mutex> lock(localsMutex);
+    std::thread::id self = std::this_thread::get_id();
+    auto found = std::find_if(locals.begin(), locals.end(),
+        [self](const std::unique_ptr<LocalCounters>& local) { return local->owner == self; });
+    if (found == locals.end()) {
+        locals.push_back(std::make_unique<LocalCounters>());
+        locals.back()->owner = self;
+        found = locals.end() - 1;
+    }
+    cachedInstance = instance;
+    cached = found->get();
+    return *cached;
+}
+
+void Analytics::eventRecorded(LocalCounters& local) {
+    if (++local.events >= MERGE_THRESHOLD) {
+        std::lock_guard<std::mutex> lock(local.mutex);
+        mergeLocal(local);
+    }
+}
+
+void Analytics::recordRoom(int roomId, RoomCounter counter) {
+    LocalCounters& local = localCounters();
+    size_t column = static_cast<size_t>(counter);
+    if (roomId >= 0 && static_cast<size_t>(roomId) < DENSE_ROOMS) {
+        bump(local.rooms[static_cast<size_t>(roomId)][column]);
+    } else {
+        std::lock_guard<std::mutex> lock(local.mutex);
+        ++local.otherRooms[roomId][column];
+    }
+    eventRecorded(local);
+}
+
+void Analytics::recordCommand(const std::string& verb, CommandStatus status) {
+    LocalCounters& local = localCounters();
+    const std::string& key = verb.size() <= MAX_VERB_LENGTH ? verb : OTHER_VERB;
+    size_t column = static_cast<size_t>(status);
+    auto known = local.verbIds.find(key);
+    if (known == local.verbIds.end()) {
+        uint32_t id = local.verbCount.load(std::memory_order_relaxed);
+        if (id < LOCAL_VERBS) {
+            local.verbs[id] = key;
+            known = local.verbIds.emplace(key, id).first;
+            local.verbCount.store(id + 1, std::memory_order_release); // the name is readable from here on
+        }
+    }
+    if (known != local.verbIds.end()) {
+        bump(local.commands[known->second][column]);
+    } else {
+        std::lock_guard<std::mutex> lock(local.mutex);
+        ++local.otherCommands[key][column];
+    }
+    eventRecorded(local);
+}
+
+void Analytics::recordDrop(const std::string& itemName) {
+    LocalCounters& local = localCounters();
+    {
+        std::lock_guard<std::mutex> lock(local.mutex);
+        ++local.drops[itemName];
+    }
+    eventRecorded(local);
+}
+
+void Analytics::addCommands(const std::string& verb, const CommandRow& counts) {
+    // Called with totalsMutex held
+    bool known = commandTotals.count(verb) || commandTotals.size() < MAX_VERBS;
+    CommandRow& row = commandTotals[known ? verb : OTHER_VERB];
+    for (size_t i = 0; i < COMMAND_STATUS_COUNT; ++i) {
+        row[i] += counts[i];
+    }
+}
+
+void Analytics::mergeLocal(LocalCounters& local) {
+    // Called with local.mutex held; totalsMutex is always taken second
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    for (size_t id = 0; id < DENSE_ROOMS; ++id) {
+        RoomRow& merged = local.roomsMerged[id];
+        for (size_t i = 0; i < ROOM_COUNTER_COUNT; ++i) {
+            uint64_t now = local.rooms[id][i].load(std::memory_order_relaxed);
+            if (now != merged[i]) {
+                roomTotals[static_cast<int>(id)][i] += now - merged[i];
+                merged[i] = now;
+            }
+        }
+    }
+    uint32_t verbCount = local.verbCount.load(std::memory_order_acquire);
+    for (uint32_t id = 0; id < verbCount; ++id) {
+        CommandRow gained{};
+        bool changed = false;
+        for (size_t i = 0; i < COMMAND_STATUS_COUNT; ++i) {
+            uint64_t now = local.commands[id][i].load(std::memory_order_relaxed);
+            gained[i] = now - local.commandsMerged[id][i];
+            local.commandsMerged[id][i] = now;
+            changed = changed || gained[i] != 0;
+        }
+        if (changed) {
+            addCommands(local.verbs[id], gained);
+        }
+    }
+    
+    for (const auto& entry : local.otherRooms) {
+        RoomRow& row = roomTotals[entry.first];
+        for (size_t i = 0; i < ROOM_COUNTER_COUNT; ++i) {
+            row[i] += entry.second[i];
+        }
+    }
+    for (const auto& entry : local.otherCommands) {
+        addCommands(entry.first, entry.second);
+    }
+    for (const auto& entry : local.drops) {
+        dropTotals[entry.first] += entry.second;
+    }
+    local.otherRooms.clear();
+    local.otherCommands.clear();
+    local.drops.clear();
+    if (local.owner == std::this_thread::get_id()) {
+        local.events = 0;
+    }
+}
+
+void Analytics::merge() {
+    std::lock_guard<std::mutex> registry(localsMutex);
+    for (const auto& local : locals) {
+        std::lock_guard<std::mutex> lock(local->mutex);
+        mergeLocal(*local);
+    }
+}
+
+void Analytics::load() {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return; // first run
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.compare(0, sizeof(FILE_MAGIC), std::string(FILE_MAGIC, sizeof(FILE_MAGIC))) != 0) {
+        throw std::runtime_error("Not an analytics file: " + path);
+    }
+    
+    ByteReader reader(data);
+    for (size_t i = 0; i < sizeof(FILE_MAGIC); ++i) {
+        reader.readByte();
+    }
+    
+    // Every entry takes at least a byte, so a count larger than what is
+    // left of the file is corrupt; checking first keeps a damaged file
+    // from asking for a huge allocation
+    auto readCount = [&](size_t limit, const char* what) {
+        uint64_t count = reader.readVarint();
+        if (count > data.size() - reader.position() || count > limit) {
+            throw std::runtime_error("Corrupt analytics file " + path + ": " + std::to_string(count) + " " + what);
+        }
+        return static_cast<size_t>(count);
+    };
+    
+    std::vector<int> roomIds(readCount(std::numeric_limits<size_t>::max(), "rooms"));
+    for (int& id : roomIds) {
+        int64_t raw = reader.readInt();
+        if (raw < std::numeric_limits<int>::min() || raw > std::numeric_limits<int>::max()) {
+            throw std::runtime_error("Corrupt analytics file " + path + ": room id " + std::to_string(raw));
+        }
+        id = static_cast<int>(raw);
+    }
+    for (size_t column = 0; column < ROOM_COUNTER_COUNT; ++column) {
+        for (int id : roomIds) {
+            roomTotals[id][column] += reader.readVarint();
+        }
+    }
+    
+    std::vector<std::string> verbs(readCount(MAX_VERBS + 1, "verbs")); // the cap plus <other>
+    for (std::string& verb : verbs) {
+        verb = reader.readString();
+        if (verb.size() > MAX_VERB_LENGTH) {
+            verb = OTHER_VERB;
+        }
+    }
+    for (size_t column = 0; column < COMMAND_STATUS_COUNT; ++column) {
+        for (const std::string& verb : verbs) {
+            commandTotals[verb][column] += reader.readVarint();
+        }
+    }
+    
+    std::vector<std::string> items(readCount(std::numeric_limits<size_t>::max(), "items"));
+    for (std::string& item : items) {
+        item = reader.readString();
+    }
+    for (const std::string& item : items) {
+        dropTotals[item] += reader.readVarint();
+    }
+}
+
+void Analytics::save() {
+    merge();
+    if (path.empty()) {
+        return;
+    }
+    
+    std::string data(FILE_MAGIC, sizeof(FILE_MAGIC));
+    ByteWriter writer(data);
+    {
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        writer.writeVarint(roomTotals.size());
+        for (const auto& entry : roomTotals) {
+            writer.writeInt(entry.first);
+        }
+        for (size_t column = 0; column < ROOM_COUNTER_COUNT; ++column) {
+            for (const auto& entry : roomTotals) {
+                writer.writeVarint(entry.second[column]);
+            }
+        }
+        
+        writer.writeVarint(commandTotals.size());
+        for (const auto& entry : commandTotals) {
+            writer.writeString(entry.first);
+        }
+        for (size_t column = 0; column < COMMAND_STATUS_COUNT; ++column) {
+            for (const auto& entry : commandTotals) {
+                writer.writeVarint(entry.second[column]);
+            }
+        }
+        
+        writer.writeVarint(dropTotals.size());
+        for (const auto& entry : dropTotals) {
+            writer.writeString(entry.first);
+        }
+        for (const auto& entry : dropTotals) {
+            writer.writeVarint(entry.second);
+        }
+    }
+    
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            throw std::runtime_error("Cannot write analytics file: " + tempPath);
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace analytics file: " + path);
+    }
+}
+
+uint64_t Analytics::getRoomCount(int roomId, RoomCounter counter) {
+    merge();
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    auto it = roomTotals.find(roomId);
+    return it == roomTotals.end() ? 0 : it->second[static_cast<size_t>(counter)];
+}
+
+uint64_t Analytics::getCommandCount(const std::string& verb, CommandStatus status) {
+    merge();
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    auto it = commandTotals.find(verb);
+    return it == commandTotals.end() ? 0 : it->second[static_cast<size_t>(status)];
+}
+
+uint64_t Analytics::getDropCount(const std::string& itemName) {
+    merge();
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    auto it = dropTotals.find(itemName);
+    return it == dropTotals.end() ? 0 : it->second;
+}
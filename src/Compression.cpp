@@ -0,0 +1,223 @@
+#include "Compression.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_OFFSET = 65535;
+    const int DICTIONARY_HASH_BITS = 15;
+    const int MIN_INPUT_HASH_BITS = 8;
+    const int MAX_INPUT_HASH_BITS = 14;
+    
+    uint32_t read32(const char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    
+    size_t hash4(const char* p, int bits) {
+        return (read32(p) * 2654435761u) >> (32 - bits);
+    }
+    
+    void buildTable(std::string_view data, std::vector<int32_t>& table) {
+        table.assign(size_t(1) << DICTIONARY_HASH_BITS, -1);
+        for (size_t i = 0; i + MIN_MATCH <= data.size(); ++i) {
+            table[hash4(data.data() + i, DICTIONARY_HASH_BITS)] = static_cast<int32_t>(i);
+        }
+    }
+    
+    // Lengths of 15 and above continue in extra bytes (255 = keep going)
+    void writeLength(std::string& out, size_t length) {
+        while (length >= 255) {
+            out.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        out.push_back(static_cast<char>(length));
+    }
+    
+    void writeVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+    
+    [[noreturn]] void corrupt() {
+        throw std::runtime_error("Corrupt compressed data");
+    }
+    
+    void writeSequence(std::string& out, const char* literals, size_t literalLength,
+                       size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+        uint8_t token = static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) |
+                                             std::min<size_t>(matchCode, 15));
+        out.push_back(static_cast<char>(token));
+        if (literalLength >= 15) {
+            writeLength(out, literalLength - 15);
+        }
+        out.append(literals, literalLength);
+        if (matchLength) {
+            out.push_back(static_cast<char>(offset & 0xFF));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (matchCode >= 15) {
+                writeLength(out, matchCode - 15);
+            }
+        }
+    }
+    
+    // Greedy parse. Each position is matched against the latest earlier
+    // occurrence in the input and in the dictionary; the longer one wins.
+    // Dictionary matches stop at the end of the dictionary.
+    std::string compressWith(std::string_view input, std::string_view dictionary,
+                             const std::vector<int32_t>& dictionaryTable) {
+        const char* in = input.data();
+        size_t end = input.size();
+        std::string out;
+        writeVarint(out, end);
+        
+        int bits = MIN_INPUT_HASH_BITS;
+        while (bits < MAX_INPUT_HASH_BITS && (size_t(1) << bits) < end) {
+            ++bits;
+        }
+        std::vector<int32_t> table(size_t(1) << bits, -1);
+        
+        size_t anchor = 0;
+        size_t pos = 0;
+        while (pos + MIN_MATCH <= end) {
+            size_t bestLength = 0;
+            size_t bestOffset = 0;
+            
+            size_t slot = hash4(in + pos, bits);
+            int32_t candidate = table[slot];
+            table[slot] = static_cast<int32_t>(pos);
+            if (candidate >= 0 && pos - static_cast<size_t>(candidate) <= MAX_OFFSET &&
+                read32(in + candidate) == read32(in + pos)) {
+                size_t length = MIN_MATCH;
+                while (pos + length < end && in[candidate + length] == in[pos + length]) {
+                    ++length;
+                }
+                bestLength = length;
+                bestOffset = pos - static_cast<size_t>(candidate);
+            }
+            
+            if (!dictionary.empty()) {
+                int32_t entry = dictionaryTable[hash4(in + pos, DICTIONARY_HASH_BITS)];
+                size_t offset = pos + dictionary.size() - static_cast<size_t>(entry);
+                if (entry >= 0 && offset <= MAX_OFFSET &&
+                    static_cast<size_t>(entry) + MIN_MATCH <= dictionary.size() &&
+                    read32(dictionary.data() + entry) == read32(in + pos)) {
+                    size_t length = MIN_MATCH;
+                    while (pos + length < end && entry + length < dictionary.size() &&
+                           dictionary[entry + length] == in[pos + length]) {
+                        ++length;
+                    }
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestOffset = offset;
+                    }
+                }
+            }
+            
+            if (bestLength == 0) {
+                ++pos;
+                continue;
+            }
+            writeSequence(out, in + anchor, pos - anchor, bestOffset, bestLength);
+            
+            // Keep the table warm inside long matches without hashing every byte
+            for (size_t i = pos + 1; i < pos + bestLength && i + MIN_MATCH <= end; i += 2) {
+                table[hash4(in + i, bits)] = static_cast<int32_t>(i);
+            }
+            pos += bestLength;
+            anchor = pos;
+        }
+        if (anchor < end) {
+            writeSequence(out, in + anchor, end - anchor, 0, 0);
+        }
+        return out;
+    }
+}
+
+std::string lzCompress(std::string_view input, std::string_view dictionary) {
+    std::vector<int32_t> dictionaryTable;
+    if (!dictionary.empty()) {
+        buildTable(dictionary, dictionaryTable);
+    }
+    return compressWith(input, dictionary, dictionaryTable);
+}
+
+std::string lzDecompress(std::string_view compressed, std::string_view dictionary) {
+    size_t in = 0;
+    uint64_t rawLength = 0;
+    for (int shift = 0;; shift += 7) {
+        if (in >= compressed.size() || shift > 63) corrupt();
+        uint8_t byte = static_cast<uint8_t>(compressed[in++]);
+        rawLength |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    if (rawLength > compressed.size() * 255 + 16) corrupt(); // beyond any achievable ratio
+    
+    std::string out;
+    out.reserve(rawLength);
+    
+    auto readLength = [&](size_t length) {
+        if (length < 15) return length;
+        uint8_t byte;
+        do {
+            if (in >= compressed.size()) corrupt();
+            byte = static_cast<uint8_t>(compressed[in++]);
+            length += byte;
+        } while (byte == 255);
+        return length;
+    };
+    
+    while (out.size() < rawLength) {
+        if (in >= compressed.size()) corrupt();
+        uint8_t token = static_cast<uint8_t>(compressed[in++]);
+        size_t literalLength = readLength(token >> 4);
+        if (literalLength > compressed.size() - in || out.size() + literalLength > rawLength) corrupt();
+        out.append(compressed.data() + in, literalLength);
+        in += literalLength;
+        if (out.size() == rawLength) break;
+        
+        if (compressed.size() - in < 2) corrupt();
+        size_t offset = static_cast<uint8_t>(compressed[in]) |
+                        (static_cast<size_t>(static_cast<uint8_t>(compressed[in + 1])) << 8);
+        in += 2;
+        size_t matchLength = readLength(token & 0x0F) + MIN_MATCH;
+        if (offset == 0 || offset > out.size() + dictionary.size() || out.size() + matchLength > rawLength) {
+            corrupt();
+        }
+        
+        // Offsets reaching past the start of the output continue into the dictionary
+        size_t copied = 0;
+        if (offset > out.size()) {
+            size_t from = dictionary.size() - (offset - out.size());
+            size_t fromDictionary = std::min(matchLength, dictionary.size() - from);
+            out.append(dictionary.data() + from, fromDictionary);
+            copied = fromDictionary;
+        }
+        // Byte by byte: the match may overlap the bytes it produces
+        size_t from = out.size() - offset;
+        for (; copied < matchLength; ++copied) {
+            out.push_back(out[from++]);
+        }
+    }
+    if (in != compressed.size()) corrupt();
+    return out;
+}
+
+LzDictionary::LzDictionary(std::string dictionary) : data(std::move(dictionary)) {
+    if (data.size() > MAX_OFFSET) {
+        data.erase(0, data.size() - MAX_OFFSET); // the rest could never be referenced
+    }
+    if (!data.empty()) {
+        buildTable(data, table);
+    }
+}
+
+std::string LzDictionary::compress(std::string_view input) const {
+    return compressWith(input, data, table);
+}
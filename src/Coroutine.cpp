@@ -0,0 +1,65 @@
+#include "Coroutine.h"
+#include <utility>
+
+Task& Task::operator=(Task&& other) noexcept {
+    if (this != &other) {
+        if (handle) {
+            handle.destroy();
+        }
+        handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+}
+
+Task::~Task() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+void Task::start() {
+    if (handle && !handle.done()) {
+        handle.resume();
+    }
+    rethrowIfFailed();
+}
+
+void Task::rethrowIfFailed() const {
+    if (handle && handle.done() && handle.promise().exception) {
+        std::rethrow_exception(handle.promise().exception);
+    }
+}
+
+std::coroutine_handle<> Task::await_suspend(std::coroutine_handle<> awaiter) noexcept {
+    handle.promise().continuation = awaiter;
+    return handle;
+}
+
+void Task::await_resume() {
+    if (handle && handle.promise().exception) {
+        std::rethrow_exception(handle.promise().exception);
+    }
+}
+
+std::optional<std::string> LineChannel::Awaiter::await_resume() {
+    if (channel.lines.empty()) {
+        return std::nullopt;
+    }
+    std::string line = std::move(channel.lines.front());
+    channel.lines.pop_front();
+    return line;
+}
+
+void LineChannel::push(std::string line) {
+    lines.push_back(std::move(line));
+    if (waiter) {
+        std::exchange(waiter, nullptr).resume();
+    }
+}
+
+void LineChannel::close() {
+    closed = true;
+    if (waiter) {
+        std::exchange(waiter, nullptr).resume();
+    }
+}
@@ -3,17 +3,102 @@
 #include <algorithm>
 #include <sstream>
 #include <cctype>
+#include <optional>
 
-Game::Game() : currentRoomId(1), gameRunning(false), gameScore(0) {
+namespace {
+    // Every verb dispatchCommand() accepts, except the one-letter shortcuts
+    const char* const COMMAND_VERBS[] = {
+        "go", "move", "north", "south", "east", "west", "up", "down",
+        "look", "examine", "inspect", "take", "get", "pick", "drop", "leave", "use",
+        "attack", "fight", "kill", "inventory", "status", "health", "help", "score",
+        "leaderboard", "scores", "rank", "memstats", "quit", "exit"
+    };
+    
+    const SpellingIndex& verbIndex() {
+        static const SpellingIndex index = [] {
+            SpellingIndex verbs;
+            for (const char* verb : COMMAND_VERBS) {
+                verbs.add(verb);
+            }
+            return verbs;
+        }();
+        return index;
+    }
+    
+    // Short words are corrected less eagerly: "tkae" is take, but "fog" is not "go"
+    int allowedEdits(const std::string& word) {
+        if (word.size() < 3) return 0;
+        return word.size() < 6 ? 1 : SpellingIndex::MAX_DISTANCE;
+    }
+    
+    const size_t MAX_GUESSES = 3;
+    
+    // Keeps the rooms a command looks up resident until it is over
+    class EvictionHold {
+    private:
+        RegionPager* pager;
+    
+    public:
+        explicit EvictionHold(RegionPager* regionPager) : pager(regionPager) {
+            if (pager) pager->holdEvictions();
+        }
+        ~EvictionHold() {
+            if (pager) pager->releaseEvictions();
+        }
+        EvictionHold(const EvictionHold&) = delete;
+        EvictionHold& operator=(const EvictionHold&) = delete;
+    };
+}
+
+Game::Game() : currentRoomId(1), gameRunning(false), quitRequested(false),
+      roomRenderSuppressed(false), roomRenderPending(false), output(&std::cout), gameScore(0), ticksPerCommand(0),
+      leaderboard(nullptr), scoreRecorded(false), analytics(nullptr),
+      traceSession(1), tracing(false), memoryPeakTotal(0), bufferBytes(0) {
     player = std::make_unique<Player>("Adventurer");
     initializeRooms();
     initializeItems();
+    initializeCreatures();
+    simulation.setRoomOccupied(currentRoomId, true);
+}
+
+Game::Game(const std::string& worldPath, size_t regionBudgetBytes)
+    : currentRoomId(1), gameRunning(false), quitRequested(false),
+      roomRenderSuppressed(false), roomRenderPending(false), output(&std::cout), gameScore(0), ticksPerCommand(0),
+      leaderboard(nullptr), scoreRecorded(false), analytics(nullptr),
+      traceSession(1), tracing(false), memoryPeakTotal(0), bufferBytes(0) {
+    player = std::make_unique<Player>("Adventurer");
+    worldFile = std::make_unique<WorldFile>(worldPath);
+    regionPager = std::make_unique<RegionPager>(*worldFile, regionBudgetBytes);
+    currentRoomId = worldFile->getStartRoomId();
+    regionPager->enterRoom(currentRoomId);
+    worldFile->populate(simulation);
+    itemNames = worldFile->getItemNames();
+    scripts = worldFile->getScripts();
+    simulation.setRoomOccupied(currentRoomId, true);
 }
 
 Game::~Game() = default;
 
 void Game::startGame() {
+    LineChannel input;
+    Task session = play(input);
+    session.start();
+    
+    std::string line;
+    while (!session.done() && std::getline(std::cin, line)) {
+        input.push(line);
+        session.rethrowIfFailed();
+    }
+    input.close();
+    session.rethrowIfFailed();
+}
+
+void Game::begin(const std::string& playerName) {
     gameRunning = true;
+    scoreRecorded = false;
+    if (analytics) {
+        analytics->recordRoom(currentRoomId, RoomCounter::VISITS);
+    }
     
     // Set initial game state
     setFlag("has_torch", false);
@@ -21,88 +106,250 @@ void Game::startGame() {
     setFlag("temple_door_open", false);
     setFlag("treasure_found", false);
     
-    std::cout << "Enter your name, brave adventurer: ";
-    std::string playerName;
-    std::getline(std::cin, playerName);
-    
     if (!playerName.empty()) {
-        player = std::make_unique<Player>(playerName);
+        player->setName(playerName);
     }
+    lastTickTime = std::chrono::steady_clock::now();
+    
+    // A pooled game starts a new session here; its high-water marks start over
+    memoryPeak = MemoryUsage();
+    memoryPeakTotal = 0;
+    noteMemoryUsage();
+}
+
+Task Game::play(LineChannel& input) {
+    co_await readPlayerName(input);
     
-    std::cout << "\nWelcome, " << player->getName() << "!\n\n";
+    *output << "\nWelcome, " << player->getName() << "!\n\n";
     
     // Display starting room
     displayRoom();
     
     // Start main game loop
-    gameLoop();
+    co_await gameLoop(input);
 }
 
-void Game::gameLoop() {
-    std::string input;
-    
+Task Game::readPlayerName(LineChannel& input) {
+    *output << "Enter your name, brave adventurer: ";
+    std::optional<std::string> playerName = co_await input.next();
+    begin(playerName ? *playerName : "");
+}
+
+Task Game::gameLoop(LineChannel& input) {
     while (gameRunning) {
-        std::cout << "\n> ";
-        std::getline(std::cin, input);
+        *output << "\n> ";
+        std::optional<std::string> line = co_await input.next();
         
-        if (input.empty()) {
+        if (!line) {
+            endGame(); // input closed, e.g. the client disconnected
+            break;
+        }
+        if (line->empty()) {
             continue;
         }
         
-        processCommand(toLowerCase(input));
-        updateGameState();
-        checkWinCondition();
-        
-        if (!player->isAlive()) {
-            std::cout << "\nYou have died! Your adventure ends here.\n";
-            std::cout << "Final Score: " << gameScore << "\n";
-            gameRunning = false;
+        // A line may chain several commands; each is a full turn. Trace scopes
+        // are per thread, so none may stay open while the dialog is suspended.
+        std::optional<TraceScope> trace(std::in_place, traceSession, tracing);
+        std::vector<std::string> batch;
+        {
+            TraceSpan span("tokenize");
+            batch = parseCommandBatch(toLowerCase(*line));
+        }
+        for (size_t i = 0; i < batch.size(); ++i) {
+            roomRenderSuppressed = i + 1 < batch.size();
+            CommandStatus status = processCommand(batch[i]);
+            if (quitRequested) {
+                trace.reset();
+                co_await confirmQuit(input);
+                trace.emplace(traceSession, tracing);
+            }
+            finishTurn();
+            if (status != CommandStatus::OK || !gameRunning) {
+                break;
+            }
         }
+        finishBatch();
     }
 }
 
-void Game::processCommand(const std::string& command) {
+CommandStatus Game::executeCommand(const std::string& command, int* stepsExecuted) {
+    if (!gameRunning) {
+        return CommandStatus::GAME_OVER;
+    }
+    TraceScope trace(traceSession, tracing);
+    TraceSpan span("executeCommand");
+    
+    std::vector<std::string> batch;
+    {
+        TraceSpan tokenize("tokenize");
+        batch = parseCommandBatch(toLowerCase(command));
+    }
+    CommandStatus status = CommandStatus::OK;
+    int steps = 0;
+    for (size_t i = 0; i < batch.size() && gameRunning; ++i) {
+        roomRenderSuppressed = i + 1 < batch.size();
+        status = processCommand(batch[i]);
+        ++steps;
+        if (quitRequested) {
+            // Machine clients have already decided; there is no dialog to confirm
+            quitRequested = false;
+            *output << "Thanks for playing!\n";
+            endGame();
+        }
+        finishTurn();
+        if (status != CommandStatus::OK) {
+            break;
+        }
+    }
+    finishBatch();
+    
+    if (stepsExecuted) {
+        *stepsExecuted = steps;
+    }
+    return status;
+}
+
+void Game::finishBatch() {
+    // Show where the player ended up if the batch skipped that render
+    roomRenderSuppressed = false;
+    if (roomRenderPending) {
+        roomRenderPending = false;
+        if (gameRunning) {
+            *output << "\n";
+            displayRoom();
+        }
+    }
+    noteMemoryUsage();
+}
+
+std::vector<std::string> Game::parseCommandBatch(const std::string& line) {
+    // Commands are separated by ',', ';', '.' or the words "then" and "and",
+    // so "take seashell, take driftwood then go west" and "n.n.w" both work.
+    std::vector<std::string> batch;
+    std::string command, word;
+    
+    auto endWord = [&]() {
+        if (word == "then" || word == "and") {
+            if (!command.empty()) batch.push_back(std::move(command));
+            command.clear();
+        } else if (!word.empty()) {
+            command += (command.empty() ? "" : " ") + word;
+        }
+        word.clear();
+    };
+    
+    for (char ch : line) {
+        if (ch == ',' || ch == ';' || ch == '.') {
+            endWord();
+            if (!command.empty()) batch.push_back(std::move(command));
+            command.clear();
+        } else if (std::isspace(static_cast<unsigned char>(ch))) {
+            endWord();
+        } else {
+            word.push_back(ch);
+        }
+    }
+    endWord();
+    if (!command.empty()) {
+        batch.push_back(std::move(command));
+    }
+    return batch;
+}
+
+void Game::finishTurn() {
+    TraceSpan span("finishTurn");
+    updateGameState();
+    checkWinCondition();
+    
+    if (!player->isAlive() && gameRunning) {
+        *output << "\nYou have died! Your adventure ends here.\n";
+        if (analytics) {
+            analytics->recordRoom(currentRoomId, RoomCounter::DEATHS);
+        }
+        *output << "Final Score: " << gameScore << "\n";
+        endGame();
+    }
+}
+
+Task Game::confirmQuit(LineChannel& input) {
+    quitRequested = false;
+    *output << "Are you sure you want to quit? (y/n): ";
+    std::optional<std::string> confirm = co_await input.next();
+    if (!confirm || toLowerCase(*confirm) == "y" || toLowerCase(*confirm) == "yes") {
+        *output << "Thanks for playing!\n";
+        endGame();
+    }
+}
+
+CommandStatus Game::processCommand(const std::string& command) {
+    TraceSpan span("processCommand");
+    EvictionHold hold(regionPager.get()); // handlers keep Room pointers across scripts
     std::vector<std::string> words = splitCommand(command);
     
-    if (words.empty()) return;
+    if (words.empty()) return CommandStatus::OK;
     
+    // Item names can span several words ("temple key"), so the target is the rest of the line
     std::string action = words[0];
-    std::string target = words.size() > 1 ? words[1] : "";
-    
+    std::string target;
+    for (size_t i = 1; i < words.size(); ++i) {
+        target += (i > 1 ? " " : "") + words[i];
+    }
+    
+    int roomId = currentRoomId;
+    CommandStatus status;
+    {
+        TraceSpan dispatch("dispatchCommand");
+        status = dispatchCommand(action, target);
+    }
+    if (analytics) {
+        analytics->recordCommand(action, status);
+        analytics->recordRoom(roomId, RoomCounter::TURNS);
+        if (status != CommandStatus::OK && status != CommandStatus::QUIT) {
+            analytics->recordRoom(roomId, RoomCounter::FAILED_TURNS);
+        }
+    }
+    return status;
+}
+
+CommandStatus Game::dispatchCommand(const std::string& action, const std::string& target) {
     // Movement commands
     if (action == "go" || action == "move") {
         if (!target.empty()) {
-            handleMovement(target);
-        } else {
-            std::cout << "Go where? Try: go north, go south, go east, go west\n";
+            return handleMovement(target);
         }
+        *output << "Go where? Try: go north, go south, go east, go west\n";
+        return CommandStatus::MISSING_TARGET;
     }
-    else if (action == "north" || action == "n") handleMovement("north");
-    else if (action == "south" || action == "s") handleMovement("south");
-    else if (action == "east" || action == "e") handleMovement("east");
-    else if (action == "west" || action == "w") handleMovement("west");
-    else if (action == "up" || action == "u") handleMovement("up");
-    else if (action == "down" || action == "d") handleMovement("down");
+    else if (action == "north" || action == "n") return handleMovement("north");
+    else if (action == "south" || action == "s") return handleMovement("south");
+    else if (action == "east" || action == "e") return handleMovement("east");
+    else if (action == "west" || action == "w") return handleMovement("west");
+    else if (action == "up" || action == "u") return handleMovement("up");
+    else if (action == "down" || action == "d") return handleMovement("down");
     
     // Interaction commands
     else if (action == "look" || action == "l") {
         if (target.empty()) {
             displayRoom();
-        } else {
-            handleExamine(target);
+            return CommandStatus::OK;
         }
+        return handleExamine(target);
     }
     else if (action == "examine" || action == "inspect") {
-        handleExamine(target);
+        return handleExamine(target);
     }
     else if (action == "take" || action == "get" || action == "pick") {
-        handleTake(target);
+        return handleTake(target);
     }
     else if (action == "drop" || action == "leave") {
-        handleDrop(target);
+        return handleDrop(target);
     }
     else if (action == "use") {
-        handleUse(target);
+        return handleUse(target);
+    }
+    else if (action == "attack" || action == "fight" || action == "kill") {
+        return handleAttack(target);
     }
     
     // Information commands
@@ -110,208 +357,469 @@ void Game::processCommand(const std::string& command) {
         displayInventory();
     }
     else if (action == "status" || action == "health") {
-        player->displayStatus();
+        player->displayStatus(*output);
     }
     else if (action == "help" || action == "h") {
         displayHelp();
     }
     else if (action == "score") {
-        std::cout << "Current Score: " << gameScore << "\n";
+        *output << "Current Score: " << gameScore << "\n";
+    }
+    else if (action == "leaderboard" || action == "scores") {
+        displayLeaderboard();
+    }
+    else if (action == "rank") {
+        displayRank();
+    }
+    else if (action == "memstats") {
+        displayMemoryStats();
     }
     
     // Game control
     else if (action == "quit" || action == "exit" || action == "q") {
-        std::cout << "Are you sure you want to quit? (y/n): ";
-        std::string confirm;
-        std::getline(std::cin, confirm);
-        if (toLowerCase(confirm) == "y" || toLowerCase(confirm) == "yes") {
-            gameRunning = false;
-            std::cout << "Thanks for playing!\n";
-        }
+        quitRequested = true; // confirmed by the confirmQuit() dialog
+        return CommandStatus::QUIT;
     }
     else {
-        std::cout << "I don't understand that command. Type 'help' for available commands.\n";
+        std::vector<std::string> guesses = guessVerb(action);
+        if (guesses.size() == 1) {
+            return dispatchCommand(announceGuess(guesses[0]), target);
+        }
+        *output << "I don't understand that command.";
+        if (!guesses.empty()) {
+            *output << " ";
+            suggestGuesses(guesses);
+        } else {
+            *output << " Type 'help' for available commands.\n";
+        }
+        return CommandStatus::UNKNOWN_COMMAND;
     }
+    return CommandStatus::OK;
 }
 
-void Game::handleMovement(const std::string& direction) {
+CommandStatus Game::handleMovement(const std::string& direction) {
+    TraceSpan span("handleMovement");
     Room* currentRoom = getCurrentRoom();
-    if (!currentRoom) return;
+    if (!currentRoom) return CommandStatus::NO_ROOM;
     
     int nextRoomId = currentRoom->getExit(direction);
     
     if (nextRoomId == -1) {
-        std::cout << "You can't go that way.\n";
-        return;
+        *output << "You can't go that way.\n";
+        return CommandStatus::NO_EXIT;
     }
     
     // Check if the destination room exists
-    auto it = rooms.find(nextRoomId);
-    if (it == rooms.end()) {
-        std::cout << "That path leads nowhere.\n";
-        return;
+    Room* nextRoom = findRoom(nextRoomId);
+    if (!nextRoom) {
+        *output << "That path leads nowhere.\n";
+        return CommandStatus::NO_ROOM;
     }
     
-    Room* nextRoom = it->second.get();
+    // An enter script may open the way, or bar it
+    if (runEnterScript(nextRoomId)) {
+        return CommandStatus::LOCKED;
+    }
     
     // Check if room is locked
     if (nextRoom->isLocked()) {
         std::string keyName = nextRoom->getUnlockKey();
         if (!keyName.empty() && !player->hasItem(keyName)) {
-            std::cout << "The way is locked. You need a " << keyName << " to proceed.\n";
-            return;
+            *output << "The way is locked. You need a " << keyName << " to proceed.\n";
+            return CommandStatus::LOCKED;
         } else if (!keyName.empty() && player->hasItem(keyName)) {
-            std::cout << "You use the " << keyName << " to unlock the way.\n";
+            *output << "You use the " << keyName << " to unlock the way.\n";
             nextRoom->setLocked(false);
         }
     }
     
+    simulation.setRoomOccupied(currentRoomId, false);
+    simulation.setRoomOccupied(nextRoomId, true);
     currentRoomId = nextRoomId;
     nextRoom->setVisited(true);
+    if (analytics) {
+        analytics->recordRoom(currentRoomId, RoomCounter::VISITS);
+    }
     
-    std::cout << "You move " << direction << ".\n\n";
-    displayRoom();
+    *output << "You move " << direction << ".\n";
+    if (roomRenderSuppressed) {
+        roomRenderPending = true; // a later command in the batch shows the room
+    } else {
+        roomRenderPending = false;
+        *output << "\n";
+        displayRoom();
+    }
+    
+    if (regionPager) {
+        regionPager->enterRoom(currentRoomId);
+    }
+    return CommandStatus::OK;
 }
 
-void Game::handleExamine(const std::string& target) {
+CommandStatus Game::handleExamine(const std::string& target) {
+    TraceSpan span("handleExamine");
     if (target.empty()) {
-        std::cout << "Examine what?\n";
-        return;
+        *output << "Examine what?\n";
+        return CommandStatus::MISSING_TARGET;
     }
     
-    // Check inventory first
-    Item* item = player->findItem(target);
-    if (item) {
-        item->examine();
-        return;
-    }
-    
-    // Check current room
+    // Check inventory first, then the current room
     Room* room = getCurrentRoom();
-    if (room) {
-        item = room->findItem(target);
+    if (player->findItem(target) || (room && room->findItem(target))) {
+        if (runItemScript(ScriptEvent::EXAMINE, target)) {
+            return CommandStatus::OK;
+        }
+        // The script may have destroyed the item
+        Item* item = player->findItem(target);
+        if (!item && room) {
+            item = room->findItem(target);
+        }
         if (item) {
-            item->examine();
-            return;
+            item->examine(*output);
         }
+        return CommandStatus::OK;
     }
     
-    std::cout << "You don't see a " << target << " here.\n";
+    std::vector<std::string> guesses = guessItem(target, true, true);
+    if (guesses.size() == 1) {
+        return handleExamine(announceGuess(guesses[0]));
+    }
+    *output << "You don't see a " << target << " here.\n";
+    suggestGuesses(guesses);
+    return CommandStatus::ITEM_NOT_FOUND;
 }
 
-void Game::handleTake(const std::string& itemName) {
+CommandStatus Game::handleTake(const std::string& itemName) {
+    TraceSpan span("handleTake");
     if (itemName.empty()) {
-        std::cout << "Take what?\n";
-        return;
+        *output << "Take what?\n";
+        return CommandStatus::MISSING_TARGET;
     }
     
     Room* room = getCurrentRoom();
-    if (!room) return;
+    if (!room) return CommandStatus::NO_ROOM;
     
     Item* item = room->findItem(itemName);
     if (!item) {
-        std::cout << "There's no " << itemName << " here.\n";
-        return;
+        std::vector<std::string> guesses = guessItem(itemName, true, false);
+        if (guesses.size() == 1) {
+            return handleTake(announceGuess(guesses[0]));
+        }
+        *output << "There's no " << itemName << " here.\n";
+        suggestGuesses(guesses);
+        return CommandStatus::ITEM_NOT_FOUND;
+    }
+    
+    if (runItemScript(ScriptEvent::TAKE, itemName)) {
+        return CommandStatus::CANNOT_TAKE;
+    }
+    item = room->findItem(itemName);
+    if (!item) {
+        return CommandStatus::OK; // the script dealt with it
     }
     
     if (!item->getCanTake()) {
-        std::cout << "You can't take that.\n";
-        return;
+        *output << "You can't take that.\n";
+        return CommandStatus::CANNOT_TAKE;
     }
     
-    std::unique_ptr<Item> takenItem = room->removeItem(itemName);
-    if (takenItem && player->addItem(std::move(takenItem))) {
-        std::cout << "You take the " << itemName << ".\n";
-        gameScore += 10;
-    } else {
-        std::cout << "Your inventory is full!\n";
-        room->addItem(std::move(takenItem)); // Put it back
+    // Check capacity first: a rejected unique_ptr would be destroyed by addItem
+    if (player->getInventorySize() >= player->getMaxInventorySize()) {
+        *output << "Your inventory is full!\n";
+        return CommandStatus::INVENTORY_FULL;
     }
+    
+    player->addItem(room->removeItem(itemName));
+    *output << "You take the " << itemName << ".\n";
+    gameScore += 10;
+    return CommandStatus::OK;
 }
 
-void Game::handleDrop(const std::string& itemName) {
+CommandStatus Game::handleDrop(const std::string& itemName) {
+    TraceSpan span("handleDrop");
     if (itemName.empty()) {
-        std::cout << "Drop what?\n";
-        return;
+        *output << "Drop what?\n";
+        return CommandStatus::MISSING_TARGET;
     }
     
+    Room* room = getCurrentRoom();
+    if (!room) return CommandStatus::NO_ROOM;
+    
     std::unique_ptr<Item> item = player->removeItem(itemName);
-    if (item) {
-        Room* room = getCurrentRoom();
-        if (room) {
-            room->addItem(std::move(item));
-            std::cout << "You drop the " << itemName << ".\n";
+    if (!item) {
+        std::vector<std::string> guesses = guessItem(itemName, false, true);
+        if (guesses.size() == 1) {
+            return handleDrop(announceGuess(guesses[0]));
         }
-    } else {
-        std::cout << "You don't have a " << itemName << ".\n";
+        *output << "You don't have a " << itemName << ".\n";
+        suggestGuesses(guesses);
+        return CommandStatus::ITEM_NOT_FOUND;
     }
+    
+    room->addItem(std::move(item));
+    *output << "You drop the " << itemName << ".\n";
+    if (analytics) {
+        analytics->recordDrop(itemName);
+        analytics->recordRoom(currentRoomId, RoomCounter::ITEM_DROPS);
+    }
+    return CommandStatus::OK;
 }
 
-void Game::handleUse(const std::string& itemName) {
+CommandStatus Game::handleUse(const std::string& itemName) {
+    TraceSpan span("handleUse");
     if (itemName.empty()) {
-        std::cout << "Use what?\n";
-        return;
+        *output << "Use what?\n";
+        return CommandStatus::MISSING_TARGET;
     }
     
     Item* item = player->findItem(itemName);
     if (!item) {
-        std::cout << "You don't have a " << itemName << ".\n";
-        return;
+        std::vector<std::string> guesses = guessItem(itemName, false, true);
+        if (guesses.size() == 1) {
+            return handleUse(announceGuess(guesses[0]));
+        }
+        *output << "You don't have a " << itemName << ".\n";
+        suggestGuesses(guesses);
+        return CommandStatus::ITEM_NOT_FOUND;
     }
     
+    // Use scripts only run for items that can be used at all
     if (!item->getCanUse()) {
-        std::cout << "You can't use that.\n";
-        return;
+        *output << "You can't use that.\n";
+        return CommandStatus::CANNOT_USE;
+    }
+    
+    if (runItemScript(ScriptEvent::USE, itemName)) {
+        return CommandStatus::OK;
+    }
+    item = player->findItem(itemName);
+    if (!item) {
+        return CommandStatus::OK; // consumed by the script
     }
     
     std::string result = item->use();
-    std::cout << result << "\n";
+    *output << result << "\n";
     
     // Handle special item effects
     if (item->getType() == ItemType::CONSUMABLE) {
         Consumable* consumable = dynamic_cast<Consumable*>(item);
         if (consumable) {
-            player->heal(consumable->getHealAmount());
+            player->heal(consumable->getHealAmount(), *output);
             player->removeItem(itemName); // Consumable items are removed after use
             gameScore += 5;
         }
     }
+    return CommandStatus::OK;
+}
+
+CommandStatus Game::handleAttack(const std::string& target) {
+    TraceSpan span("handleAttack");
+    if (target.empty()) {
+        *output << "Attack what?\n";
+        return CommandStatus::MISSING_TARGET;
+    }
+    
+    int creature = simulation.findCreature(currentRoomId, target);
+    if (creature == -1) {
+        *output << "There's no " << target << " here to fight.\n";
+        return CommandStatus::NO_CREATURE;
+    }
+    
+    Weapon* weapon = player->getBestWeapon();
+    int damage = weapon ? weapon->getDamage() : UNARMED_DAMAGE;
+    std::string name = simulation.getCreatureName(creature);
+    int remaining = simulation.damageCreature(creature, damage);
+    
+    *output << "You strike the " << name << " with your "
+              << (weapon ? weapon->getName() : "fists") << " for " << damage << " damage.\n";
+    if (remaining == 0) {
+        *output << "The " << name << " collapses and moves no more.\n";
+        gameScore += 25;
+    }
+    return CommandStatus::OK;
+}
+
+std::vector<std::string> Game::guessVerb(const std::string& verb) const {
+    std::vector<std::string> guesses;
+    std::vector<SpellingIndex::Match> matches = verbIndex().lookup(verb, allowedEdits(verb));
+    for (const SpellingIndex::Match& match : matches) {
+        if (match.distance > matches[0].distance || guesses.size() == MAX_GUESSES) break;
+        guesses.emplace_back(match.word);
+    }
+    return guesses;
+}
+
+std::vector<std::string> Game::guessItem(const std::string& name, bool inRoom, bool inInventory) {
+    std::vector<std::string> guesses;
+    if (!itemNames) return guesses;
+    
+    Room* room = inRoom ? getCurrentRoom() : nullptr;
+    int bestDistance = SpellingIndex::MAX_DISTANCE + 1;
+    for (const SpellingIndex::Match& match : itemNames->lookup(name, allowedEdits(name))) {
+        if (match.distance > bestDistance || guesses.size() == MAX_GUESSES) break;
+        std::string candidate(match.word);
+        if ((room && room->findItem(candidate)) || (inInventory && player->findItem(candidate))) {
+            bestDistance = match.distance;
+            guesses.push_back(std::move(candidate));
+        }
+    }
+    return guesses;
+}
+
+const std::string& Game::announceGuess(const std::string& guess) {
+    *output << "(I assume you mean \"" << guess << "\".)\n";
+    return guess;
+}
+
+void Game::suggestGuesses(const std::vector<std::string>& guesses) {
+    if (guesses.empty()) return;
+    *output << "Did you mean ";
+    for (size_t i = 0; i < guesses.size(); ++i) {
+        if (i > 0) {
+            *output << (i + 1 == guesses.size() ? " or " : ", ");
+        }
+        *output << "\"" << guesses[i] << "\"";
+    }
+    *output << "?\n";
+}
+
+bool Game::runItemScript(ScriptEvent event, const std::string& itemName) {
+    const Script* script = scripts ? scripts->findItemScript(event, itemName) : nullptr;
+    return script && script->run(*this, itemName) == ScriptResult::CANCELLED;
+}
+
+bool Game::runEnterScript(int roomId) {
+    const Script* script = scripts ? scripts->findEnterScript(roomId) : nullptr;
+    return script && script->run(*this, std::string()) == ScriptResult::CANCELLED;
+}
+
+void Game::scriptDestroyItem(const std::string& itemName) {
+    if (player->removeItem(itemName)) return;
+    Room* room = getCurrentRoom();
+    if (room) {
+        room->removeItem(itemName);
+    }
+}
+
+bool Game::scriptIsLocked(int roomId) {
+    Room* room = findRoom(roomId);
+    return room && room->isLocked();
+}
+
+void Game::scriptSetLocked(int roomId, bool locked) {
+    Room* room = findRoom(roomId);
+    if (room) {
+        room->setLocked(locked);
+    }
+}
+
+void Game::displayLeaderboard() {
+    if (!leaderboard) {
+        *output << "No leaderboard is being kept.\n";
+        return;
+    }
+    std::vector<ScoreEntry> best = leaderboard->getTop();
+    *output << "\n=== LEADERBOARD ===\n";
+    if (best.empty()) {
+        *output << "No games recorded yet.\n";
+    }
+    for (size_t i = 0; i < best.size(); ++i) {
+        *output << "  " << i + 1 << ". " << best[i].name << " - " << best[i].score << "\n";
+    }
+    *output << "(" << leaderboard->getTotalGames() << " games recorded)\n";
+    *output << "===================\n";
+}
+
+void Game::displayRank() {
+    if (!leaderboard) {
+        *output << "No leaderboard is being kept.\n";
+        return;
+    }
+    *output << "Your score of " << gameScore << " would rank #" << leaderboard->getRank(gameScore)
+            << " of " << leaderboard->getTotalGames() + 1 << " games.\n";
+}
+
+void Game::displayMemoryStats() {
+    MemoryUsage now = measureMemory();
+    *output << "Session memory: " << now.total() << " bytes (";
+    now.print(*output);
+    *output << ")\nHigh-water:     " << std::max(memoryPeakTotal, now.total()) << " bytes (";
+    memoryPeak.print(*output);
+    *output << ", each at its own peak)\n";
 }
 
 void Game::displayHelp() {
-    std::cout << "\n=== AVAILABLE COMMANDS ===\n";
-    std::cout << "Movement:\n";
-    std::cout << "  go <direction>, north, south, east, west, up, down\n";
-    std::cout << "  (or use shortcuts: n, s, e, w, u, d)\n";
-    std::cout << "\nInteraction:\n";
-    std::cout << "  look - examine your surroundings\n";
-    std::cout << "  examine <item> - look at something closely\n";
-    std::cout << "  take <item> - pick up an item\n";
-    std::cout << "  drop <item> - drop an item\n";
-    std::cout << "  use <item> - use an item\n";
-    std::cout << "\nInformation:\n";
-    std::cout << "  inventory (i) - check your items\n";
-    std::cout << "  status - check your health\n";
-    std::cout << "  score - check your current score\n";
-    std::cout << "  help (h) - show this help\n";
-    std::cout << "\nGame Control:\n";
-    std::cout << "  quit (q) - exit the game\n";
-    std::cout << "===========================\n";
+    *output << "\n=== AVAILABLE COMMANDS ===\n";
+    *output << "Movement:\n";
+    *output << "  go <direction>, north, south, east, west, up, down\n";
+    *output << "  (or use shortcuts: n, s, e, w, u, d)\n";
+    *output << "\nInteraction:\n";
+    *output << "  look - examine your surroundings\n";
+    *output << "  examine <item> - look at something closely\n";
+    *output << "  take <item> - pick up an item\n";
+    *output << "  drop <item> - drop an item\n";
+    *output << "  use <item> - use an item\n";
+    *output << "  attack <creature> - fight with your best weapon\n";
+    *output << "\nInformation:\n";
+    *output << "  inventory (i) - check your items\n";
+    *output << "  status - check your health\n";
+    *output << "  score - check your current score\n";
+    *output << "  leaderboard - best recorded games\n";
+    *output << "  rank - where your score would place\n";
+    *output << "  help (h) - show this help\n";
+    *output << "\nGame Control:\n";
+    *output << "  quit (q) - exit the game\n";
+    *output << "\nChain commands with ',', '.' or 'then':\n";
+    *output << "  take seashell, take driftwood then go west\n";
+    *output << "  n.n.w\n";
+    *output << "===========================\n";
 }
 
 void Game::displayInventory() {
-    player->displayInventory();
+    TraceSpan span("displayInventory");
+    player->displayInventory(*output);
 }
 
 void Game::displayRoom() {
+    TraceSpan span("displayRoom");
     Room* room = getCurrentRoom();
     if (room) {
-        room->displayRoom();
+        room->displayRoom(*output);
+        for (const std::string& line : simulation.describeRoom(currentRoomId)) {
+            *output << line << "\n";
+        }
     }
 }
 
-Room* Game::getCurrentRoom() const {
-    auto it = rooms.find(currentRoomId);
+Room* Game::getCurrentRoom() {
+    return findRoom(currentRoomId);
+}
+
+const Room* Game::peekCurrentRoom() const {
+    return peekRoom(currentRoomId);
+}
+
+const Room* Game::peekRoom(int roomId) const {
+    if (regionPager) {
+        return regionPager->peekRoom(roomId);
+    }
+    auto it = rooms.find(roomId);
+    return (it != rooms.end()) ? it->second.get() : nullptr;
+}
+
+bool Game::isRoomLocked(int roomId) const {
+    if (regionPager) {
+        return regionPager->isLocked(roomId);
+    }
+    const Room* room = peekRoom(roomId);
+    return room && room->isLocked();
+}
+
+Room* Game::findRoom(int roomId) {
+    if (regionPager) {
+        return regionPager->getRoom(roomId);
+    }
+    auto it = rooms.find(roomId);
     return (it != rooms.end()) ? it->second.get() : nullptr;
 }
 
@@ -321,25 +829,64 @@ bool Game::getFlag(const std::string& flag) const {
 }
 
 void Game::updateGameState() {
+    TraceSpan span("updateGameState");
     // Update game state based on player actions and flags
     if (player->hasItem("torch") && !getFlag("has_torch")) {
         setFlag("has_torch", true);
     }
+    
+    // Advance the world by the ticks that passed in real time, bounded so a
+    // long pause at the prompt doesn't turn into an unavoidable death.
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTickTime).count();
+    int ticks = static_cast<int>(std::min<long long>(MAX_TICKS_PER_COMMAND,
+        std::max<long long>(1, elapsed * WorldSimulation::TICKS_PER_SECOND / 1000)));
+    if (ticksPerCommand > 0) {
+        ticks = ticksPerCommand;
+    }
+    lastTickTime = now;
+    
+    TickReport report = simulation.advance(ticks);
+    for (const std::string& message : report.messages) {
+        *output << message << "\n";
+    }
+    player->takeDamage(report.damageToPlayer, *output);
 }
 
 void Game::checkWinCondition() {
+    TraceSpan span("checkWinCondition");
     if (currentRoomId == 10 && player->hasItem("ancient treasure")) {
-        std::cout << "\n========================================\n";
-        std::cout << "🎉 CONGRATULATIONS! 🎉\n";
-        std::cout << "You have found the ancient treasure and\n";
-        std::cout << "discovered a way off the forgotten island!\n";
-        std::cout << "Your adventure is complete!\n";
-        std::cout << "========================================\n";
-        std::cout << "Final Score: " << gameScore + 100 << "\n";
-        gameRunning = false;
+        *output << "\n========================================\n";
+        *output << "🎉 CONGRATULATIONS! 🎉\n";
+        *output << "You have found the ancient treasure and\n";
+        *output << "discovered a way off the forgotten island!\n";
+        *output << "Your adventure is complete!\n";
+        *output << "========================================\n";
+        gameScore += 100;
+        *output << "Final Score: " << gameScore << "\n";
+        endGame();
     }
 }
 
+const char* commandStatusName(CommandStatus status) {
+    switch (status) {
+        case CommandStatus::OK: return "ok";
+        case CommandStatus::UNKNOWN_COMMAND: return "unknown_command";
+        case CommandStatus::MISSING_TARGET: return "missing_target";
+        case CommandStatus::NO_EXIT: return "no_exit";
+        case CommandStatus::NO_ROOM: return "no_room";
+        case CommandStatus::LOCKED: return "locked";
+        case CommandStatus::ITEM_NOT_FOUND: return "item_not_found";
+        case CommandStatus::CANNOT_TAKE: return "cannot_take";
+        case CommandStatus::INVENTORY_FULL: return "inventory_full";
+        case CommandStatus::CANNOT_USE: return "cannot_use";
+        case CommandStatus::NO_CREATURE: return "no_creature";
+        case CommandStatus::QUIT: return "quit";
+        case CommandStatus::GAME_OVER: return "game_over";
+    }
+    return "unknown";
+}
+
 std::string Game::toLowerCase(const std::string& str) {
     std::string result = str;
     std::transform(result.begin(), result.end(), result.begin(), ::tolower);
@@ -359,5 +906,9 @@ std::vector<std::string> Game::splitCommand(const std::string& command) {
 }
 
 void Game::endGame() {
+    if (gameRunning && leaderboard && !scoreRecorded) {
+        leaderboard->submit(player->getName(), gameScore);
+        scoreRecorded = true;
+    }
     gameRunning = false;
 }
\ No newline at end of file
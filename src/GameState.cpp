@@ -0,0 +1,151 @@
+#include "Game.h"
+#include "Serialization.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    const uint8_t STATE_MAGIC = 'F';
+    const uint8_t STATE_VERSION = 2;
+    
+    enum RoomStateBits : uint8_t {
+        ROOM_VISITED = 1,
+        ROOM_LOCKED = 2
+    };
+}
+
+std::string Game::saveState() {
+    if (regionPager) {
+        throw std::logic_error("Session state snapshots need an in-memory world");
+    }
+    
+    std::string state;
+    ByteWriter writer(state);
+    writer.writeByte(STATE_MAGIC);
+    writer.writeByte(STATE_VERSION);
+    writer.writeInt(currentRoomId);
+    writer.writeByte(gameRunning ? 1 : 0);
+    writer.writeInt(gameScore);
+    
+    writer.writeVarint(gameFlags.size());
+    for (const auto& flag : gameFlags) {
+        writer.writeString(flag.first);
+        writer.writeByte(flag.second ? 1 : 0);
+    }
+    
+    writer.writeString(player->getName());
+    writer.writeInt(player->getHealth());
+    writer.writeVarint(player->getInventory().size());
+    for (const auto& item : player->getInventory()) {
+        writeItem(writer, *item);
+    }
+    
+    writer.writeVarint(rooms.size());
+    for (const auto& entry : rooms) {
+        const Room& room = *entry.second;
+        writer.writeInt(entry.first);
+        writer.writeByte((room.isVisited() ? ROOM_VISITED : 0) | (room.isLocked() ? ROOM_LOCKED : 0));
+        writer.writeVarint(room.getItems().size());
+        for (const auto& item : room.getItems()) {
+            writeItem(writer, *item);
+        }
+    }
+    
+    simulation.saveState(writer);
+    random.save(writer);
+    return state;
+}
+
+MemoryUsage Game::measureMemory() const {
+    MemoryUsage usage;
+    usage[MemoryCategory::WORLD] = sizeof(*this) + sizeof(Player) + simulation.memoryFootprint();
+    
+    for (const auto& entry : rooms) {
+        const Room& room = *entry.second;
+        size_t text = room.textFootprint();
+        usage[MemoryCategory::WORLD] += MAP_NODE_OVERHEAD + sizeof(entry) + room.memoryFootprint() - text;
+        usage[MemoryCategory::TEXT] += text;
+    }
+    if (regionPager) {
+        // Resident regions are budgeted as a whole, text included
+        usage[MemoryCategory::WORLD] += sizeof(RegionPager) + regionPager->getResidentBytes();
+    }
+    
+    const auto& inventory = player->getInventory();
+    usage[MemoryCategory::INVENTORY] = inventory.capacity() * sizeof(inventory[0]);
+    for (const auto& item : inventory) {
+        size_t text = item->textFootprint();
+        usage[MemoryCategory::INVENTORY] += item->memoryFootprint() - text;
+        usage[MemoryCategory::TEXT] += text;
+    }
+    usage[MemoryCategory::TEXT] += player->getName().capacity();
+    
+    for (const auto& flag : gameFlags) {
+        usage[MemoryCategory::FLAGS] += MAP_NODE_OVERHEAD + sizeof(flag) + flag.first.capacity();
+    }
+    usage[MemoryCategory::BUFFERS] = bufferBytes;
+    return usage;
+}
+
+void Game::noteMemoryUsage() {
+    memoryUsage = measureMemory();
+    memoryPeak.raiseTo(memoryUsage);
+    memoryPeakTotal = std::max(memoryPeakTotal, memoryUsage.total());
+}
+
+void Game::restoreState(const std::string& state) {
+    if (regionPager) {
+        throw std::logic_error("Session state snapshots need an in-memory world");
+    }
+    
+    ByteReader reader(state);
+    if (reader.readByte() != STATE_MAGIC || reader.readByte() != STATE_VERSION) {
+        throw std::runtime_error("Not a saved game state");
+    }
+    currentRoomId = static_cast<int>(reader.readInt());
+    gameRunning = reader.readByte() != 0;
+    gameScore = static_cast<int>(reader.readInt());
+    
+    gameFlags.clear();
+    uint64_t flagCount = reader.readVarint();
+    for (uint64_t i = 0; i < flagCount; ++i) {
+        std::string flag = reader.readString();
+        gameFlags[flag] = reader.readByte() != 0;
+    }
+    
+    player->setName(reader.readString());
+    player->setHealth(static_cast<int>(reader.readInt()));
+    player->clearInventory();
+    uint64_t inventoryCount = reader.readVarint();
+    for (uint64_t i = 0; i < inventoryCount; ++i) {
+        player->addItem(readItem(reader));
+    }
+    
+    uint64_t roomCount = reader.readVarint();
+    if (roomCount != rooms.size()) {
+        throw std::runtime_error("Saved state belongs to a different world");
+    }
+    for (uint64_t i = 0; i < roomCount; ++i) {
+        auto it = rooms.find(static_cast<int>(reader.readInt()));
+        if (it == rooms.end()) {
+            throw std::runtime_error("Saved state belongs to a different world");
+        }
+        Room& room = *it->second;
+        uint8_t bits = reader.readByte();
+        room.setVisited(bits & ROOM_VISITED);
+        room.setLocked(bits & ROOM_LOCKED);
+        room.clearItems();
+        uint64_t itemCount = reader.readVarint();
+        for (uint64_t j = 0; j < itemCount; ++j) {
+            room.addItem(readItem(reader));
+        }
+    }
+    
+    simulation.restoreState(reader);
+    random.load(reader);
+    
+    quitRequested = false;
+    scoreRecorded = false;
+    roomRenderSuppressed = false;
+    roomRenderPending = false;
+    lastTickTime = std::chrono::steady_clock::now();
+}
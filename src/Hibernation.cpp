@@ -0,0 +1,125 @@
+#include "Hibernation.h"
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+HibernationStore::HibernationStore(const std::string& pristineState, const std::string& spillPath)
+    : dictionary(pristineState), spillFd(-1), spillEnd(0), diskBytes(0), memoryBytes(0) {
+    if (!spillPath.empty()) {
+        spillFd = open(spillPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (spillFd < 0) {
+            throw std::runtime_error("Cannot open spill file " + spillPath + ": " + std::strerror(errno));
+        }
+        unlink(spillPath.c_str());
+    }
+}
+
+HibernationStore::~HibernationStore() {
+    if (spillFd >= 0) {
+        close(spillFd);
+    }
+}
+
+HibernationStore::Ticket HibernationStore::store(const std::string& state) {
+    Ticket ticket;
+    std::string blob = dictionary.compress(state);
+    ticket.length = static_cast<uint32_t>(blob.size());
+    
+    if (spillFd >= 0 && !blob.empty()) {
+        uint64_t offset = allocate(blob.size());
+        ssize_t written = pwrite(spillFd, blob.data(), blob.size(), static_cast<off_t>(offset));
+        if (written == static_cast<ssize_t>(blob.size())) {
+            ticket.offset = static_cast<int64_t>(offset);
+            diskBytes += blob.size();
+            return ticket;
+        }
+        // Disk full or similar: keep this one in memory instead
+        release(offset, blob.size());
+    }
+    ticket.blob = std::move(blob);
+    memoryBytes += ticket.length;
+    return ticket;
+}
+
+std::string HibernationStore::load(Ticket& ticket) {
+    std::string blob;
+    if (ticket.offset >= 0) {
+        blob.resize(ticket.length);
+        ssize_t got = pread(spillFd, blob.data(), blob.size(), static_cast<off_t>(ticket.offset));
+        if (got != static_cast<ssize_t>(blob.size())) {
+            throw std::runtime_error("Cannot read hibernated session from spill file");
+        }
+    } else {
+        blob.swap(ticket.blob);
+    }
+    discard(ticket);
+    return dictionary.decompress(blob);
+}
+
+void HibernationStore::discard(Ticket& ticket) {
+    if (ticket.offset >= 0) {
+        diskBytes -= ticket.length;
+        release(static_cast<uint64_t>(ticket.offset), ticket.length);
+    } else {
+        memoryBytes -= ticket.length;
+    }
+    ticket = Ticket();
+}
+
+uint64_t HibernationStore::allocate(uint64_t length) {
+    // The smallest free extent that fits; the file only grows when none does
+    auto fit = freeBySize.lower_bound({length, 0});
+    if (fit == freeBySize.end()) {
+        uint64_t offset = spillEnd;
+        spillEnd += length;
+        return offset;
+    }
+    uint64_t offset = fit->second;
+    uint64_t spare = fit->first - length;
+    removeExtent(freeExtents.find(offset));
+    if (spare > 0) {
+        addExtent(offset + length, spare);
+    }
+    return offset;
+}
+
+void HibernationStore::release(uint64_t offset, uint64_t length) {
+    // Merge with the free neighbours on either side
+    auto next = freeExtents.lower_bound(offset);
+    if (next != freeExtents.end() && next->first == offset + length) {
+        length += next->second;
+        removeExtent(next);
+    }
+    next = freeExtents.lower_bound(offset);
+    if (next != freeExtents.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            length += previous->second;
+            removeExtent(previous);
+        }
+    }
+    
+    if (offset + length < spillEnd) {
+        addExtent(offset, length);
+        return;
+    }
+    // The tail of the file is free: give it back
+    spillEnd = offset;
+    if (ftruncate(spillFd, static_cast<off_t>(spillEnd)) != 0) {
+        // Harmless: the space past spillEnd is reused either way
+    }
+}
+
+void HibernationStore::addExtent(uint64_t offset, uint64_t length) {
+    freeExtents.emplace(offset, length);
+    freeBySize.emplace(length, offset);
+}
+
+void HibernationStore::removeExtent(std::map<uint64_t, uint64_t>::iterator extent) {
+    freeBySize.erase({extent->second, extent->first});
+    freeExtents.erase(extent);
+}
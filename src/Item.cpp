@@ -1,5 +1,6 @@
 #include "Item.h"
 #include <iostream>
+#include <stdexcept>
 
 // Base Item class implementation
 Item::Item(const std::string& itemName, const std::string& desc, ItemType itemType)
@@ -13,20 +14,20 @@ std::string Item::use() {
     return "You use the " + name + ".";
 }
 
-void Item::examine() const {
-    std::cout << "Looking at the " << name << ":\n";
-    std::cout << description << "\n";
+void Item::examine(std::ostream& os) const {
+    os << "Looking at the " << name << ":\n";
+    os << description << "\n";
     
     if (value > 0) {
-        std::cout << "This item appears to be worth " << value << " gold.\n";
+        os << "This item appears to be worth " << value << " gold.\n";
     }
     
     if (canTake) {
-        std::cout << "You can take this item.\n";
+        os << "You can take this item.\n";
     }
     
     if (canUse) {
-        std::cout << "This item can be used.\n";
+        os << "This item can be used.\n";
     }
 }
 
@@ -41,6 +42,10 @@ std::string Item::getTypeString() const {
     }
 }
 
+size_t Item::memoryFootprint() const {
+    return sizeof(*this) + name.capacity() + description.memoryFootprint();
+}
+
 // Key class implementation
 Key::Key(const std::string& keyName, const std::string& desc, const std::string& unlocksWhat)
     : Item(keyName, desc, ItemType::KEY), unlocks(unlocksWhat) {
@@ -81,13 +86,40 @@ Treasure::Treasure(const std::string& treasureName, const std::string& desc, int
     canUse = false;
 }
 
-void Treasure::examine() const {
-    std::cout << "Looking at the " << name << ":\n";
-    std::cout << description << "\n";
-    std::cout << "This treasure is worth " << value << " gold! ";
-    std::cout << "It would fetch a handsome price from any collector.\n";
+void Treasure::examine(std::ostream& os) const {
+    os << "Looking at the " << name << ":\n";
+    os << description << "\n";
+    os << "This treasure is worth " << value << " gold! ";
+    os << "It would fetch a handsome price from any collector.\n";
     
     if (canTake) {
-        std::cout << "You can take this valuable item.\n";
+        os << "You can take this valuable item.\n";
+    }
+}
+
+// Item factory
+std::unique_ptr<Item> createItem(ItemType type, const std::string& name, const std::string& desc,
+                                 const std::string& param) {
+    switch (type) {
+        case ItemType::KEY:
+            return std::make_unique<Key>(name, desc, param);
+        case ItemType::WEAPON:
+            return std::make_unique<Weapon>(name, desc, param.empty() ? 0 : std::stoi(param));
+        case ItemType::CONSUMABLE:
+            return std::make_unique<Consumable>(name, desc, param.empty() ? 0 : std::stoi(param));
+        case ItemType::TREASURE:
+            return std::make_unique<Treasure>(name, desc, param.empty() ? 0 : std::stoi(param));
+        default:
+            return std::make_unique<Item>(name, desc, type);
     }
+}
+
+ItemType parseItemType(const std::string& typeName) {
+    if (typeName == "item") return ItemType::GENERIC;
+    if (typeName == "weapon") return ItemType::WEAPON;
+    if (typeName == "key") return ItemType::KEY;
+    if (typeName == "consumable") return ItemType::CONSUMABLE;
+    if (typeName == "treasure") return ItemType::TREASURE;
+    if (typeName == "tool") return ItemType::TOOL;
+    throw std::runtime_error("Unknown item type: " + typeName);
 }
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "Leaderboard.h"
+#include "Serialization.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    // File layout: magic, then one record per game (varint score, string name)
+    const char FILE_MAGIC[] = {'F', 'I', 'L', 'B', 1};
+    
+    int clampScore(int score) {
+        return std::max(0, std::min(score, Leaderboard::MAX_SCORE));
+    }
+    
+    bool ranksBefore(const ScoreEntry& a, const ScoreEntry& b) {
+        return a.score != b.score ? a.score > b.score : a.sequence < b.sequence;
+    }
+}
+
+Leaderboard::Leaderboard(const std::string& filePath)
+    : tree(MAX_SCORE + 2, 0), totalGames(0), path(filePath) {
+    if (!path.empty()) {
+        load();
+    }
+}
+
+Leaderboard::~Leaderboard() {
+    try {
+        flush();
+    } catch (...) {
+        // Scores that cannot be written are lost with the process anyway
+    }
+}
+
+void Leaderboard::load() {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::ofstream created(path, std::ios::binary);
+        if (!created) {
+            throw std::runtime_error("Cannot create leaderboard file: " + path);
+        }
+        created.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        return;
+    }
+    
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.compare(0, sizeof(FILE_MAGIC), std::string(FILE_MAGIC, sizeof(FILE_MAGIC))) != 0) {
+        throw std::runtime_error("Not a leaderboard file: " + path);
+    }
+    
+    // Count scores first and build the Fenwick tree in one linear pass
+    ByteReader reader(data);
+    for (size_t i = 0; i < sizeof(FILE_MAGIC); ++i) {
+        reader.readByte();
+    }
+    size_t validLength = reader.position();
+    try {
+        while (!reader.atEnd()) {
+            ScoreEntry entry;
+            entry.score = clampScore(static_cast<int>(reader.readVarint()));
+            entry.name = reader.readString();
+            entry.sequence = totalGames++;
+            ++tree[entry.score + 1];
+            insertTop(entry);
+            validLength = reader.position();
+        }
+    } catch (const std::runtime_error&) {
+        // A crash mid-append leaves a partial record; drop it
+    }
+    for (size_t i = 1; i < tree.size(); ++i) {
+        size_t parent = i + (i & (~i + 1));
+        if (parent < tree.size()) {
+            tree[parent] += tree[i];
+        }
+    }
+    
+    file.close();
+    if (validLength < data.size()) {
+        std::filesystem::resize_file(path, validLength);
+    }
+}
+
+void Leaderboard::append(const std::vector<ScoreEntry>& batch) {
+    if (path.empty()) {
+        return;
+    }
+    std::string records;
+    ByteWriter writer(records);
+    for (const ScoreEntry& entry : batch) {
+        writer.writeVarint(static_cast<uint64_t>(entry.score));
+        writer.writeString(entry.name);
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write(records.data(), static_cast<std::streamsize>(records.size()));
+    if (!file) {
+        throw std::runtime_error("Cannot append to leaderboard file: " + path);
+    }
+}
+
+void Leaderboard::submit(const std::string& name, int score) {
+    size_t index = std::hash<std::thread::id>()(std::this_thread::get_id()) % SHARD_COUNT;
+    Shard& shard = shards[index];
+    
+    std::vector<ScoreEntry> batch;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.pending.push_back(ScoreEntry{name, clampScore(score), 0});
+        if (shard.pending.size() < FLUSH_THRESHOLD) {
+            return;
+        }
+        batch.swap(shard.pending);
+    }
+    merge(batch);
+}
+
+void Leaderboard::flush() {
+    for (Shard& shard : shards) {
+        std::vector<ScoreEntry> batch;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            batch.swap(shard.pending);
+        }
+        if (!batch.empty()) {
+            merge(batch);
+        }
+    }
+}
+
+void Leaderboard::merge(std::vector<ScoreEntry>& batch) {
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    for (ScoreEntry& entry : batch) {
+        entry.sequence = totalGames++;
+        insert(entry);
+    }
+    append(batch);
+}
+
+void Leaderboard::insert(const ScoreEntry& entry) {
+    for (size_t i = static_cast<size_t>(entry.score) + 1; i < tree.size(); i += i & (~i + 1)) {
+        ++tree[i];
+    }
+    insertTop(entry);
+}
+
+void Leaderboard::insertTop(const ScoreEntry& entry) {
+    if (top.size() == TOP_K && !ranksBefore(entry, top.back())) {
+        return;
+    }
+    top.insert(std::upper_bound(top.begin(), top.end(), entry, ranksBefore), entry);
+    if (top.size() > TOP_K) {
+        top.pop_back();
+    }
+}
+
+uint64_t Leaderboard::countAtMost(int score) const {
+    uint64_t count = 0;
+    for (size_t i = static_cast<size_t>(score) + 1; i > 0; i -= i & (~i + 1)) {
+        count += tree[i];
+    }
+    return count;
+}
+
+std::vector<ScoreEntry> Leaderboard::getTop(size_t count) {
+    flush();
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    return std::vector<ScoreEntry>(top.begin(), top.begin() + std::min(count, top.size()));
+}
+
+uint64_t Leaderboard::getRank(int score) {
+    flush();
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    return 1 + totalGames - countAtMost(clampScore(score));
+}
+
+uint64_t Leaderboard::getTotalGames() {
+    flush();
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    return totalGames;
+}
@@ -0,0 +1,46 @@
+#include "MemoryUsage.h"
+
+const char* memoryCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::WORLD: return "world";
+        case MemoryCategory::INVENTORY: return "inventory";
+        case MemoryCategory::TEXT: return "text";
+        case MemoryCategory::FLAGS: return "flags";
+        case MemoryCategory::BUFFERS: return "buffers";
+    }
+    return "unknown";
+}
+
+size_t MemoryUsage::total() const {
+    size_t sum = 0;
+    for (size_t value : bytes) {
+        sum += value;
+    }
+    return sum;
+}
+
+void MemoryUsage::add(const MemoryUsage& other) {
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+        bytes[i] += other.bytes[i];
+    }
+}
+
+void MemoryUsage::subtract(const MemoryUsage& other) {
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+        bytes[i] -= other.bytes[i];
+    }
+}
+
+void MemoryUsage::raiseTo(const MemoryUsage& other) {
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+        if (other.bytes[i] > bytes[i]) {
+            bytes[i] = other.bytes[i];
+        }
+    }
+}
+
+void MemoryUsage::print(std::ostream& os) const {
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+        os << (i ? ", " : "") << memoryCategoryName(static_cast<MemoryCategory>(i)) << " " << bytes[i];
+    }
+}
@@ -0,0 +1,145 @@
+#include "Migration.h"
+#include "Serialization.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    const uint8_t SESSION_VERSION = 1;
+    const size_t SEND_BUFFER_BYTES = 4 * 1024 * 1024;
+    
+    std::runtime_error systemError(const std::string& what) {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+}
+
+int migration::connectControl(const std::string& path, int timeoutMs) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+    timeval timeout{};
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    // Room for a burst of sessions, so a drain does not wait on every one the target reads
+    int bufferBytes = static_cast<int>(SEND_BUFFER_BYTES);
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        throw systemError("Cannot connect to " + path);
+    }
+    return fd;
+}
+
+void migration::sendMessage(int socketFd, const std::string& payload, int passFd) {
+    iovec part{const_cast<char*>(payload.data()), payload.size()};
+    msghdr message{};
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (passFd >= 0) {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(header), &passFd, sizeof(int));
+    }
+    
+    while (sendmsg(socketFd, &message, MSG_NOSIGNAL) < 0) {
+        if (errno != EINTR) {
+            throw systemError("sendmsg");
+        }
+    }
+}
+
+migration::Receive migration::receiveMessage(int socketFd, std::string& payload, int& passedFd) {
+    passedFd = -1;
+    
+    // Size the buffer first; a sequenced packet can only be read whole
+    char probe;
+    ssize_t length;
+    while ((length = recv(socketFd, &probe, 1, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT)) < 0 && errno == EINTR) {
+    }
+    if (length < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return Receive::WOULD_BLOCK;
+        }
+        return Receive::CLOSED;
+    }
+    if (length == 0) {
+        return Receive::CLOSED; // end of stream; no empty messages are ever sent
+    }
+    payload.resize(static_cast<size_t>(length));
+    
+    iovec part{payload.data(), payload.size()};
+    msghdr message{};
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    
+    ssize_t received;
+    while ((received = recvmsg(socketFd, &message, MSG_CMSG_CLOEXEC | MSG_DONTWAIT)) < 0 && errno == EINTR) {
+    }
+    if (received != length) {
+        return Receive::CLOSED;
+    }
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            std::memcpy(&passedFd, CMSG_DATA(header), sizeof(int));
+        }
+    }
+    if (message.msg_flags & MSG_CTRUNC) {
+        // More descriptors than expected: the peer is not one of ours
+        if (passedFd >= 0) {
+            close(passedFd);
+            passedFd = -1;
+        }
+        return Receive::CLOSED;
+    }
+    return Receive::MESSAGE;
+}
+
+std::string migration::encodeSession(const MigratedSession& session) {
+    std::string payload;
+    ByteWriter writer(payload);
+    writer.writeByte(static_cast<uint8_t>(SESSION_MESSAGE));
+    writer.writeByte(SESSION_VERSION);
+    writer.writeVarint(session.traceSession);
+    writer.writeByte(session.tracing ? 1 : 0);
+    writer.writeString(session.state);
+    writer.writeString(session.input);
+    writer.writeString(session.output);
+    return payload;
+}
+
+MigratedSession migration::decodeSession(const std::string& payload, int fd) {
+    ByteReader reader(payload);
+    if (reader.readByte() != static_cast<uint8_t>(SESSION_MESSAGE) || reader.readByte() != SESSION_VERSION) {
+        throw std::runtime_error("Not a migrated session");
+    }
+    MigratedSession session;
+    session.traceSession = reader.readVarint();
+    session.tracing = reader.readByte() != 0;
+    session.state = reader.readString();
+    session.input = reader.readString();
+    session.output = reader.readString();
+    session.fd = fd;
+    return session;
+}
@@ -0,0 +1,13 @@
+#include "OutputBuffer.h"
+
+OutputBuffer::int_type OutputBuffer::overflow(int_type ch) {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        text.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize OutputBuffer::xsputn(const char* data, std::streamsize count) {
+    text.append(data, static_cast<size_t>(count));
+    return count;
+}
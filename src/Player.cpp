@@ -8,26 +8,26 @@ Player::Player(const std::string& playerName)
 
 Player::~Player() = default;
 
-void Player::heal(int amount) {
+void Player::heal(int amount, std::ostream& os) {
     if (amount > 0) {
         health = std::min(health + amount, maxHealth);
-        std::cout << "You feel better! Health restored by " << amount << " points.\n";
-        std::cout << "Current health: " << health << "/" << maxHealth << "\n";
+        os << "You feel better! Health restored by " << amount << " points.\n";
+        os << "Current health: " << health << "/" << maxHealth << "\n";
     }
 }
 
-void Player::takeDamage(int amount) {
+void Player::takeDamage(int amount, std::ostream& os) {
     if (amount > 0) {
         health = std::max(0, health - amount);
-        std::cout << "You take " << amount << " damage!\n";
-        std::cout << "Current health: " << health << "/" << maxHealth << "\n";
+        os << "You take " << amount << " damage!\n";
+        os << "Current health: " << health << "/" << maxHealth << "\n";
         
         if (health <= 0) {
-            std::cout << "You have been defeated!\n";
+            os << "You have been defeated!\n";
         } else if (health <= 20) {
-            std::cout << "You are badly injured!\n";
+            os << "You are badly injured!\n";
         } else if (health <= 50) {
-            std::cout << "You are hurt.\n";
+            os << "You are hurt.\n";
         }
     }
 }
@@ -71,49 +71,71 @@ bool Player::hasItem(const std::string& itemName) const {
     return findItem(itemName) != nullptr;
 }
 
-void Player::displayInventory() const {
+std::vector<std::string> Player::getItemNames() const {
+    std::vector<std::string> names;
+    names.reserve(inventory.size());
+    for (const auto& item : inventory) {
+        if (item) {
+            names.push_back(item->getName());
+        }
+    }
+    return names;
+}
+
+Weapon* Player::getBestWeapon() const {
+    Weapon* best = nullptr;
+    for (const auto& item : inventory) {
+        Weapon* weapon = dynamic_cast<Weapon*>(item.get());
+        if (weapon && (!best || weapon->getDamage() > best->getDamage())) {
+            best = weapon;
+        }
+    }
+    return best;
+}
+
+void Player::displayInventory(std::ostream& os) const {
     if (inventory.empty()) {
-        std::cout << "Your inventory is empty.\n";
+        os << "Your inventory is empty.\n";
         return;
     }
     
-    std::cout << "\n=== INVENTORY ===\n";
-    std::cout << "Carrying " << inventory.size() << "/" << maxInventorySize << " items:\n";
+    os << "\n=== INVENTORY ===\n";
+    os << "Carrying " << inventory.size() << "/" << maxInventorySize << " items:\n";
     
     for (const auto& item : inventory) {
         if (item) {
-            std::cout << "  " << item->getName();
+            os << "  " << item->getName();
             if (item->getValue() > 0) {
-                std::cout << " (Value: " << item->getValue() << " gold)";
+                os << " (Value: " << item->getValue() << " gold)";
             }
-            std::cout << "\n";
+            os << "\n";
         }
     }
-    std::cout << "================\n";
+    os << "================\n";
 }
 
-void Player::displayStatus() const {
-    std::cout << "\n=== CHARACTER STATUS ===\n";
-    std::cout << "Name: " << name << "\n";
-    std::cout << "Health: " << health << "/" << maxHealth;
+void Player::displayStatus(std::ostream& os) const {
+    os << "\n=== CHARACTER STATUS ===\n";
+    os << "Name: " << name << "\n";
+    os << "Health: " << health << "/" << maxHealth;
     
     if (health == maxHealth) {
-        std::cout << " (Perfect health)";
+        os << " (Perfect health)";
     } else if (health >= maxHealth * 0.8) {
-        std::cout << " (Slightly injured)";
+        os << " (Slightly injured)";
     } else if (health >= maxHealth * 0.6) {
-        std::cout << " (Moderately injured)";
+        os << " (Moderately injured)";
     } else if (health >= maxHealth * 0.4) {
-        std::cout << " (Badly injured)";
+        os << " (Badly injured)";
     } else if (health >= maxHealth * 0.2) {
-        std::cout << " (Severely injured)";
+        os << " (Severely injured)";
     } else if (health > 0) {
-        std::cout << " (Critically injured)";
+        os << " (Critically injured)";
     } else {
-        std::cout << " (Unconscious)";
+        os << " (Unconscious)";
     }
     
-    std::cout << "\n";
-    std::cout << "Inventory: " << inventory.size() << "/" << maxInventorySize << " items\n";
-    std::cout << "=======================\n";
+    os << "\n";
+    os << "Inventory: " << inventory.size() << "/" << maxInventorySize << " items\n";
+    os << "=======================\n";
 }
\ No newline at end of file
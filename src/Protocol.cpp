@@ -0,0 +1,423 @@
+#include "Protocol.h"
+#include "StateDelta.h"
+#include <charconv>
+
+// ---------------------------------------------------------------------------
+// JsonWriter
+
+JsonWriter::JsonWriter(std::string& buffer) : out(buffer), needComma(), depth(0) {
+}
+
+void JsonWriter::separator() {
+    if (depth > 0 && needComma[depth - 1]) {
+        out.push_back(',');
+    }
+    if (depth > 0) {
+        needComma[depth - 1] = true;
+    }
+}
+
+void JsonWriter::writeKey(std::string_view name) {
+    separator();
+    string(name);
+    out.push_back(':');
+}
+
+void JsonWriter::beginObject() {
+    separator();
+    out.push_back('{');
+    needComma[depth++] = false;
+}
+
+void JsonWriter::beginObject(std::string_view name) {
+    writeKey(name);
+    out.push_back('{');
+    needComma[depth++] = false;
+}
+
+void JsonWriter::endObject() {
+    out.push_back('}');
+    --depth;
+}
+
+void JsonWriter::beginArray(std::string_view name) {
+    writeKey(name);
+    out.push_back('[');
+    needComma[depth++] = false;
+}
+
+void JsonWriter::endArray() {
+    out.push_back(']');
+    --depth;
+}
+
+void JsonWriter::field(std::string_view name, long long value) {
+    writeKey(name);
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void JsonWriter::field(std::string_view name, bool value) {
+    writeKey(name);
+    out.append(value ? "true" : "false");
+}
+
+void JsonWriter::field(std::string_view name, std::string_view value) {
+    writeKey(name);
+    string(value);
+}
+
+void JsonWriter::rawField(std::string_view name, std::string_view json) {
+    writeKey(name);
+    out.append(json);
+}
+
+void JsonWriter::element(std::string_view value) {
+    separator();
+    string(value);
+}
+
+void JsonWriter::element(long long value) {
+    separator();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void JsonWriter::string(std::string_view value) {
+    static const char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char ch = static_cast<unsigned char>(value[i]);
+        if (ch >= 0x20 && ch != '"' && ch != '\\') {
+            continue;
+        }
+        out.append(value.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (ch) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\t': out.append("\\t"); break;
+            case '\r': out.append("\\r"); break;
+            default:
+                out.append("\\u00");
+                out.push_back(hex[ch >> 4]);
+                out.push_back(hex[ch & 0xf]);
+        }
+    }
+    out.append(value.data() + runStart, value.size() - runStart);
+    out.push_back('"');
+}
+
+// ---------------------------------------------------------------------------
+// Request parsing
+
+namespace {
+    // True for a JSON number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool isJsonNumber(std::string_view text) {
+        size_t i = 0;
+        auto digits = [&] {
+            size_t start = i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') ++i;
+            return i > start;
+        };
+        if (i < text.size() && text[i] == '-') ++i;
+        if (i < text.size() && text[i] == '0') {
+            ++i;
+        } else if (!digits()) {
+            return false;
+        }
+        if (i < text.size() && text[i] == '.') {
+            ++i;
+            if (!digits()) return false;
+        }
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+            ++i;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-')) ++i;
+            if (!digits()) return false;
+        }
+        return i == text.size();
+    }
+    
+    void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        } else {
+            out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        }
+    }
+    
+    struct Request {
+        std::string id = "null"; // re-serialized JSON: a number, a string or null
+        bool wantText = false;
+        bool hasCommand = false;
+        int trace = -1; // "trace": true/false switches session tracing; -1 leaves it
+        bool wantSession = false;
+        bool delta = false;
+        uint64_t ack = 0; // the client's latest state version, in delta mode
+    };
+    
+    class RequestParser {
+    private:
+        std::string_view line;
+        size_t pos;
+        
+        void skipSpace() {
+            while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) ++pos;
+        }
+        
+        bool expect(char ch) {
+            skipSpace();
+            if (pos < line.size() && line[pos] == ch) {
+                ++pos;
+                return true;
+            }
+            return false;
+        }
+        
+        bool parseHex(unsigned& code) {
+            if (pos + 4 > line.size()) return false;
+            auto result = std::from_chars(line.data() + pos, line.data() + pos + 4, code, 16);
+            if (result.ptr != line.data() + pos + 4) return false;
+            pos += 4;
+            return true;
+        }
+        
+        // Decodes a string literal into target (may be null to skip it).
+        // Strict decoding is for values that are echoed back: it rejects
+        // what JSON does not allow and keeps \u escapes as UTF-8.
+        bool parseString(std::string* target, bool strict = false) {
+            if (!expect('"')) return false;
+            while (pos < line.size()) {
+                char ch = line[pos++];
+                if (ch == '"') return true;
+                if (strict && static_cast<unsigned char>(ch) < 0x20) return false;
+                if (ch == '\\') {
+                    if (pos >= line.size()) return false;
+                    char escaped = line[pos++];
+                    switch (escaped) {
+                        case 'n': ch = '\n'; break;
+                        case 't': ch = '\t'; break;
+                        case 'r': ch = '\r'; break;
+                        case 'b': ch = '\b'; break;
+                        case 'f': ch = '\f'; break;
+                        case 'u': {
+                            unsigned code = 0;
+                            if (!parseHex(code)) return false;
+                            if (!strict) {
+                                // Commands are plain text; keep ASCII escapes, drop the rest
+                                ch = code < 0x80 ? static_cast<char>(code) : '?';
+                                break;
+                            }
+                            if (code >= 0xdc00 && code < 0xe000) return false;
+                            if (code >= 0xd800 && code < 0xdc00) {
+                                unsigned low = 0;
+                                if (line.substr(pos, 2) != "\\u") return false;
+                                pos += 2;
+                                if (!parseHex(low) || low < 0xdc00 || low >= 0xe000) return false;
+                                code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                            }
+                            if (target) appendUtf8(*target, code);
+                            continue;
+                        }
+                        case '"': case '\\': case '/': ch = escaped; break;
+                        default:
+                            if (strict) return false;
+                            ch = escaped;
+                            break;
+                    }
+                }
+                if (target) target->push_back(ch);
+            }
+            return false;
+        }
+        
+        // Reads an "id" value and stores it re-serialized; only a number, a
+        // string or null is accepted, so the reply always echoes valid JSON
+        bool parseId(std::string& id) {
+            id = "null";
+            if (line[pos] == '"') {
+                std::string decoded;
+                if (!parseString(&decoded, true)) return false;
+                id.clear();
+                JsonWriter(id).string(decoded);
+                return true;
+            }
+            std::string_view token = parseToken();
+            if (token != "null" && !isJsonNumber(token)) return false;
+            id = token;
+            return true;
+        }
+        
+        // Scans a number, true, false or null and returns its raw text
+        std::string_view parseToken() {
+            skipSpace();
+            size_t start = pos;
+            while (pos < line.size() && line[pos] != ',' && line[pos] != '}' &&
+                   line[pos] != ' ' && line[pos] != '\t') {
+                ++pos;
+            }
+            return line.substr(start, pos - start);
+        }
+    
+    public:
+        explicit RequestParser(std::string_view text) : line(text), pos(0) {}
+        
+        bool parse(Request& request, std::string& command) {
+            if (!expect('{')) return false;
+            if (expect('}')) return true;
+            
+            std::string key;
+            do {
+                key.clear();
+                if (!parseString(&key) || !expect(':')) return false;
+                skipSpace();
+                if (pos >= line.size()) return false;
+                
+                if (key == "id") {
+                    if (!parseId(request.id)) return false;
+                } else if (line[pos] == '"') {
+                    bool isCommand = key == "cmd";
+                    if (!parseString(isCommand ? &command : nullptr)) return false;
+                    request.hasCommand = request.hasCommand || isCommand;
+                } else {
+                    std::string_view token = parseToken();
+                    if (token.empty() || token[0] == '{' || token[0] == '[') return false;
+                    if (key == "text") request.wantText = token == "true";
+                    if (key == "trace") request.trace = token == "true" ? 1 : 0;
+                    if (key == "session") request.wantSession = token == "true";
+                    if (key == "ack") {
+                        auto parsed = std::from_chars(token.data(), token.data() + token.size(), request.ack);
+                        // The whole token, so 12.5 or 5x is not taken for an ack
+                        if (parsed.ec != std::errc() || parsed.ptr != token.data() + token.size()) return false;
+                        request.delta = true;
+                    }
+                }
+            } while (expect(','));
+            
+            return expect('}');
+        }
+    };
+}
+
+// ---------------------------------------------------------------------------
+// ProtocolSession
+
+ProtocolSession::ProtocolSession(Game& sessionGame)
+    : game(sessionGame), textStream(&textBuffer) {
+    game.setOutput(textStream);
+}
+
+ProtocolSession::~ProtocolSession() {
+    game.setOutput(std::cout);
+}
+
+void ProtocolSession::handleLine(std::string_view line, std::string& out) {
+    Request request;
+    command.clear();
+    textBuffer.clear();
+    JsonWriter writer(out);
+    
+    if (!RequestParser(line).parse(request, command) || !request.hasCommand) {
+        writer.beginObject();
+        writer.rawField("id", request.id);
+        writer.field("status", "bad_request");
+        writer.endObject();
+        out.push_back('\n');
+        return;
+    }
+    
+    if (request.trace >= 0) {
+        game.setTracing(request.trace == 1);
+    }
+    TraceScope trace(game.getTraceSession(), game.isTracing());
+    TraceSpan span("handleLine");
+    
+    game.setBufferBytes(sizeof(*this) + textBuffer.capacity() + command.capacity() + out.capacity() +
+                        (history ? history->memoryFootprint() : 0));
+    int healthBefore = game.getPlayer()->getHealth();
+    int scoreBefore = game.getScore();
+    int steps = 0;
+    CommandStatus status = game.executeCommand(command, &steps);
+    
+    TraceSpan encode("encodeReply");
+    writer.beginObject();
+    writer.rawField("id", request.id);
+    writer.field("status", commandStatusName(status));
+    writer.field("steps", steps);
+    if (request.delta) {
+        if (!history) {
+            history = std::make_unique<StateHistory>();
+        }
+        history->writeUpdate(writer, game, request.ack);
+    } else {
+        writer.field("health_delta", game.getPlayer()->getHealth() - healthBefore);
+        writer.field("score_delta", game.getScore() - scoreBefore);
+        writeState(writer, game);
+    }
+    if (request.wantSession) {
+        writer.field("session", static_cast<long long>(game.getTraceSession()));
+    }
+    if (request.wantText) {
+        writer.field("text", textBuffer.str());
+    }
+    writer.endObject();
+    out.push_back('\n');
+}
+
+void ProtocolSession::writeState(JsonWriter& writer, const Game& game) {
+    const Player* player = game.getPlayer();
+    writer.field("room", game.getCurrentRoomId());
+    writer.field("health", player->getHealth());
+    writer.field("score", game.getScore());
+    writer.field("running", game.isRunning());
+    
+    writer.beginArray("room_items");
+    if (const Room* room = game.peekCurrentRoom()) {
+        for (const auto& item : room->getItems()) {
+            writer.element(item->getName());
+        }
+    }
+    writer.endArray();
+    
+    writer.beginArray("inventory");
+    for (const auto& item : player->getInventory()) {
+        writer.element(item->getName());
+    }
+    writer.endArray();
+}
+
+void runJsonProtocol(Game& game, std::istream& in, std::ostream& out) {
+    ProtocolSession session(game);
+    std::string line;
+    std::string replies;
+    
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        session.handleLine(line, replies);
+        
+        if (in.rdbuf()->in_avail() <= 0 || !game.isRunning()) {
+            TraceScope trace(game.getTraceSession(), game.isTracing());
+            TraceSpan span("flush");
+            out.write(replies.data(), static_cast<std::streamsize>(replies.size()));
+            out.flush();
+            replies.clear();
+        }
+        if (!game.isRunning()) break;
+    }
+    out.write(replies.data(), static_cast<std::streamsize>(replies.size()));
+    out.flush();
+}
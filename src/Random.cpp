@@ -0,0 +1,137 @@
+#include "Random.h"
+#include "Serialization.h"
+#include <cstring>
+
+namespace {
+    const uint32_t MULTIPLIER_0 = 0xD2511F53;
+    const uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+    const uint32_t WEYL_0 = 0x9E3779B9; // key schedule increments
+    const uint32_t WEYL_1 = 0xBB67AE85;
+    const int ROUNDS = 10;
+    const size_t LANES = 8; // blocks computed together by fill()
+    const uint64_t NO_BLOCK = UINT64_MAX;
+    
+    // Counter words: block index (low, high), then stream (low, high). Key: the seed.
+    void philoxLanes(uint64_t seed, uint64_t stream, uint64_t firstBlock, uint32_t* out) {
+        uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            uint64_t index = firstBlock + lane;
+            c0[lane] = static_cast<uint32_t>(index);
+            c1[lane] = static_cast<uint32_t>(index >> 32);
+            c2[lane] = static_cast<uint32_t>(stream);
+            c3[lane] = static_cast<uint32_t>(stream >> 32);
+        }
+        uint32_t k0 = static_cast<uint32_t>(seed);
+        uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                uint64_t product0 = static_cast<uint64_t>(MULTIPLIER_0) * c0[lane];
+                uint64_t product1 = static_cast<uint64_t>(MULTIPLIER_1) * c2[lane];
+                uint32_t n0 = static_cast<uint32_t>(product1 >> 32) ^ c1[lane] ^ k0;
+                uint32_t n2 = static_cast<uint32_t>(product0 >> 32) ^ c3[lane] ^ k1;
+                c0[lane] = n0;
+                c1[lane] = static_cast<uint32_t>(product1);
+                c2[lane] = n2;
+                c3[lane] = static_cast<uint32_t>(product0);
+            }
+            k0 += WEYL_0;
+            k1 += WEYL_1;
+        }
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            out[lane * 4] = c0[lane];
+            out[lane * 4 + 1] = c1[lane];
+            out[lane * 4 + 2] = c2[lane];
+            out[lane * 4 + 3] = c3[lane];
+        }
+    }
+}
+
+Random::Block Random::block(uint64_t seed, uint64_t stream, uint64_t blockIndex) {
+    uint32_t c[4] = {static_cast<uint32_t>(blockIndex), static_cast<uint32_t>(blockIndex >> 32),
+                     static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+    uint32_t k0 = static_cast<uint32_t>(seed);
+    uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+    for (int round = 0; round < ROUNDS; ++round) {
+        uint64_t product0 = static_cast<uint64_t>(MULTIPLIER_0) * c[0];
+        uint64_t product1 = static_cast<uint64_t>(MULTIPLIER_1) * c[2];
+        c[0] = static_cast<uint32_t>(product1 >> 32) ^ c[1] ^ k0;
+        c[1] = static_cast<uint32_t>(product1);
+        c[2] = static_cast<uint32_t>(product0 >> 32) ^ c[3] ^ k1;
+        c[3] = static_cast<uint32_t>(product0);
+        k0 += WEYL_0;
+        k1 += WEYL_1;
+    }
+    return {c[0], c[1], c[2], c[3]};
+}
+
+Random::Random(uint64_t seedValue, uint64_t streamId)
+    : seed(seedValue), stream(streamId), position(0), cached{}, cachedIndex(NO_BLOCK) {}
+
+void Random::reseed(uint64_t seedValue, uint64_t streamId) {
+    seed = seedValue;
+    stream = streamId;
+    position = 0;
+    cachedIndex = NO_BLOCK;
+}
+
+uint32_t Random::next() {
+    uint64_t index = position / 4;
+    if (index != cachedIndex) {
+        cached = block(seed, stream, index);
+        cachedIndex = index;
+    }
+    return cached[position++ % 4];
+}
+
+uint32_t Random::below(uint32_t bound) {
+    // Lemire's multiply-and-shift, rejecting the few products that would bias it
+    uint64_t product = static_cast<uint64_t>(next()) * bound;
+    uint32_t low = static_cast<uint32_t>(product);
+    if (low < bound) {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            product = static_cast<uint64_t>(next()) * bound;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+double Random::unit() {
+    uint64_t high = next() >> 5; // 27 bits
+    uint64_t low = next() >> 6;  // 26 bits
+    return static_cast<double>((high << 26) | low) * (1.0 / 9007199254740992.0);
+}
+
+void Random::fill(uint32_t* out, size_t count) {
+    // Finish the current block, run whole groups of blocks, then draw the rest one by one
+    while (count > 0 && position % 4 != 0) {
+        *out++ = next();
+        --count;
+    }
+    uint32_t group[LANES * 4];
+    while (count >= LANES * 4) {
+        philoxLanes(seed, stream, position / 4, group);
+        std::memcpy(out, group, sizeof(group));
+        out += LANES * 4;
+        count -= LANES * 4;
+        position += LANES * 4;
+    }
+    while (count > 0) {
+        *out++ = next();
+        --count;
+    }
+}
+
+void Random::save(ByteWriter& writer) const {
+    writer.writeVarint(seed);
+    writer.writeVarint(stream);
+    writer.writeVarint(position);
+}
+
+void Random::load(ByteReader& reader) {
+    seed = reader.readVarint();
+    stream = reader.readVarint();
+    position = reader.readVarint();
+    cachedIndex = NO_BLOCK;
+}
@@ -0,0 +1,216 @@
+#include "RegionPager.h"
+#include "Serialization.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    enum RoomStateFlags : uint8_t {
+        STATE_VISITED = 1,
+        STATE_LOCKED = 2
+    };
+}
+
+RegionPager::RegionPager(WorldFile& worldFile, size_t budgetBytes)
+    : world(worldFile), memoryBudget(budgetBytes), pinnedRegion(-1), residentBytes(0),
+      evictionHolds(0), evictionPending(false),
+      regionLoads(0), regionEvictions(0), writeBackBytes(0) {
+}
+
+RegionPager::~RegionPager() = default;
+
+Room* RegionPager::getRoom(int roomId) {
+    auto it = roomLookup.find(roomId);
+    if (it != roomLookup.end()) {
+        touch(world.getRegion(roomId));
+        return it->second;
+    }
+    
+    int regionId = world.getRegion(roomId);
+    if (regionId == -1) {
+        return nullptr;
+    }
+    
+    loadRegion(regionId);
+    touch(regionId);
+    Room* room = roomLookup[roomId];
+    enforceBudget();
+    return room;
+}
+
+Room* RegionPager::peekRoom(int roomId) const {
+    auto it = roomLookup.find(roomId);
+    return (it != roomLookup.end()) ? it->second : nullptr;
+}
+
+bool RegionPager::isLocked(int roomId) const {
+    if (const Room* room = peekRoom(roomId)) {
+        return room->isLocked();
+    }
+    auto saved = savedLocks.find(roomId);
+    return (saved != savedLocks.end()) ? saved->second : world.isLocked(roomId);
+}
+
+void RegionPager::enterRoom(int roomId) {
+    int regionId = world.getRegion(roomId);
+    if (regionId == -1) {
+        return;
+    }
+    pinnedRegion = regionId;
+    if (!resident.count(regionId)) {
+        loadRegion(regionId);
+    }
+    
+    // Prefetch along the exits of the current room, then make sure the
+    // player's own region stays the most recently used one.
+    for (int next : world.getNeighbours(roomId)) {
+        int nextRegion = world.getRegion(next);
+        if (nextRegion != -1 && !resident.count(nextRegion)) {
+            loadRegion(nextRegion);
+            touch(nextRegion);
+        }
+    }
+    touch(regionId);
+    enforceBudget();
+}
+
+RegionPager::Region& RegionPager::loadRegion(int regionId) {
+    Region& region = resident[regionId];
+    region.bytes = 0;
+    
+    for (int roomId : world.getRegionRooms(regionId)) {
+        std::unique_ptr<Room> room = world.loadRoom(roomId);
+        roomLookup[roomId] = room.get();
+        region.rooms.push_back(std::move(room));
+    }
+    
+    auto saved = writeBack.find(regionId);
+    if (saved != writeBack.end()) {
+        applyRegionState(saved->second);
+    }
+    
+    for (const auto& room : region.rooms) {
+        region.bytes += room->memoryFootprint();
+    }
+    residentBytes += region.bytes;
+    ++regionLoads;
+    return region;
+}
+
+void RegionPager::evictRegion(int regionId) {
+    auto it = resident.find(regionId);
+    if (it == resident.end()) {
+        return;
+    }
+    
+    Region& region = it->second;
+    bool dirty = false;
+    for (const auto& room : region.rooms) {
+        dirty = dirty || room->isModified();
+    }
+    if (dirty) {
+        std::string& state = writeBack[regionId];
+        writeBackBytes -= state.size();
+        state = saveRegionState(region);
+        writeBackBytes += state.size();
+        for (const auto& room : region.rooms) {
+            if (room->isModified()) {
+                savedLocks[room->getId()] = room->isLocked();
+            }
+        }
+    }
+    
+    for (const auto& room : region.rooms) {
+        roomLookup.erase(room->getId());
+    }
+    residentBytes -= region.bytes;
+    resident.erase(it);
+    
+    auto pos = lruPosition.find(regionId);
+    if (pos != lruPosition.end()) {
+        lru.erase(pos->second);
+        lruPosition.erase(pos);
+    }
+    ++regionEvictions;
+}
+
+void RegionPager::releaseEvictions() {
+    if (--evictionHolds == 0 && evictionPending) {
+        evictionPending = false;
+        enforceBudget();
+    }
+}
+
+void RegionPager::enforceBudget() {
+    if (evictionHolds > 0) {
+        evictionPending = true;
+        return;
+    }
+    
+    // Rooms grow and shrink as items move, so refresh the sizes first
+    residentBytes = 0;
+    for (auto& entry : resident) {
+        entry.second.bytes = 0;
+        for (const auto& room : entry.second.rooms) {
+            entry.second.bytes += room->memoryFootprint();
+        }
+        residentBytes += entry.second.bytes;
+    }
+    
+    // Never evict the player's region or the one that was just used
+    while (residentBytes > memoryBudget && lru.size() > 1) {
+        auto victim = std::find_if(lru.rbegin(), std::prev(lru.rend()),
+            [this](int regionId) { return regionId != pinnedRegion; });
+        if (victim == std::prev(lru.rend())) {
+            break;
+        }
+        evictRegion(*victim);
+    }
+}
+
+void RegionPager::touch(int regionId) {
+    auto pos = lruPosition.find(regionId);
+    if (pos != lruPosition.end()) {
+        lru.splice(lru.begin(), lru, pos->second);
+    } else {
+        lru.push_front(regionId);
+        lruPosition[regionId] = lru.begin();
+    }
+}
+
+std::string RegionPager::saveRegionState(const Region& region) const {
+    // Only modified rooms are recorded; the rest reload pristine from the world file
+    std::string state;
+    ByteWriter writer(state);
+    for (const auto& room : region.rooms) {
+        if (!room->isModified()) continue;
+        
+        writer.writeVarint(static_cast<uint64_t>(room->getId()));
+        writer.writeByte((room->isVisited() ? STATE_VISITED : 0) | (room->isLocked() ? STATE_LOCKED : 0));
+        writer.writeVarint(room->getItems().size());
+        for (const auto& item : room->getItems()) {
+            writeItem(writer, *item, &world.getTextStore());
+        }
+    }
+    return state;
+}
+
+void RegionPager::applyRegionState(const std::string& state) {
+    ByteReader reader(state);
+    std::shared_ptr<const TextStore> store = world.shareTextStore();
+    while (!reader.atEnd()) {
+        int roomId = static_cast<int>(reader.readVarint());
+        uint8_t flags = reader.readByte();
+        Room* room = roomLookup.at(roomId);
+        
+        room->clearItems();
+        room->setVisited(flags & STATE_VISITED);
+        room->setLocked(flags & STATE_LOCKED);
+        uint64_t itemCount = reader.readVarint();
+        for (uint64_t i = 0; i < itemCount; ++i) {
+            room->addItem(readItem(reader, store));
+        }
+        
+        // Keep the room marked so its state is written back again on the next eviction
+        room->markModified();
+    }
+}
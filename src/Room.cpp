@@ -3,13 +3,15 @@
 #include <algorithm>
 
 Room::Room(int roomId, const std::string& roomName, const std::string& desc)
-    : id(roomId), name(roomName), description(desc), longDescription(desc), 
-      visited(false), locked(false) {
+    : id(roomId), name(roomName), description(desc),
+      visited(false), locked(false), modified(false),
+      cachedFootprint(0), cachedTextFootprint(0), footprintValid(false) {
 }
 
 Room::Room(int roomId, const std::string& roomName, const std::string& desc, const std::string& longDesc)
     : id(roomId), name(roomName), description(desc), longDescription(longDesc), 
-      visited(false), locked(false) {
+      visited(false), locked(false), modified(false),
+      cachedFootprint(0), cachedTextFootprint(0), footprintValid(false) {
 }
 
 Room::~Room() = default;
@@ -17,13 +19,14 @@ Room::~Room() = default;
 std::string Room::getDescription() const {
     // Return long description if this is the first visit, short description otherwise
     if (!visited && !longDescription.empty()) {
-        return longDescription;
+        return longDescription.str();
     }
     return description;
 }
 
 void Room::addExit(const std::string& direction, int roomId) {
     exits[direction] = roomId;
+    footprintValid = false;
 }
 
 int Room::getExit(const std::string& direction) const {
@@ -42,6 +45,8 @@ std::vector<std::string> Room::getAvailableExits() const {
 void Room::addItem(std::unique_ptr<Item> item) {
     if (item) {
         items.push_back(std::move(item));
+        modified = true;
+        footprintValid = false;
     }
 }
 
@@ -54,6 +59,8 @@ std::unique_ptr<Item> Room::removeItem(const std::string& itemName) {
     if (it != items.end()) {
         std::unique_ptr<Item> removedItem = std::move(*it);
         items.erase(it);
+        modified = true;
+        footprintValid = false;
         return removedItem;
     }
     
@@ -69,48 +76,92 @@ Item* Room::findItem(const std::string& itemName) const {
     return (it != items.end()) ? it->get() : nullptr;
 }
 
-void Room::displayItems() const {
+void Room::clearItems() {
+    if (!items.empty()) {
+        items.clear();
+        modified = true;
+        footprintValid = false;
+    }
+}
+
+void Room::displayItems(std::ostream& os) const {
     if (items.empty()) {
         return;
     }
     
-    std::cout << "\nYou can see:\n";
+    os << "\nYou can see:\n";
     for (const auto& item : items) {
         if (item) {
-            std::cout << "  " << item->getName();
+            os << "  " << item->getName();
             if (item->getCanTake()) {
-                std::cout << " (you can take this)";
+                os << " (you can take this)";
             }
-            std::cout << "\n";
+            os << "\n";
         }
     }
 }
 
-void Room::displayRoom() const {
-    std::cout << "=== " << name << " ===\n";
-    std::cout << getDescription() << "\n";
+void Room::displayRoom(std::ostream& os) const {
+    os << "=== " << name << " ===\n";
+    if (!visited && !longDescription.empty()) {
+        os << longDescription << "\n";
+    } else {
+        os << description << "\n";
+    }
     
     // Display items in the room
-    displayItems();
+    displayItems(os);
     
     // Display available exits
-    displayExits();
+    displayExits(os);
 }
 
-void Room::displayExits() const {
+void Room::displayExits(std::ostream& os) const {
     if (exits.empty()) {
-        std::cout << "\nThere are no obvious exits.\n";
+        os << "\nThere are no obvious exits.\n";
         return;
     }
     
-    std::cout << "\nExits: ";
+    os << "\nExits: ";
     bool first = true;
     for (const auto& exit : exits) {
         if (!first) {
-            std::cout << ", ";
+            os << ", ";
         }
-        std::cout << exit.first;
+        os << exit.first;
         first = false;
     }
-    std::cout << "\n";
-}
\ No newline at end of file
+    os << "\n";
+}
+
+size_t Room::memoryFootprint() const {
+    if (!footprintValid) {
+        measureFootprint();
+    }
+    return cachedFootprint;
+}
+
+size_t Room::textFootprint() const {
+    if (!footprintValid) {
+        measureFootprint();
+    }
+    return cachedTextFootprint;
+}
+
+void Room::measureFootprint() const {
+    size_t text = name.capacity() + description.capacity() + longDescription.memoryFootprint();
+    size_t total = sizeof(*this) + text + unlockKey.capacity();
+    for (const auto& exit : exits) {
+        total += MAP_NODE_OVERHEAD + sizeof(exit) + exit.first.capacity();
+    }
+    total += items.capacity() * sizeof(std::unique_ptr<Item>);
+    for (const auto& item : items) {
+        if (item) {
+            total += item->memoryFootprint();
+            text += item->textFootprint();
+        }
+    }
+    cachedFootprint = total;
+    cachedTextFootprint = text;
+    footprintValid = true;
+}
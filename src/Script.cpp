@@ -0,0 +1,503 @@
+#include "Script.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+
+// Direct threading needs the labels-as-values extension
+#if defined(__GNUC__)
+#define SCRIPT_THREADED 1
+#else
+#define SCRIPT_THREADED 0
+#endif
+
+bool parseScriptEvent(const std::string& name, ScriptEvent& event) {
+    if (name == "use") event = ScriptEvent::USE;
+    else if (name == "take") event = ScriptEvent::TAKE;
+    else if (name == "enter") event = ScriptEvent::ENTER;
+    else if (name == "examine") event = ScriptEvent::EXAMINE;
+    else return false;
+    return true;
+}
+
+namespace {
+    std::vector<std::string> splitWords(std::string_view text) {
+        std::vector<std::string> words;
+        size_t i = 0;
+        while (i < text.size()) {
+            while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+            size_t start = i;
+            while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+            if (i > start) words.emplace_back(text.substr(start, i - start));
+        }
+        return words;
+    }
+    
+    std::string_view trim(std::string_view text) {
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+        return text;
+    }
+    
+    std::string joinWords(const std::vector<std::string>& words, size_t from, size_t to) {
+        std::string joined;
+        for (size_t i = from; i < to; ++i) {
+            joined += (i > from ? " " : "") + words[i];
+        }
+        return joined;
+    }
+}
+
+// Turns script source into instructions, one statement at a time.
+// Registers are allocated like a stack: expression temporaries are freed
+// after each statement, repeat counters when their loop ends.
+class ScriptCompiler {
+private:
+    using Opcode = Script::Opcode;
+    
+    enum class BlockKind { IF, ELSE, REPEAT };
+    struct Block {
+        BlockKind kind;
+        size_t pendingJump; // instruction whose target is the end of the block
+        size_t loopStart;
+        int counter;
+    };
+    
+    Script& script;
+    std::vector<Block> blocks;
+    int liveRegisters = 0; // held by enclosing repeat loops
+    int nextRegister = 0;
+    
+    [[noreturn]] void fail(const std::string& message, const std::string& statement) const {
+        throw std::runtime_error("script: " + message + " in '" + statement + "'");
+    }
+    
+    size_t emit(Opcode op, int a = 0, int b = 0, int c = 0, int32_t operand = 0) {
+        script.code.push_back(Script::Instruction{nullptr, op, static_cast<uint8_t>(a), static_cast<uint8_t>(b),
+                                                  static_cast<uint8_t>(c), operand});
+        return script.code.size() - 1;
+    }
+    
+    int32_t intern(const std::string& text) {
+        auto it = std::find(script.strings.begin(), script.strings.end(), text);
+        if (it != script.strings.end()) {
+            return static_cast<int32_t>(it - script.strings.begin());
+        }
+        script.strings.push_back(text);
+        return static_cast<int32_t>(script.strings.size() - 1);
+    }
+    
+    int allocate(const std::string& statement) {
+        if (nextRegister == Script::REGISTER_COUNT) fail("expression too complex", statement);
+        return nextRegister++;
+    }
+    
+    void patchToHere(size_t jump) {
+        script.code[jump].operand = static_cast<int32_t>(script.code.size());
+    }
+    
+    int operand(const std::vector<std::string>& words, size_t& pos, const std::string& statement) {
+        if (pos >= words.size()) fail("missing value", statement);
+        const std::string& word = words[pos++];
+        int target = allocate(statement);
+        if (word == "health") {
+            emit(Opcode::LOAD_HEALTH, target);
+        } else if (word == "score") {
+            emit(Opcode::LOAD_SCORE, target);
+        } else if (word == "room") {
+            emit(Opcode::LOAD_ROOM, target);
+        } else if (word == "random") {
+            int bound = operand(words, pos, statement);
+            emit(Opcode::RANDOM, target, bound);
+            nextRegister = target + 1;
+        } else {
+            size_t used = 0;
+            int value = 0;
+            try {
+                value = std::stoi(word, &used);
+            } catch (const std::exception&) {
+                used = 0;
+            }
+            if (used != word.size()) fail("unknown value '" + word + "'", statement);
+            emit(Opcode::LOAD_CONST, target, 0, 0, value);
+        }
+        return target;
+    }
+    
+    // operand (+|- operand)*, stopping at the first word that is neither
+    int expression(const std::vector<std::string>& words, size_t& pos, const std::string& statement) {
+        int result = operand(words, pos, statement);
+        while (pos < words.size() && (words[pos] == "+" || words[pos] == "-")) {
+            Opcode op = words[pos++] == "+" ? Opcode::ADD : Opcode::SUBTRACT;
+            int right = operand(words, pos, statement);
+            emit(op, result, result, right);
+            nextRegister = result + 1;
+        }
+        return result;
+    }
+    
+    int condition(const std::vector<std::string>& words, size_t pos, const std::string& statement) {
+        if (pos >= words.size()) fail("missing condition", statement);
+        if (words[pos] == "not") {
+            int inner = condition(words, pos + 1, statement);
+            emit(Opcode::NOT, inner, inner);
+            return inner;
+        }
+        
+        int result = allocate(statement);
+        if (words[pos] == "flag") {
+            if (pos + 2 != words.size()) fail("flag takes one name", statement);
+            emit(Opcode::GET_FLAG, result, 0, 0, intern(words[pos + 1]));
+        } else if (words[pos] == "has") {
+            if (pos + 1 >= words.size()) fail("missing item name", statement);
+            emit(Opcode::HAS_ITEM, result, 0, 0, intern(joinWords(words, pos + 1, words.size())));
+        } else if (words[pos] == "locked") {
+            ++pos;
+            int room = expression(words, pos, statement);
+            if (pos != words.size()) fail("unexpected '" + words[pos] + "'", statement);
+            emit(Opcode::IS_LOCKED, result, room);
+        } else {
+            int left = expression(words, pos, statement);
+            if (pos >= words.size()) fail("missing comparison", statement);
+            std::string comparison = words[pos++];
+            int right = expression(words, pos, statement);
+            if (pos != words.size()) fail("unexpected '" + words[pos] + "'", statement);
+            if (comparison == "<") emit(Opcode::LESS, result, left, right);
+            else if (comparison == "<=") emit(Opcode::LESS_EQUAL, result, left, right);
+            else if (comparison == ">") emit(Opcode::LESS, result, right, left);
+            else if (comparison == ">=") emit(Opcode::LESS_EQUAL, result, right, left);
+            else if (comparison == "==") emit(Opcode::EQUAL, result, left, right);
+            else if (comparison == "!=") emit(Opcode::NOT_EQUAL, result, left, right);
+            else fail("unknown comparison '" + comparison + "'", statement);
+        }
+        return result;
+    }
+    
+    // A statement whose argument is a single expression
+    int argument(const std::vector<std::string>& words, const std::string& statement) {
+        size_t pos = 1;
+        int value = expression(words, pos, statement);
+        if (pos != words.size()) fail("unexpected '" + words[pos] + "'", statement);
+        return value;
+    }
+    
+    void statement(std::string_view text) {
+        std::string source(text);
+        std::vector<std::string> words = splitWords(text);
+        const std::string& keyword = words[0];
+        nextRegister = liveRegisters;
+        
+        if (keyword == "say") {
+            std::string_view message = trim(text.substr(3));
+            if (message.empty()) fail("nothing to say", source);
+            emit(Opcode::SAY, 0, 0, 0, intern(std::string(message)));
+        } else if (keyword == "set" || keyword == "clear") {
+            if (words.size() != 2) fail(keyword + " takes one flag", source);
+            emit(Opcode::SET_FLAG, keyword == "set" ? 1 : 0, 0, 0, intern(words[1]));
+        } else if (keyword == "heal") {
+            emit(Opcode::HEAL, argument(words, source));
+        } else if (keyword == "hurt") {
+            emit(Opcode::HURT, argument(words, source));
+        } else if (keyword == "score") {
+            emit(Opcode::ADD_SCORE, argument(words, source));
+        } else if (keyword == "lock" || keyword == "unlock") {
+            emit(Opcode::SET_LOCKED, argument(words, source), keyword == "lock" ? 1 : 0);
+        } else if (keyword == "destroy") {
+            if (words.size() < 2) fail("missing item name", source);
+            emit(Opcode::DESTROY, 0, 0, 0, intern(joinWords(words, 1, words.size())));
+        } else if (keyword == "consume" || keyword == "cancel" || keyword == "stop") {
+            if (words.size() != 1) fail(keyword + " takes no arguments", source);
+            emit(keyword == "consume" ? Opcode::CONSUME : keyword == "cancel" ? Opcode::CANCEL : Opcode::HALT);
+        } else if (keyword == "budget") {
+            int count = 0;
+            try {
+                count = words.size() == 2 ? std::stoi(words[1]) : 0;
+            } catch (const std::exception&) {
+                count = 0;
+            }
+            if (count <= 0) fail("budget takes a positive count", source);
+            script.budget = static_cast<uint32_t>(count);
+        } else if (keyword == "if") {
+            int test = condition(words, 1, source);
+            blocks.push_back(Block{BlockKind::IF, emit(Opcode::JUMP_IF_ZERO, test), 0, 0});
+        } else if (keyword == "else") {
+            if (words.size() != 1 || blocks.empty() || blocks.back().kind != BlockKind::IF) {
+                fail("else without if", source);
+            }
+            size_t skipElse = emit(Opcode::JUMP);
+            patchToHere(blocks.back().pendingJump);
+            blocks.back() = Block{BlockKind::ELSE, skipElse, 0, 0};
+        } else if (keyword == "repeat") {
+            int counter = argument(words, source);
+            liveRegisters = counter + 1;
+            size_t loopStart = script.code.size();
+            // A count of zero or less skips the body
+            blocks.push_back(Block{BlockKind::REPEAT, emit(Opcode::JUMP_IF_NOT_POSITIVE, counter), loopStart, counter});
+        } else if (keyword == "end") {
+            if (words.size() != 1 || blocks.empty()) fail("end without if or repeat", source);
+            Block block = blocks.back();
+            blocks.pop_back();
+            if (block.kind == BlockKind::REPEAT) {
+                emit(Opcode::DECREMENT, block.counter);
+                emit(Opcode::JUMP, 0, 0, 0, static_cast<int32_t>(block.loopStart));
+                liveRegisters = block.counter;
+            }
+            patchToHere(block.pendingJump);
+        } else {
+            fail("unknown statement '" + keyword + "'", source);
+        }
+    }
+
+public:
+    explicit ScriptCompiler(Script& target) : script(target) {}
+    
+    void compile(std::string_view source) {
+        size_t start = 0;
+        while (start <= source.size()) {
+            size_t end = std::min(source.find(';', start), source.size());
+            std::string_view text = trim(source.substr(start, end - start));
+            if (!text.empty()) {
+                statement(text);
+            }
+            start = end + 1;
+        }
+        if (!blocks.empty()) {
+            throw std::runtime_error("script: missing end");
+        }
+        emit(Opcode::HALT);
+    }
+};
+
+namespace {
+    // Content can add up values past the int32 range; saturate instead of overflowing
+    int32_t clampToInt32(int64_t value) {
+        return static_cast<int32_t>(std::clamp<int64_t>(value, INT32_MIN, INT32_MAX));
+    }
+    
+    // Runs code until it halts. Called with labels set, it only reports
+    // the address of each opcode's handler (in Opcode order) for linking.
+    ScriptResult interpret(const Script::Instruction* code, const std::vector<std::string>* strings,
+                           uint32_t budget, ScriptHost* host, const std::string* subject,
+                           const void* const** labels) {
+#if SCRIPT_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+        static const void* const handlers[] = {
+            &&op_LOAD_CONST, &&op_LOAD_HEALTH, &&op_LOAD_SCORE, &&op_LOAD_ROOM, &&op_RANDOM,
+            &&op_ADD, &&op_SUBTRACT, &&op_LESS, &&op_LESS_EQUAL, &&op_EQUAL, &&op_NOT_EQUAL, &&op_NOT,
+            &&op_GET_FLAG, &&op_HAS_ITEM, &&op_IS_LOCKED, &&op_JUMP, &&op_JUMP_IF_ZERO,
+            &&op_JUMP_IF_NOT_POSITIVE, &&op_DECREMENT, &&op_SET_FLAG, &&op_HEAL, &&op_HURT, &&op_ADD_SCORE, &&op_SET_LOCKED,
+            &&op_DESTROY, &&op_CONSUME, &&op_SAY, &&op_CANCEL, &&op_HALT
+        };
+        static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(Script::Opcode::OPCODE_COUNT),
+                      "every opcode needs a handler");
+        if (labels) {
+            *labels = handlers;
+            return ScriptResult::FINISHED;
+        }
+#define DISPATCH() do { if (remaining-- == 0) goto out_of_budget; goto *ip->handler; } while (0)
+#else
+        if (labels) {
+            *labels = nullptr;
+            return ScriptResult::FINISHED;
+        }
+#define DISPATCH() do { if (remaining-- == 0) goto out_of_budget; goto dispatch; } while (0)
+#endif
+#define NEXT() do { ++ip; DISPATCH(); } while (0)
+
+        int32_t r[Script::REGISTER_COUNT] = {};
+        uint32_t remaining = budget;
+        const Script::Instruction* ip = code;
+        DISPATCH();
+
+#if !SCRIPT_THREADED
+    dispatch:
+        switch (ip->op) {
+            case Script::Opcode::LOAD_CONST: goto op_LOAD_CONST;
+            case Script::Opcode::LOAD_HEALTH: goto op_LOAD_HEALTH;
+            case Script::Opcode::LOAD_SCORE: goto op_LOAD_SCORE;
+            case Script::Opcode::LOAD_ROOM: goto op_LOAD_ROOM;
+            case Script::Opcode::RANDOM: goto op_RANDOM;
+            case Script::Opcode::ADD: goto op_ADD;
+            case Script::Opcode::SUBTRACT: goto op_SUBTRACT;
+            case Script::Opcode::LESS: goto op_LESS;
+            case Script::Opcode::LESS_EQUAL: goto op_LESS_EQUAL;
+            case Script::Opcode::EQUAL: goto op_EQUAL;
+            case Script::Opcode::NOT_EQUAL: goto op_NOT_EQUAL;
+            case Script::Opcode::NOT: goto op_NOT;
+            case Script::Opcode::GET_FLAG: goto op_GET_FLAG;
+            case Script::Opcode::HAS_ITEM: goto op_HAS_ITEM;
+            case Script::Opcode::IS_LOCKED: goto op_IS_LOCKED;
+            case Script::Opcode::JUMP: goto op_JUMP;
+            case Script::Opcode::JUMP_IF_ZERO: goto op_JUMP_IF_ZERO;
+            case Script::Opcode::JUMP_IF_NOT_POSITIVE: goto op_JUMP_IF_NOT_POSITIVE;
+            case Script::Opcode::DECREMENT: goto op_DECREMENT;
+            case Script::Opcode::SET_FLAG: goto op_SET_FLAG;
+            case Script::Opcode::HEAL: goto op_HEAL;
+            case Script::Opcode::HURT: goto op_HURT;
+            case Script::Opcode::ADD_SCORE: goto op_ADD_SCORE;
+            case Script::Opcode::SET_LOCKED: goto op_SET_LOCKED;
+            case Script::Opcode::DESTROY: goto op_DESTROY;
+            case Script::Opcode::CONSUME: goto op_CONSUME;
+            case Script::Opcode::SAY: goto op_SAY;
+            case Script::Opcode::CANCEL: goto op_CANCEL;
+            default: goto op_HALT;
+        }
+#endif
+
+    op_LOAD_CONST:
+        r[ip->a] = ip->operand;
+        NEXT();
+    op_LOAD_HEALTH:
+        r[ip->a] = host->scriptGetHealth();
+        NEXT();
+    op_LOAD_SCORE:
+        r[ip->a] = host->scriptGetScore();
+        NEXT();
+    op_LOAD_ROOM:
+        r[ip->a] = host->scriptGetRoom();
+        NEXT();
+    op_RANDOM:
+        r[ip->a] = host->scriptRandom(r[ip->b]);
+        NEXT();
+    op_ADD:
+        r[ip->a] = clampToInt32(static_cast<int64_t>(r[ip->b]) + r[ip->c]);
+        NEXT();
+    op_SUBTRACT:
+        r[ip->a] = clampToInt32(static_cast<int64_t>(r[ip->b]) - r[ip->c]);
+        NEXT();
+    op_LESS:
+        r[ip->a] = r[ip->b] < r[ip->c];
+        NEXT();
+    op_LESS_EQUAL:
+        r[ip->a] = r[ip->b] <= r[ip->c];
+        NEXT();
+    op_EQUAL:
+        r[ip->a] = r[ip->b] == r[ip->c];
+        NEXT();
+    op_NOT_EQUAL:
+        r[ip->a] = r[ip->b] != r[ip->c];
+        NEXT();
+    op_NOT:
+        r[ip->a] = !r[ip->b];
+        NEXT();
+    op_GET_FLAG:
+        r[ip->a] = host->scriptGetFlag((*strings)[ip->operand]);
+        NEXT();
+    op_HAS_ITEM:
+        r[ip->a] = host->scriptHasItem((*strings)[ip->operand]);
+        NEXT();
+    op_IS_LOCKED:
+        r[ip->a] = host->scriptIsLocked(r[ip->b]);
+        NEXT();
+    op_JUMP:
+        ip = code + ip->operand;
+        DISPATCH();
+    op_JUMP_IF_ZERO:
+        if (r[ip->a] == 0) {
+            ip = code + ip->operand;
+            DISPATCH();
+        }
+        NEXT();
+    op_JUMP_IF_NOT_POSITIVE:
+        if (r[ip->a] <= 0) {
+            ip = code + ip->operand;
+            DISPATCH();
+        }
+        NEXT();
+    op_DECREMENT:
+        --r[ip->a];
+        NEXT();
+    op_SET_FLAG:
+        host->scriptSetFlag((*strings)[ip->operand], ip->a != 0);
+        NEXT();
+    op_HEAL:
+        host->scriptHeal(r[ip->a]);
+        NEXT();
+    op_HURT:
+        host->scriptHurt(r[ip->a]);
+        NEXT();
+    op_ADD_SCORE:
+        host->scriptAddScore(r[ip->a]);
+        NEXT();
+    op_SET_LOCKED:
+        host->scriptSetLocked(r[ip->a], ip->b != 0);
+        NEXT();
+    op_DESTROY:
+        host->scriptDestroyItem((*strings)[ip->operand]);
+        NEXT();
+    op_CONSUME:
+        if (!subject->empty()) {
+            host->scriptDestroyItem(*subject);
+        }
+        NEXT();
+    op_SAY:
+        host->scriptSay((*strings)[ip->operand]);
+        NEXT();
+    op_CANCEL:
+        return ScriptResult::CANCELLED;
+    op_HALT:
+        return ScriptResult::FINISHED;
+    out_of_budget:
+        return ScriptResult::OUT_OF_BUDGET;
+#undef NEXT
+#undef DISPATCH
+#if SCRIPT_THREADED
+#pragma GCC diagnostic pop
+#endif
+    }
+}
+
+Script Script::compile(std::string_view source) {
+    Script script;
+    ScriptCompiler(script).compile(source);
+    script.link();
+    return script;
+}
+
+void Script::link() {
+    const void* const* handlers = nullptr;
+    interpret(nullptr, nullptr, 0, nullptr, nullptr, &handlers);
+    for (Instruction& instruction : code) {
+        instruction.handler = handlers ? handlers[static_cast<size_t>(instruction.op)] : nullptr;
+    }
+}
+
+ScriptResult Script::run(ScriptHost& host, const std::string& subject) const {
+    return interpret(code.data(), &strings, budget, &host, &subject, nullptr);
+}
+
+size_t ScriptBook::itemSlot(ScriptEvent event) {
+    switch (event) {
+        case ScriptEvent::USE: return 0;
+        case ScriptEvent::TAKE: return 1;
+        case ScriptEvent::EXAMINE: return 2;
+        default: throw std::logic_error("enter scripts belong to rooms");
+    }
+}
+
+void ScriptBook::addItemScript(ScriptEvent event, const std::string& itemName, Script script) {
+    itemScripts[itemSlot(event)].insert_or_assign(itemName, std::move(script));
+}
+
+void ScriptBook::addEnterScript(int roomId, Script script) {
+    enterScripts.insert_or_assign(roomId, std::move(script));
+}
+
+const Script* ScriptBook::findItemScript(ScriptEvent event, const std::string& itemName) const {
+    const auto& scripts = itemScripts[itemSlot(event)];
+    if (scripts.empty()) return nullptr;
+    auto it = scripts.find(itemName);
+    return it != scripts.end() ? &it->second : nullptr;
+}
+
+const Script* ScriptBook::findEnterScript(int roomId) const {
+    auto it = enterScripts.find(roomId);
+    return it != enterScripts.end() ? &it->second : nullptr;
+}
+
+bool ScriptBook::empty() const {
+    return enterScripts.empty() &&
+           std::all_of(std::begin(itemScripts), std::end(itemScripts),
+                       [](const auto& scripts) { return scripts.empty(); });
+}
@@ -0,0 +1,118 @@
+#include "Serialization.h"
+#include <stdexcept>
+
+void ByteWriter::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        writeByte(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    writeByte(static_cast<uint8_t>(value));
+}
+
+void ByteWriter::writeInt(int64_t value) {
+    writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void ByteWriter::writeString(const std::string& str) {
+    writeVarint(str.size());
+    buffer.append(str);
+}
+
+uint8_t ByteReader::readByte() {
+    if (pos >= buffer.size()) {
+        throw std::runtime_error("Corrupt state data: unexpected end of buffer");
+    }
+    return static_cast<uint8_t>(buffer[pos++]);
+}
+
+uint64_t ByteReader::readVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = readByte();
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Corrupt state data: varint too long");
+}
+
+int64_t ByteReader::readInt() {
+    uint64_t raw = readVarint();
+    return static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+}
+
+std::string ByteReader::readString() {
+    uint64_t length = readVarint();
+    if (length > buffer.size() - pos) {
+        throw std::runtime_error("Corrupt state data: string overruns buffer");
+    }
+    std::string result = buffer.substr(pos, length);
+    pos += length;
+    return result;
+}
+
+namespace {
+    enum ItemFlags : uint8_t {
+        FLAG_CAN_TAKE = 1,
+        FLAG_CAN_USE = 2
+    };
+    
+    enum DescriptionKind : uint8_t {
+        DESCRIPTION_INLINE = 0,
+        DESCRIPTION_STORED = 1
+    };
+}
+
+void writeItem(ByteWriter& writer, const Item& item, const TextStore* store) {
+    writer.writeByte(static_cast<uint8_t>(item.getType()));
+    writer.writeByte((item.getCanTake() ? FLAG_CAN_TAKE : 0) | (item.getCanUse() ? FLAG_CAN_USE : 0));
+    writer.writeInt(item.getValue());
+    writer.writeString(item.getName());
+    const Text& description = item.getDescriptionText();
+    if (!store) {
+        writer.writeString(description.str());
+    } else if (description.isStored() && description.getStore() == store) {
+        writer.writeByte(DESCRIPTION_STORED);
+        writer.writeVarint(description.getId());
+    } else {
+        writer.writeByte(DESCRIPTION_INLINE);
+        writer.writeString(description.str());
+    }
+    
+    std::string param;
+    if (const Key* key = dynamic_cast<const Key*>(&item)) {
+        param = key->getUnlocks();
+    } else if (const Weapon* weapon = dynamic_cast<const Weapon*>(&item)) {
+        param = std::to_string(weapon->getDamage());
+    } else if (const Consumable* consumable = dynamic_cast<const Consumable*>(&item)) {
+        param = std::to_string(consumable->getHealAmount());
+    } else if (item.getType() == ItemType::TREASURE) {
+        param = std::to_string(item.getValue());
+    }
+    writer.writeString(param);
+}
+
+std::unique_ptr<Item> readItem(ByteReader& reader, const std::shared_ptr<const TextStore>& store) {
+    uint8_t type = reader.readByte();
+    if (type > static_cast<uint8_t>(ItemType::TOOL)) {
+        throw std::runtime_error("Corrupt state data: bad item type");
+    }
+    uint8_t flags = reader.readByte();
+    int value = static_cast<int>(reader.readInt());
+    std::string name = reader.readString();
+    Text description;
+    if (store && reader.readByte() == DESCRIPTION_STORED) {
+        description = Text(store, static_cast<uint32_t>(reader.readVarint()));
+    } else {
+        description = Text(reader.readString());
+    }
+    std::string param = reader.readString();
+    
+    std::unique_ptr<Item> item = createItem(static_cast<ItemType>(type), name, "", param);
+    item->setDescription(std::move(description));
+    item->setCanTake(flags & FLAG_CAN_TAKE);
+    item->setCanUse(flags & FLAG_CAN_USE);
+    item->setValue(value);
+    return item;
+}
@@ -0,0 +1,1318 @@
+#include "Server.h"
+#include "Protocol.h"
+#include "Hibernation.h"
+#include "Migration.h"
+#include "Spectator.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <list>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    const int EPOLL_BATCH = 256;
+    const int STOP_POLL_MS = 200;
+    const size_t READ_CHUNK = 16 * 1024;
+    const size_t MAX_LINE = 64 * 1024;
+    const int SWEEP_INTERVAL_MS = 100;
+    const size_t MAX_HIBERNATIONS_PER_SWEEP = 512; // bounds the pause a sweep adds to the loop
+    const int MIGRATION_TIMEOUT_MS = 2000;
+    const size_t MIGRATIONS_PER_PASS = 64; // sessions moved between two turns of the event loop
+    const size_t MAX_SPECTATOR_REQUEST = 64;
+    const size_t SESSIONS_LISTED = 100;
+    
+    using Clock = std::chrono::steady_clock;
+    
+    std::runtime_error systemError(const std::string& what) {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+    
+    // A non-blocking listening Unix socket at path, replacing a stale one
+    int listenOn(const std::string& path, int type) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + path);
+        }
+        std::strcpy(address.sun_path, path.c_str());
+        
+        int fd = socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw systemError("socket");
+        }
+        unlink(path.c_str()); // a stale socket from a previous run
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            listen(fd, SOMAXCONN) < 0) {
+            close(fd);
+            throw systemError("Cannot listen on " + path);
+        }
+        return fd;
+    }
+    
+    void raiseMax(std::atomic<uint64_t>& maximum, uint64_t value) {
+        uint64_t previous = maximum;
+        while (value > previous && !maximum.compare_exchange_weak(previous, value)) {
+        }
+    }
+    
+    uint64_t nanosSince(Clock::time_point start) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+    
+    // Best effort, for short answers to a spectator that is not watching yet
+    void sendNotice(int fd, const std::string& text) {
+        ssize_t sent = send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+        (void)sent;
+    }
+}
+
+struct Spectator;
+
+// One client: its game, protocol state and unsent replies
+struct Connection {
+    int fd;
+    uint64_t traceSession; // session number; tags this client's trace spans
+    bool tracing = false;  // the game's tracing switch, kept across hibernation
+    MemoryUsage charged;   // what this session adds to its worker's live memory
+    std::unique_ptr<Game> game;
+    std::unique_ptr<ProtocolSession> protocol;
+    std::string input;
+    std::string output;
+    size_t outputSent = 0;
+    bool waitingWritable = false;
+    bool closing = false; // game over: close once the replies are written
+    
+    // Hibernation: while asleep, game and protocol are null and ticket holds the state
+    bool hibernated = false;
+    HibernationStore::Ticket ticket;
+    Clock::time_point lastActive;
+    std::list<Connection*>::iterator activityPosition; // awake connections only
+    
+    std::vector<Spectator*> spectators; // watching this session
+};
+
+// A read-only watcher of one session, served by the session's worker
+struct Spectator {
+    SpectatorQueue queue;
+    Connection* session; // null once the session has ended or moved
+    bool waitingWritable = false;
+    
+    Spectator(int fd, Connection* watched) : queue(fd), session(watched) {}
+};
+
+class ServerWorker {
+private:
+    GameServer& server;
+    int epollFd;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::thread thread;
+    std::atomic<size_t> connectionCount{0};
+    int nextGuest;
+    
+    // Awake connections, least recently active first
+    std::list<Connection*> activity;
+    std::unique_ptr<HibernationStore> store;
+    Clock::time_point nextSweep;
+    std::atomic<size_t> sleepingCount{0};
+    std::atomic<uint64_t> storedBytes{0};    // hibernated state held in memory
+    std::atomic<uint64_t> spilledBytes{0};   // and in the spill file
+    std::atomic<uint64_t> spillFileBytes{0}; // size of that file, free space included
+    
+    // Memory of the awake sessions, summed as they change and published for printStats()
+    MemoryUsage liveMemory;
+    std::array<std::atomic<uint64_t>, MEMORY_CATEGORY_COUNT> publishedMemory{};
+    std::atomic<uint64_t> sessionPeak{0}; // largest high-water mark of any one session
+    
+    // Control channel: wake-ups from other workers, then admin and migration peers
+    int index;
+    int wakeFd;
+    std::unordered_set<int> controlPeers;
+    uint64_t drainsSeen = 0;
+    int drainLink = -1;       // to the server this one was drained to
+    bool drainReported = true; // this worker's part of the latest drain is counted
+    bool replyToDrain = false; // this worker took the drain request
+    int drainReplyFd = -1;
+    
+    // Spectators still sending the number of the session they want, those
+    // watching a session of this worker, and those other workers passed on
+    std::unordered_map<int, std::string> spectatorRequests;
+    std::unordered_map<int, std::unique_ptr<Spectator>> spectators;
+    std::unordered_map<uint64_t, Connection*> sessionsByNumber;
+    std::mutex arrivalsMutex;
+    std::vector<std::pair<int, uint64_t>> arrivals; // connection, session number
+    std::atomic<bool> arrivalsPending{false};
+    
+    void acceptClients();
+    void handleReadable(Connection& connection);
+    bool flush(Connection& connection); // false when the connection failed
+    void closeConnection(int fd, bool finishGame = true);
+    void failSession(int fd, const std::exception& error);
+    void watchWritable(Connection& connection, bool writable);
+    void attachGame(Connection& connection, std::unique_ptr<Game> game);
+    void detachGame(Connection& connection);
+    void touch(Connection& connection);
+    void sweepIdle();
+    void hibernate(Connection& connection);
+    void rehydrate(Connection& connection);
+    void noteStoredBytes(); // publishes the store's sizes for printStats()
+    void chargeMemory(Connection& connection, const MemoryUsage& usage);
+    void noteMemoryHighWater(); // call while all workers run
+    void acceptControl();
+    void handleControl(int fd);
+    void closeControl(int fd);
+    void runCommand(int peerFd, const std::string& command);
+    void adoptSession(MigratedSession session);
+    void startDrain();
+    void finishDrain();
+    void migrateSome();
+    bool migrate(Connection& connection);
+    void registerSession(Connection& connection);
+    void unregisterSession(Connection& connection);
+    void acceptSpectators();
+    void readSpectatorRequest(int fd);
+    void watch(int fd, uint64_t session);
+    void adoptSpectators();
+    void broadcast(Connection& connection, const OutputChunk& chunk);
+    bool flushSpectator(Spectator& spectator); // false when it should be closed
+    void handleSpectator(Spectator& spectator, uint32_t events);
+    void releaseSpectators(Connection& connection, const std::string& farewell);
+    void closeSpectator(int fd);
+
+public:
+    ServerWorker(GameServer& owner, int workerIndex);
+    ~ServerWorker();
+    
+    void run();
+    void start() { thread = std::thread(&ServerWorker::run, this); }
+    void join() { if (thread.joinable()) thread.join(); }
+    size_t getConnectionCount() const { return connectionCount; }
+    size_t getSleepingCount() const { return sleepingCount; }
+    uint64_t getStoredBytes() const { return storedBytes; }
+    uint64_t getSpilledBytes() const { return spilledBytes; }
+    uint64_t getSpillFileBytes() const { return spillFileBytes; }
+    MemoryUsage getLiveMemory() const;
+    uint64_t getSessionPeak() const { return sessionPeak; }
+    
+    // Interrupts epoll_wait; safe from any thread
+    void wake() {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written; // a full counter already means a pending wake-up
+    }
+    
+    // Hands over a spectator of one of this worker's sessions; safe from any thread
+    void postSpectator(int fd, uint64_t session) {
+        {
+            std::lock_guard<std::mutex> lock(arrivalsMutex);
+            arrivals.emplace_back(fd, session);
+        }
+        arrivalsPending = true;
+        wake();
+    }
+};
+
+ServerWorker::ServerWorker(GameServer& owner, int workerIndex)
+    : server(owner), nextGuest(workerIndex * 1000000 + 1), index(workerIndex) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw systemError("epoll_create1");
+    }
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        close(epollFd);
+        throw systemError("eventfd");
+    }
+    // Every worker waits on the listening socket; EPOLLEXCLUSIVE wakes only one per connection
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.fd = server.listenFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, server.listenFd, &event) < 0) {
+        throw systemError("epoll_ctl");
+    }
+    event.data.fd = server.controlFd;
+    if (server.controlFd >= 0 && epoll_ctl(epollFd, EPOLL_CTL_ADD, server.controlFd, &event) < 0) {
+        throw systemError("epoll_ctl");
+    }
+    event.data.fd = server.spectateFd;
+    if (server.spectateFd >= 0 && epoll_ctl(epollFd, EPOLL_CTL_ADD, server.spectateFd, &event) < 0) {
+        throw systemError("epoll_ctl");
+    }
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) < 0) {
+        throw systemError("epoll_ctl");
+    }
+    
+    if (server.hibernateAfter.count() > 0) {
+        std::string spill = server.spillPath.empty() ? "" : server.spillPath + "." + std::to_string(workerIndex);
+        store = std::make_unique<HibernationStore>(server.pool.getPristineState(), spill);
+    }
+    nextSweep = Clock::now();
+}
+
+ServerWorker::~ServerWorker() {
+    join();
+    while (!connections.empty()) {
+        closeConnection(connections.begin()->first);
+    }
+    while (!controlPeers.empty()) {
+        closeControl(*controlPeers.begin());
+    }
+    while (!spectators.empty()) {
+        closeSpectator(spectators.begin()->first);
+    }
+    for (const auto& request : spectatorRequests) {
+        close(request.first);
+    }
+    for (const auto& arrival : arrivals) {
+        close(arrival.first);
+    }
+    if (drainLink >= 0) {
+        close(drainLink);
+    }
+    close(wakeFd);
+    close(epollFd);
+}
+
+void ServerWorker::run() {
+    epoll_event events[EPOLL_BATCH];
+    while (!server.stopping) {
+        int ready = epoll_wait(epollFd, events, EPOLL_BATCH, STOP_POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            // This worker can no longer wait for anything: stop the server
+            // in order, so every worker ends and saves its sessions as usual
+            std::cerr << "Error: " << systemError("epoll_wait").what() << "; stopping the server\n";
+            server.stop();
+            return;
+        }
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == server.listenFd) {
+                acceptClients();
+                continue;
+            }
+            if (fd == wakeFd) {
+                uint64_t count;
+                ssize_t drained = read(wakeFd, &count, sizeof(count));
+                (void)drained;
+                continue;
+            }
+            if (fd == server.controlFd) {
+                acceptControl();
+                continue;
+            }
+            if (controlPeers.count(fd)) {
+                handleControl(fd);
+                continue;
+            }
+            if (fd == server.spectateFd) {
+                acceptSpectators();
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) {
+                auto watcher = spectators.find(fd);
+                if (watcher != spectators.end()) {
+                    handleSpectator(*watcher->second, events[i].events);
+                } else if (spectatorRequests.count(fd)) {
+                    readSpectatorRequest(fd);
+                }
+                continue;
+            }
+            Connection& connection = *it->second;
+            uint64_t session = connection.traceSession;
+            try {
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(fd);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    handleReadable(connection);
+                } else if ((events[i].events & EPOLLOUT) && !flush(connection)) {
+                    closeConnection(fd);
+                }
+            } catch (const std::exception& e) {
+                // A failure inside one session drops that client, not the server
+                std::cerr << "Error: session " << session << ": " << e.what() << "\n";
+                closeConnection(fd);
+            }
+        }
+        
+        if (arrivalsPending.exchange(false)) {
+            adoptSpectators();
+        }
+        if (store && Clock::now() >= nextSweep) {
+            sweepIdle();
+            nextSweep = Clock::now() + std::chrono::milliseconds(SWEEP_INTERVAL_MS);
+        }
+        if (server.drainGeneration != drainsSeen) {
+            drainsSeen = server.drainGeneration;
+            startDrain();
+        }
+        if (drainLink >= 0 || !drainReported) {
+            migrateSome(); // clients that arrive after the drain follow it
+        }
+        if (replyToDrain && server.drainPending == 0) {
+            finishDrain();
+        }
+        if (server.statsRequested.exchange(false)) {
+            server.printStats(std::cerr);
+            if (!server.traceFile.empty()) {
+                try {
+                    Tracer::exportFile(server.traceFile);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: " << e.what() << "\n"; // keep serving
+                }
+            }
+        }
+    }
+}
+
+void ServerWorker::acceptClients() {
+    while (true) {
+        int fd = accept4(server.listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN: another worker took it, or the backlog is empty
+        }
+        
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->traceSession = server.sessionNumber(nextGuest);
+        bool attached = false;
+        try {
+            attachGame(*connection, server.pool.acquire());
+            attached = true;
+            connection->game->setSeed(server.seed, connection->traceSession);
+            connection->game->begin("Guest" + std::to_string(nextGuest++));
+        } catch (const std::exception& e) {
+            // Turn this client away; the worker keeps serving everyone else
+            std::cerr << "Error: session " << connection->traceSession << " cannot start: " << e.what() << "\n";
+            if (attached) {
+                detachGame(*connection);
+            }
+            close(fd);
+            continue;
+        }
+        
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            detachGame(*connection);
+            close(fd);
+            continue;
+        }
+        Connection& accepted = *connection;
+        connections[fd] = std::move(connection);
+        ++connectionCount;
+        registerSession(accepted);
+    }
+}
+
+void ServerWorker::handleReadable(Connection& connection) {
+    int fd = connection.fd;
+    char chunk[READ_CHUNK];
+    bool peerClosed = false;
+    while (true) {
+        ssize_t received = read(fd, chunk, sizeof(chunk));
+        if (received > 0) {
+            connection.input.append(chunk, static_cast<size_t>(received));
+            continue;
+        }
+        if (received == 0) {
+            peerClosed = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            peerClosed = true;
+        }
+        break;
+    }
+    
+    if (connection.hibernated && (!peerClosed || connection.input.find('\n') != std::string::npos)) {
+        try {
+            rehydrate(connection);
+        } catch (const std::exception& e) {
+            failSession(fd, e);
+            return;
+        }
+    }
+    if (!connection.hibernated) {
+        touch(connection);
+    }
+    
+    // Every complete line is a request; replies for the whole burst go out in one write
+    size_t start = 0;
+    size_t newline;
+    while (!connection.closing && (newline = connection.input.find('\n', start)) != std::string::npos) {
+        std::string_view line(connection.input.data() + start, newline - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!line.empty()) {
+            connection.protocol->handleLine(line, connection.output);
+            if (!connection.spectators.empty()) {
+                // Rendered once; every spectator sends from the same buffer
+                const ProtocolSession& protocol = *connection.protocol;
+                auto chunk = std::make_shared<std::string>();
+                chunk->reserve(protocol.getCommand().size() + protocol.getText().size() + 3);
+                chunk->append("> ").append(protocol.getCommand()).append("\n").append(protocol.getText());
+                broadcast(connection, std::move(chunk));
+            }
+            if (!connection.game->isRunning()) {
+                connection.closing = true;
+            }
+        }
+        start = newline + 1;
+    }
+    connection.input.erase(0, start);
+    if (!connection.hibernated) {
+        MemoryUsage usage = connection.game->getMemoryUsage();
+        usage[MemoryCategory::BUFFERS] += sizeof(Connection) + connection.input.capacity();
+        chargeMemory(connection, usage);
+        noteMemoryHighWater();
+        uint64_t peak = connection.game->getMemoryPeakTotal();
+        if (peak > sessionPeak.load(std::memory_order_relaxed)) {
+            sessionPeak.store(peak, std::memory_order_relaxed);
+        }
+    }
+    if (connection.input.size() > MAX_LINE) {
+        peerClosed = true;
+    }
+    
+    if (peerClosed) {
+        // A disconnect ends the game like closed stdin; answer what was asked first
+        flush(connection);
+        closeConnection(fd);
+        return;
+    }
+    if (!flush(connection)) {
+        closeConnection(fd);
+    }
+}
+
+bool ServerWorker::flush(Connection& connection) {
+    TraceScope trace(connection.traceSession, connection.game ? connection.game->isTracing() : connection.tracing);
+    TraceSpan span("flush");
+    while (connection.outputSent < connection.output.size()) {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.outputSent,
+                            connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Slow reader: wait for room in the socket buffer
+                watchWritable(connection, true);
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        connection.outputSent += static_cast<size_t>(sent);
+    }
+    
+    connection.output.clear();
+    connection.outputSent = 0;
+    watchWritable(connection, false);
+    return !connection.closing;
+}
+
+void ServerWorker::watchWritable(Connection& connection, bool writable) {
+    if (connection.waitingWritable == writable) {
+        return;
+    }
+    connection.waitingWritable = writable;
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.fd = connection.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void ServerWorker::closeConnection(int fd, bool finishGame) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return;
+    }
+    std::unique_ptr<Connection> connection = std::move(it->second);
+    connections.erase(it);
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    unregisterSession(*connection);
+    releaseSpectators(*connection, "Session ended\n");
+    
+    // The game has to be awake to end: that is where its score is recorded
+    if (finishGame) {
+        try {
+            if (connection->hibernated) {
+                rehydrate(*connection);
+            }
+            connection->game->endGame();
+        } catch (const std::exception& e) {
+            // Its saved game could not be read back, or its score not recorded
+            std::cerr << "Error: session " << connection->traceSession << " did not end cleanly: "
+                      << e.what() << "\n";
+        }
+    }
+    if (connection->hibernated) {
+        store->discard(connection->ticket);
+        --sleepingCount;
+        noteStoredBytes();
+    } else {
+        detachGame(*connection);
+    }
+    --connectionCount;
+}
+
+void ServerWorker::failSession(int fd, const std::exception& error) {
+    // The saved game could not be restored: tell the client, then let go of
+    // the connection without ending a game that no longer exists
+    Connection& connection = *connections.at(fd);
+    std::cerr << "Error: session " << connection.traceSession << " lost: " << error.what() << "\n";
+    JsonWriter writer(connection.output);
+    writer.beginObject();
+    writer.rawField("id", "null");
+    writer.field("status", "session_lost");
+    writer.endObject();
+    connection.output.push_back('\n');
+    flush(connection);
+    closeConnection(fd, false);
+}
+
+void ServerWorker::attachGame(Connection& connection, std::unique_ptr<Game> game) {
+    connection.game = std::move(game);
+    connection.game->setLeaderboard(server.leaderboard);
+    connection.game->setAnalytics(server.analytics);
+    connection.game->setTraceSession(connection.traceSession);
+    connection.game->setTracing(connection.tracing);
+    connection.protocol = std::make_unique<ProtocolSession>(*connection.game);
+    connection.lastActive = Clock::now();
+    connection.activityPosition = activity.insert(activity.end(), &connection);
+}
+
+void ServerWorker::detachGame(Connection& connection) {
+    chargeMemory(connection, MemoryUsage());
+    activity.erase(connection.activityPosition);
+    connection.protocol.reset();
+    connection.game->setLeaderboard(nullptr);
+    connection.game->setAnalytics(nullptr);
+    connection.tracing = connection.game->isTracing();
+    connection.game->setTracing(false);
+    server.pool.release(std::move(connection.game));
+}
+
+void ServerWorker::touch(Connection& connection) {
+    connection.lastActive = Clock::now();
+    activity.splice(activity.end(), activity, connection.activityPosition);
+}
+
+void ServerWorker::sweepIdle() {
+    Clock::time_point now = Clock::now();
+    size_t budget = MAX_HIBERNATIONS_PER_SWEEP;
+    while (!activity.empty() && budget > 0) {
+        Connection& connection = *activity.front();
+        if (now - connection.lastActive < server.hibernateAfter) {
+            break;
+        }
+        if (connection.output.empty() && !connection.closing && connection.game->isRunning()) {
+            try {
+                hibernate(connection);
+            } catch (const std::exception& e) {
+                // Nothing was given up yet; the session just stays awake
+                std::cerr << "Error: session " << connection.traceSession << " cannot hibernate: "
+                          << e.what() << "\n";
+                touch(connection);
+            }
+            --budget;
+        } else {
+            touch(connection); // busy finishing a reply; look again later
+        }
+    }
+}
+
+void ServerWorker::hibernate(Connection& connection) {
+    connection.ticket = store->store(connection.game->saveState());
+    detachGame(connection);
+    std::string().swap(connection.output);
+    connection.outputSent = 0;
+    if (connection.input.empty()) {
+        std::string().swap(connection.input);
+    }
+    connection.hibernated = true;
+    
+    ++sleepingCount;
+    noteStoredBytes();
+    ++server.hibernations;
+}
+
+void ServerWorker::noteStoredBytes() {
+    storedBytes = store->getMemoryBytes();
+    spilledBytes = store->getDiskBytes();
+    spillFileBytes = store->getSpillFileBytes();
+}
+
+void ServerWorker::rehydrate(Connection& connection) {
+    Clock::time_point start = Clock::now();
+    std::string state = store->load(connection.ticket);
+    attachGame(connection, server.pool.acquire(state));
+    connection.hibernated = false;
+    
+    --sleepingCount;
+    noteStoredBytes();
+    ++server.rehydrations;
+    uint64_t nanos = nanosSince(start);
+    server.rehydrateNanosTotal += nanos;
+    raiseMax(server.rehydrateNanosMax, nanos);
+}
+
+void ServerWorker::chargeMemory(Connection& connection, const MemoryUsage& usage) {
+    liveMemory.subtract(connection.charged);
+    liveMemory.add(usage);
+    connection.charged = usage;
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+        publishedMemory[i].store(liveMemory.bytes[i], std::memory_order_relaxed);
+    }
+}
+
+void ServerWorker::noteMemoryHighWater() {
+    // The process high-water mark is taken over the sum of every worker's published usage
+    uint64_t total = 0;
+    for (const auto& worker : server.workers) {
+        total += worker->getLiveMemory().total();
+    }
+    raiseMax(server.memoryHighWater, total);
+}
+
+MemoryUsage ServerWorker::getLiveMemory() const {
+    MemoryUsage usage;
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+        usage.bytes[i] = publishedMemory[i].load(std::memory_order_relaxed);
+    }
+    return usage;
+}
+
+void ServerWorker::acceptControl() {
+    while (true) {
+        int fd = accept4(server.controlFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        controlPeers.insert(fd);
+    }
+}
+
+void ServerWorker::handleControl(int fd) {
+    std::string payload;
+    int passedFd;
+    while (true) {
+        migration::Receive result = migration::receiveMessage(fd, payload, passedFd);
+        if (result == migration::Receive::WOULD_BLOCK) {
+            return;
+        }
+        if (result == migration::Receive::CLOSED) {
+            closeControl(fd);
+            return;
+        }
+        
+        if (passedFd < 0) {
+            runCommand(fd, payload);
+            continue;
+        }
+        try {
+            adoptSession(migration::decodeSession(payload, passedFd));
+        } catch (const std::exception& e) {
+            // Not something this server can resume; the client is dropped
+            std::cerr << "Error: rejected migrated session: " << e.what() << "\n";
+            close(passedFd);
+        }
+    }
+}
+
+void ServerWorker::closeControl(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    controlPeers.erase(fd);
+    if (fd == drainReplyFd) {
+        drainReplyFd = -1; // the requester left; the drain still completes
+    }
+}
+
+void ServerWorker::runCommand(int peerFd, const std::string& command) {
+    std::string reply;
+    if (command.rfind("drain ", 0) == 0) {
+        if (server.drainRunning.exchange(true)) {
+            reply = "error: a drain is already running";
+        } else {
+            {
+                std::lock_guard<std::mutex> lock(server.drainMutex);
+                server.drainTarget = command.substr(6);
+                server.drainStart = Clock::now();
+            }
+            server.drainMigrated = 0;
+            server.drainFailed = 0;
+            server.drainPauseMax = 0;
+            server.drainPending = static_cast<int>(server.workers.size());
+            ++server.drainGeneration;
+            replyToDrain = true;
+            drainReplyFd = peerFd;
+            for (const auto& worker : server.workers) {
+                worker->wake();
+            }
+            return; // answered by finishDrain()
+        }
+    } else if (command == "stats") {
+        std::ostringstream stats;
+        server.printStats(stats);
+        reply = stats.str();
+    } else if (command == "stop") {
+        server.stop();
+        reply = "stopping";
+    } else {
+        reply = "error: unknown command (expected drain <control socket>, stats or stop)";
+    }
+    
+    try {
+        migration::sendMessage(peerFd, reply);
+    } catch (const std::exception&) {
+        // The peer went away; its hang-up closes it
+    }
+}
+
+void ServerWorker::adoptSession(MigratedSession session) {
+    auto connection = std::make_unique<Connection>();
+    connection->fd = session.fd;
+    connection->traceSession = session.traceSession;
+    connection->tracing = session.tracing;
+    attachGame(*connection, server.pool.acquire(session.state));
+    connection->input = std::move(session.input);
+    connection->output = std::move(session.output);
+    
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = connection->fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, connection->fd, &event) < 0) {
+        detachGame(*connection);
+        throw systemError("epoll_ctl");
+    }
+    Connection& adopted = *connection;
+    connections[adopted.fd] = std::move(connection);
+    ++connectionCount;
+    ++server.migratedIn;
+    registerSession(adopted);
+    
+    // Replies the old server had not written yet go out first
+    if (!flush(adopted)) {
+        closeConnection(adopted.fd);
+    }
+}
+
+void ServerWorker::startDrain() {
+    std::string target;
+    {
+        std::lock_guard<std::mutex> lock(server.drainMutex);
+        target = server.drainTarget;
+    }
+    acceptClients(); // clients still queued on the listening socket move with the rest
+    
+    if (drainLink >= 0) {
+        close(drainLink);
+        drainLink = -1;
+    }
+    try {
+        drainLink = migration::connectControl(target, MIGRATION_TIMEOUT_MS);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: drain to " << target << ": " << e.what() << "\n";
+    }
+    drainReported = false;
+}
+
+void ServerWorker::finishDrain() {
+    replyToDrain = false;
+    Clock::time_point start;
+    {
+        std::lock_guard<std::mutex> lock(server.drainMutex);
+        start = server.drainStart;
+    }
+    std::ostringstream reply;
+    reply << "drained " << server.drainMigrated << " sessions (" << server.drainFailed
+          << " not moved) in " << nanosSince(start) / 1e6 << " ms, longest pause "
+          << server.drainPauseMax / 1000.0 << " us";
+    if (drainReplyFd >= 0) {
+        try {
+            migration::sendMessage(drainReplyFd, reply.str());
+        } catch (const std::exception&) {
+        }
+        drainReplyFd = -1;
+    }
+    server.drainRunning = false;
+}
+
+void ServerWorker::migrateSome() {
+    // A pass moves a bounded number of sessions, so the ones still waiting
+    // keep being served between passes and each pauses only for its own move
+    std::vector<int> movable;
+    for (const auto& entry : connections) {
+        if (!entry.second->closing) {
+            movable.push_back(entry.first); // finishing games close here as usual
+        }
+    }
+    size_t moved = 0;
+    for (int fd : movable) {
+        if (moved == MIGRATIONS_PER_PASS || drainLink < 0) {
+            break;
+        }
+        try {
+            if (!migrate(*connections[fd])) {
+                break;
+            }
+        } catch (const std::exception& e) {
+            failSession(fd, e); // its hibernated game cannot be read back
+            continue;
+        }
+        ++moved;
+    }
+    size_t left = movable.size() - moved;
+    
+    if (!drainReported) {
+        server.drainMigrated += moved;
+        if (moved == MIGRATIONS_PER_PASS && left > 0 && drainLink >= 0) {
+            wake(); // more to move: come straight back
+            return;
+        }
+        // Done, or no progress (target gone, sessions too large to send)
+        drainReported = true;
+        server.drainFailed += left;
+        if (server.drainPending.fetch_sub(1) == 1) {
+            for (const auto& worker : server.workers) {
+                worker->wake(); // the one that took the request replies
+            }
+        }
+    } else if (moved == MIGRATIONS_PER_PASS) {
+        wake();
+    }
+}
+
+bool ServerWorker::migrate(Connection& connection) {
+    // Requests are handled whole, so between events every session is at a command boundary
+    Clock::time_point start = Clock::now();
+    MigratedSession session;
+    session.fd = connection.fd;
+    session.traceSession = connection.traceSession;
+    if (connection.hibernated) {
+        session.state = store->load(connection.ticket);
+        session.tracing = connection.tracing;
+    } else {
+        session.state = connection.game->saveState();
+        session.tracing = connection.game->isTracing();
+    }
+    session.input = connection.input;
+    session.output = connection.output.substr(connection.outputSent);
+    
+    std::string payload = migration::encodeSession(session);
+    bool sent = false;
+    if (payload.size() <= migration::MAX_MESSAGE) {
+        try {
+            migration::sendMessage(drainLink, payload, connection.fd);
+            sent = true;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: migration: " << e.what() << "\n";
+            close(drainLink); // the target is gone; the rest stay here
+            drainLink = -1;
+        }
+    }
+    if (!sent) {
+        if (connection.hibernated) {
+            connection.ticket = store->store(session.state);
+        }
+        return false;
+    }
+    
+    // The target holds the connection now; let go of it without ending the game
+    int fd = connection.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    unregisterSession(connection);
+    releaseSpectators(connection, "Session moved to another server\n");
+    if (connection.hibernated) {
+        --sleepingCount;
+        noteStoredBytes();
+    } else {
+        detachGame(connection);
+    }
+    connections.erase(fd);
+    --connectionCount;
+    ++server.migratedOut;
+    raiseMax(server.drainPauseMax, nanosSince(start));
+    return true;
+}
+
+void ServerWorker::registerSession(Connection& connection) {
+    if (server.spectateFd < 0) {
+        return;
+    }
+    sessionsByNumber[connection.traceSession] = &connection;
+    std::lock_guard<std::mutex> lock(server.sessionsMutex);
+    server.sessionWorkers[connection.traceSession] = index;
+}
+
+void ServerWorker::unregisterSession(Connection& connection) {
+    if (server.spectateFd < 0) {
+        return;
+    }
+    auto local = sessionsByNumber.find(connection.traceSession);
+    if (local == sessionsByNumber.end() || local->second != &connection) {
+        return; // a session migrated in under the same number replaced it
+    }
+    sessionsByNumber.erase(local);
+    std::lock_guard<std::mutex> lock(server.sessionsMutex);
+    auto owner = server.sessionWorkers.find(connection.traceSession);
+    if (owner != server.sessionWorkers.end() && owner->second == index) {
+        server.sessionWorkers.erase(owner);
+    }
+}
+
+void ServerWorker::acceptSpectators() {
+    while (true) {
+        int fd = accept4(server.spectateFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        spectatorRequests[fd];
+    }
+}
+
+void ServerWorker::readSpectatorRequest(int fd) {
+    std::string& request = spectatorRequests[fd];
+    char chunk[256];
+    bool closed = false;
+    while (true) {
+        ssize_t received = read(fd, chunk, sizeof(chunk));
+        if (received > 0) {
+            request.append(chunk, static_cast<size_t>(received));
+            continue;
+        }
+        closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+        break;
+    }
+    
+    // One line per request: "list", or the number of the session to watch
+    size_t newline;
+    while (!closed && (newline = request.find('\n')) != std::string::npos) {
+        std::string line = request.substr(0, newline);
+        request.erase(0, newline + 1);
+        line.erase(std::remove_if(line.begin(), line.end(), [](char ch) { return ch == ' ' || ch == '\r'; }), line.end());
+        
+        if (line == "list") {
+            std::vector<uint64_t> numbers;
+            {
+                std::lock_guard<std::mutex> lock(server.sessionsMutex);
+                for (const auto& entry : server.sessionWorkers) {
+                    numbers.push_back(entry.first);
+                }
+            }
+            std::sort(numbers.begin(), numbers.end());
+            std::string reply = std::to_string(numbers.size()) + " sessions:";
+            for (size_t i = 0; i < numbers.size() && i < SESSIONS_LISTED; ++i) {
+                reply += " " + std::to_string(numbers[i]);
+            }
+            sendNotice(fd, reply + (numbers.size() > SESSIONS_LISTED ? " ...\n" : "\n"));
+            continue;
+        }
+        uint64_t number = 0;
+        auto parsed = std::from_chars(line.data(), line.data() + line.size(), number);
+        if (line.empty() || parsed.ec != std::errc() || parsed.ptr != line.data() + line.size()) {
+            sendNotice(fd, "Send the number of a session to watch, or list\n");
+            continue;
+        }
+        int owner = -1;
+        {
+            std::lock_guard<std::mutex> lock(server.sessionsMutex);
+            auto found = server.sessionWorkers.find(number);
+            if (found != server.sessionWorkers.end()) {
+                owner = found->second;
+            }
+        }
+        if (owner < 0) {
+            sendNotice(fd, "No session " + line + "\n");
+            continue;
+        }
+        // The session's worker serves its spectators
+        spectatorRequests.erase(fd);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        if (owner == index) {
+            watch(fd, number);
+        } else {
+            server.workers[static_cast<size_t>(owner)]->postSpectator(fd, number);
+        }
+        return;
+    }
+    if (closed || request.size() > MAX_SPECTATOR_REQUEST) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        spectatorRequests.erase(fd);
+    }
+}
+
+void ServerWorker::watch(int fd, uint64_t session) {
+    auto found = sessionsByNumber.find(session);
+    if (found == sessionsByNumber.end()) {
+        // It ended or moved while the spectator was on its way
+        sendNotice(fd, "No session " + std::to_string(session) + "\n");
+        close(fd);
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        close(fd);
+        return;
+    }
+    auto spectator = std::make_unique<Spectator>(fd, found->second);
+    Spectator& added = *spectator;
+    found->second->spectators.push_back(&added);
+    spectators[fd] = std::move(spectator);
+    ++server.spectatorCount;
+    
+    added.queue.push(std::make_shared<const std::string>("Watching session " + std::to_string(session) + "\n"));
+    if (!flushSpectator(added)) {
+        closeSpectator(fd);
+    }
+}
+
+void ServerWorker::adoptSpectators() {
+    std::vector<std::pair<int, uint64_t>> arrived;
+    {
+        std::lock_guard<std::mutex> lock(arrivalsMutex);
+        arrived.swap(arrivals);
+    }
+    for (const auto& arrival : arrived) {
+        watch(arrival.first, arrival.second);
+    }
+}
+
+void ServerWorker::broadcast(Connection& connection, const OutputChunk& chunk) {
+    std::vector<int> closing;
+    for (Spectator* spectator : connection.spectators) {
+        uint64_t skippedBefore = spectator->queue.getSkipped();
+        if (!spectator->queue.push(chunk)) {
+            ++server.spectatorsDropped; // not keeping up at all
+            closing.push_back(spectator->queue.getFd());
+            continue;
+        }
+        server.spectatorSkips += spectator->queue.getSkipped() - skippedBefore;
+        if (!spectator->waitingWritable && !flushSpectator(*spectator)) {
+            closing.push_back(spectator->queue.getFd());
+        }
+    }
+    for (int fd : closing) {
+        closeSpectator(fd);
+    }
+}
+
+bool ServerWorker::flushSpectator(Spectator& spectator) {
+    SpectatorQueue::Send result = spectator.queue.send();
+    if (result == SpectatorQueue::Send::FAILED) {
+        return false;
+    }
+    bool writable = result == SpectatorQueue::Send::BLOCKED;
+    if (spectator.waitingWritable != writable) {
+        spectator.waitingWritable = writable;
+        epoll_event event{};
+        event.events = EPOLLIN | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        event.data.fd = spectator.queue.getFd();
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, event.data.fd, &event);
+    }
+    return writable || spectator.session != nullptr; // a released spectator closes once its farewell is out
+}
+
+void ServerWorker::handleSpectator(Spectator& spectator, uint32_t events) {
+    int fd = spectator.queue.getFd();
+    if (events & EPOLLERR) {
+        closeSpectator(fd);
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLHUP)) {
+        // Spectators are read-only: anything they send is ignored until they hang up
+        char chunk[256];
+        ssize_t received;
+        while ((received = read(fd, chunk, sizeof(chunk))) > 0) {
+        }
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            closeSpectator(fd);
+            return;
+        }
+    }
+    if ((events & EPOLLOUT) && !flushSpectator(spectator)) {
+        closeSpectator(fd);
+    }
+}
+
+void ServerWorker::releaseSpectators(Connection& connection, const std::string& farewell) {
+    if (connection.spectators.empty()) {
+        return;
+    }
+    auto note = std::make_shared<const std::string>(farewell);
+    std::vector<Spectator*> watching;
+    watching.swap(connection.spectators);
+    for (Spectator* spectator : watching) {
+        spectator->session = nullptr;
+        if (!spectator->queue.push(note) || !flushSpectator(*spectator)) {
+            closeSpectator(spectator->queue.getFd());
+        }
+    }
+}
+
+void ServerWorker::closeSpectator(int fd) {
+    auto it = spectators.find(fd);
+    if (it == spectators.end()) {
+        return;
+    }
+    if (Connection* session = it->second->session) {
+        auto& watching = session->spectators;
+        watching.erase(std::find(watching.begin(), watching.end(), it->second.get()));
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    spectators.erase(it);
+    --server.spectatorCount;
+}
+
+GameServer::GameServer(const std::string& path, SessionPool& sessionPool,
+                       Leaderboard* board, Analytics* stats)
+    : socketPath(path), listenFd(-1), pool(sessionPool), leaderboard(board),
+      analytics(stats), stopping(false), statsRequested(false), hibernateAfter(0), seed(0), serverId(0),
+      hibernations(0), rehydrations(0), rehydrateNanosTotal(0), rehydrateNanosMax(0),
+      memoryHighWater(0), controlFd(-1), drainGeneration(0), drainPending(0), drainRunning(false),
+      drainMigrated(0), drainFailed(0), drainPauseMax(0), migratedOut(0), migratedIn(0),
+      spectateFd(-1), spectatorCount(0), spectatorsDropped(0), spectatorSkips(0) {
+    // Never 0, the id of numbers from servers that had none
+    std::random_device device;
+    serverId = device() % SERVER_IDS + 1;
+    listenFd = listenOn(socketPath, SOCK_STREAM);
+}
+
+GameServer::~GameServer() {
+    stop();
+    workers.clear();
+    close(listenFd);
+    unlink(socketPath.c_str());
+    if (controlFd >= 0) {
+        close(controlFd);
+        unlink(controlPath.c_str());
+    }
+    if (spectateFd >= 0) {
+        close(spectateFd);
+        unlink(spectatePath.c_str());
+    }
+}
+
+void GameServer::setControlSocket(const std::string& path) {
+    controlFd = listenOn(path, SOCK_SEQPACKET);
+    controlPath = path;
+}
+
+void GameServer::setSpectatorSocket(const std::string& path) {
+    spectateFd = listenOn(path, SOCK_STREAM);
+    spectatePath = path;
+}
+
+void GameServer::run(int workerCount) {
+    if (workerCount <= 0) {
+        workerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        workers.push_back(std::make_unique<ServerWorker>(*this, i));
+    }
+    // The calling thread serves as the first worker
+    for (size_t i = 1; i < workers.size(); ++i) {
+        workers[i]->start();
+    }
+    workers[0]->run();
+    for (auto& worker : workers) {
+        worker->join();
+    }
+}
+
+size_t GameServer::getConnectionCount() const {
+    size_t count = 0;
+    for (const auto& worker : workers) {
+        count += worker->getConnectionCount();
+    }
+    return count;
+}
+
+
+void GameServer::setHibernation(double idleSeconds, const std::string& spillFilePrefix) {
+    hibernateAfter = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(idleSeconds));
+    spillPath = spillFilePrefix;
+}
+
+void GameServer::printStats(std::ostream& os) const {
+    size_t sleeping = 0;
+    uint64_t bytes = 0;
+    uint64_t spilled = 0;
+    uint64_t spillFiles = 0;
+    for (const auto& worker : workers) {
+        sleeping += worker->getSleepingCount();
+        bytes += worker->getStoredBytes();
+        spilled += worker->getSpilledBytes();
+        spillFiles += worker->getSpillFileBytes();
+    }
+    uint64_t rehydrated = rehydrations;
+    os << "connections " << getConnectionCount() << ", hibernated " << sleeping << " (" << bytes << " bytes";
+    if (!spillPath.empty()) {
+        os << " in memory, " << spilled << " spilled in " << spillFiles << " bytes of spill files";
+    }
+    os << ")"
+       << ", hibernations " << hibernations << ", rehydrations " << rehydrated;
+    if (rehydrated > 0) {
+        os << ", rehydrate avg " << rehydrateNanosTotal / rehydrated / 1000.0
+           << " us max " << rehydrateNanosMax / 1000.0 << " us";
+    }
+    os << ", pool built " << pool.getGamesBuilt() << " reused " << pool.getGamesReused();
+    if (controlFd >= 0) {
+        os << ", migrated out " << migratedOut << " in " << migratedIn;
+    }
+    if (spectateFd >= 0) {
+        os << ", spectators " << spectatorCount << " (skipped " << spectatorSkips
+           << " responses, dropped " << spectatorsDropped << ")";
+    }
+    os << "\n";
+    
+    MemoryUsage live;
+    uint64_t sessionPeak = 0;
+    for (const auto& worker : workers) {
+        live.add(worker->getLiveMemory());
+        sessionPeak = std::max(sessionPeak, worker->getSessionPeak());
+    }
+    size_t awake = getConnectionCount() - sleeping;
+    os << "memory of " << awake << " awake sessions " << live.total() << " bytes (";
+    live.print(os);
+    os << "), per session " << (awake ? live.total() / awake : 0) << " bytes, high-water "
+       << memoryHighWater << " bytes, largest session " << sessionPeak << " bytes\n";
+}
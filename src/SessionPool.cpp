@@ -0,0 +1,69 @@
+#include "SessionPool.h"
+#include <iostream>
+
+SessionPool::SessionPool(size_t prewarm, size_t maxIdle)
+    : maxIdle(maxIdle), gamesBuilt(0), gamesReused(0) {
+    auto game = std::make_unique<Game>();
+    pristineState = game->saveState();
+    ++gamesBuilt;
+    idle.push_back(std::move(game));
+    
+    while (idle.size() < prewarm && idle.size() < maxIdle) {
+        idle.push_back(std::make_unique<Game>());
+        ++gamesBuilt;
+    }
+}
+
+std::unique_ptr<Game> SessionPool::acquire() {
+    return acquire(pristineState);
+}
+
+std::unique_ptr<Game> SessionPool::acquire(const std::string& state) {
+    std::unique_ptr<Game> game;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            game = std::move(idle.back());
+            idle.pop_back();
+            ++gamesReused;
+        } else {
+            ++gamesBuilt;
+        }
+    }
+    
+    // Building and resetting happen outside the lock
+    if (!game) {
+        game = std::make_unique<Game>();
+        if (&state == &pristineState) {
+            return game;
+        }
+    }
+    game->restoreState(state);
+    game->setOutput(std::cout);
+    return game;
+}
+
+void SessionPool::release(std::unique_ptr<Game> game) {
+    if (!game) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < maxIdle) {
+        idle.push_back(std::move(game));
+    }
+}
+
+size_t SessionPool::getIdleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
+
+size_t SessionPool::getGamesBuilt() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return gamesBuilt;
+}
+
+size_t SessionPool::getGamesReused() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return gamesReused;
+}
@@ -0,0 +1,492 @@
+#include "SharedWorld.h"
+#include "Player.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <sstream>
+#include <unordered_set>
+
+// Messages exchanged between actors. Items travel inside messages, so
+// ownership moves with them and nothing is ever shared between actors.
+struct ActorMessage {
+    enum class Kind {
+        COMMAND,      // player: a command line from the client
+        TAKE,         // room: player wants an item
+        ITEM_GRANTED, // player: room handed over an item
+        DEPOSIT,      // room: an item is put down here
+        MOVE,         // room: player wants to leave through an exit
+        ENTER,        // room: player arrives from another room
+        ARRIVED,      // player: entry accepted
+        LEAVE,        // room: player has gone elsewhere
+        LOOK,         // room: describe yourself to the player
+        TEXT          // player: reply text for the client
+    };
+    
+    Kind kind;
+    PlayerActor* player = nullptr;
+    std::string text;
+    int roomId = -1;
+    std::unique_ptr<Item> item;
+    std::vector<std::string> keys;
+    
+    ActorMessage(Kind messageKind, PlayerActor* sender) : kind(messageKind), player(sender) {}
+};
+
+// A worker runs the actors hashed to it. Actors never migrate between
+// workers, so each actor's state is only touched by one thread.
+class ActorWorker {
+private:
+    std::mutex readyMutex;
+    std::condition_variable readyCondition;
+    std::deque<Actor*> readyQueue;
+    bool stopping = false;
+    std::thread thread;
+    
+    void run();
+
+public:
+    alignas(64) std::atomic<size_t> sent{0};
+    alignas(64) std::atomic<size_t> processed{0};
+    
+    void start() { thread = std::thread(&ActorWorker::run, this); }
+    void stop();
+    void schedule(Actor* actor);
+};
+
+class Actor {
+private:
+    std::mutex mailboxMutex;
+    std::deque<ActorMessage> mailbox;
+    bool scheduled = false;
+
+protected:
+    SharedWorld& world;
+    ActorWorker& worker;
+    
+    virtual void receive(ActorMessage& message) = 0;
+
+public:
+    Actor(SharedWorld& sharedWorld, ActorWorker& owner) : world(sharedWorld), worker(owner) {}
+    virtual ~Actor() = default;
+    
+    void post(ActorMessage message);
+    bool drain(); // returns true if more messages arrived meanwhile
+};
+
+class RoomActor : public Actor {
+private:
+    std::unique_ptr<Room> room;
+    std::unordered_set<PlayerActor*> occupants;
+    
+    void handleTake(ActorMessage& message);
+    void handleMove(ActorMessage& message);
+    void handleEnter(ActorMessage& message);
+
+protected:
+    void receive(ActorMessage& message) override;
+
+public:
+    RoomActor(SharedWorld& sharedWorld, ActorWorker& owner, std::unique_ptr<Room> ownedRoom)
+        : Actor(sharedWorld, owner), room(std::move(ownedRoom)) {}
+    
+    std::string describe() const;
+    void countItems(std::map<std::string, int>& counts) const;
+};
+
+class PlayerActor : public Actor {
+private:
+    Player player;
+    int currentRoomId;
+    int score;
+    SharedWorld::OutputHandler output;
+    
+    void handleCommand(const std::string& command);
+    void reply(const std::string& text) { if (output) output(text); }
+
+protected:
+    void receive(ActorMessage& message) override;
+
+public:
+    PlayerActor(SharedWorld& sharedWorld, ActorWorker& owner, const std::string& name,
+                int startRoom, SharedWorld::OutputHandler handler)
+        : Actor(sharedWorld, owner), player(name), currentRoomId(startRoom), score(0),
+          output(std::move(handler)) {}
+    
+    void countItems(std::map<std::string, int>& counts) const;
+};
+
+// ---------------------------------------------------------------------------
+// Scheduling
+
+void ActorWorker::run() {
+    for (;;) {
+        Actor* actor;
+        {
+            std::unique_lock<std::mutex> lock(readyMutex);
+            readyCondition.wait(lock, [this] { return stopping || !readyQueue.empty(); });
+            if (readyQueue.empty()) {
+                return;
+            }
+            actor = readyQueue.front();
+            readyQueue.pop_front();
+        }
+        if (actor->drain()) {
+            schedule(actor);
+        }
+    }
+}
+
+void ActorWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        stopping = true;
+    }
+    readyCondition.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void ActorWorker::schedule(Actor* actor) {
+    {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        readyQueue.push_back(actor);
+    }
+    readyCondition.notify_one();
+}
+
+void Actor::post(ActorMessage message) {
+    worker.sent.fetch_add(1, std::memory_order_relaxed);
+    bool wasScheduled;
+    {
+        std::lock_guard<std::mutex> lock(mailboxMutex);
+        mailbox.push_back(std::move(message));
+        wasScheduled = scheduled;
+        scheduled = true;
+    }
+    if (!wasScheduled) {
+        worker.schedule(this);
+    }
+}
+
+bool Actor::drain() {
+    std::deque<ActorMessage> batch;
+    {
+        std::lock_guard<std::mutex> lock(mailboxMutex);
+        batch.swap(mailbox);
+    }
+    for (ActorMessage& message : batch) {
+        receive(message);
+        worker.processed.fetch_add(1, std::memory_order_release);
+    }
+    
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    if (mailbox.empty()) {
+        scheduled = false;
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Room actor
+
+void RoomActor::receive(ActorMessage& message) {
+    switch (message.kind) {
+        case ActorMessage::Kind::TAKE:
+            handleTake(message);
+            break;
+        case ActorMessage::Kind::DEPOSIT:
+            room->addItem(std::move(message.item));
+            break;
+        case ActorMessage::Kind::MOVE:
+            handleMove(message);
+            break;
+        case ActorMessage::Kind::ENTER:
+            handleEnter(message);
+            break;
+        case ActorMessage::Kind::LEAVE:
+            occupants.erase(message.player);
+            break;
+        case ActorMessage::Kind::LOOK: {
+            ActorMessage text(ActorMessage::Kind::TEXT, nullptr);
+            text.text = describe();
+            message.player->post(std::move(text));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void RoomActor::handleTake(ActorMessage& message) {
+    Item* item = occupants.count(message.player) ? room->findItem(message.text) : nullptr;
+    if (!item || !item->getCanTake()) {
+        ActorMessage text(ActorMessage::Kind::TEXT, nullptr);
+        text.text = item ? "You can't take that." : "There's no " + message.text + " here.";
+        message.player->post(std::move(text));
+        return;
+    }
+    
+    ActorMessage granted(ActorMessage::Kind::ITEM_GRANTED, nullptr);
+    granted.roomId = room->getId();
+    granted.item = room->removeItem(message.text);
+    message.player->post(std::move(granted));
+}
+
+void RoomActor::handleMove(ActorMessage& message) {
+    ActorMessage reply(ActorMessage::Kind::TEXT, nullptr);
+    int nextRoomId = room->getExit(message.text);
+    RoomActor* next = nextRoomId == -1 ? nullptr : world.findRoomActor(nextRoomId);
+    if (nextRoomId == -1) {
+        reply.text = "You can't go that way.";
+    } else if (!next) {
+        reply.text = "That path leads nowhere.";
+    } else {
+        ActorMessage enter(ActorMessage::Kind::ENTER, message.player);
+        enter.text = message.text;
+        enter.keys = std::move(message.keys);
+        next->post(std::move(enter));
+        return;
+    }
+    message.player->post(std::move(reply));
+}
+
+void RoomActor::handleEnter(ActorMessage& message) {
+    std::string prefix;
+    if (room->isLocked()) {
+        const std::string& keyName = room->getUnlockKey();
+        bool hasKey = false;
+        for (const std::string& key : message.keys) {
+            hasKey = hasKey || key == keyName;
+        }
+        if (!keyName.empty() && !hasKey) {
+            ActorMessage denied(ActorMessage::Kind::TEXT, nullptr);
+            denied.text = "The way is locked. You need a " + keyName + " to proceed.";
+            message.player->post(std::move(denied));
+            return;
+        }
+        room->setLocked(false);
+        prefix = "You use the " + keyName + " to unlock the way.\n";
+    }
+    
+    occupants.insert(message.player);
+    ActorMessage arrived(ActorMessage::Kind::ARRIVED, nullptr);
+    arrived.roomId = room->getId();
+    arrived.text = prefix + (message.text.empty() ? "" : "You move " + message.text + ".\n\n") + describe();
+    room->setVisited(true);
+    message.player->post(std::move(arrived));
+}
+
+std::string RoomActor::describe() const {
+    std::ostringstream oss;
+    oss << "=== " << room->getName() << " ===\n" << room->getDescription() << "\n";
+    if (!room->getItems().empty()) {
+        oss << "\nYou can see:\n";
+        for (const auto& item : room->getItems()) {
+            oss << "  " << item->getName() << "\n";
+        }
+    }
+    std::vector<std::string> exits = room->getAvailableExits();
+    oss << "\nExits: ";
+    for (size_t i = 0; i < exits.size(); ++i) {
+        oss << (i ? ", " : "") << exits[i];
+    }
+    oss << "\n";
+    return oss.str();
+}
+
+void RoomActor::countItems(std::map<std::string, int>& counts) const {
+    for (const auto& item : room->getItems()) {
+        ++counts[item->getName()];
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Player actor
+
+void PlayerActor::receive(ActorMessage& message) {
+    switch (message.kind) {
+        case ActorMessage::Kind::COMMAND:
+            handleCommand(message.text);
+            break;
+        case ActorMessage::Kind::ITEM_GRANTED: {
+            std::string itemName = message.item->getName();
+            if (player.getInventorySize() < player.getMaxInventorySize()) {
+                player.addItem(std::move(message.item));
+                score += 10;
+                reply("You take the " + itemName + ".");
+            } else {
+                // Inventory full: the item goes straight back where it came from
+                ActorMessage back(ActorMessage::Kind::DEPOSIT, this);
+                back.item = std::move(message.item);
+                world.findRoomActor(message.roomId)->post(std::move(back));
+                reply("Your inventory is full!");
+            }
+            break;
+        }
+        case ActorMessage::Kind::ARRIVED: {
+            if (message.roomId != currentRoomId) {
+                world.findRoomActor(currentRoomId)->post(ActorMessage(ActorMessage::Kind::LEAVE, this));
+                currentRoomId = message.roomId;
+            }
+            reply(message.text);
+            break;
+        }
+        case ActorMessage::Kind::TEXT:
+            reply(message.text);
+            break;
+        default:
+            break;
+    }
+}
+
+void PlayerActor::handleCommand(const std::string& command) {
+    std::istringstream iss(command);
+    std::string action, target, word;
+    iss >> action;
+    while (iss >> word) {
+        target += (target.empty() ? "" : " ") + word;
+    }
+    
+    static const std::map<std::string, std::string> shortcuts = {
+        {"n", "north"}, {"s", "south"}, {"e", "east"}, {"w", "west"}, {"u", "up"}, {"d", "down"},
+        {"north", "north"}, {"south", "south"}, {"east", "east"}, {"west", "west"},
+        {"up", "up"}, {"down", "down"}
+    };
+    RoomActor* room = world.findRoomActor(currentRoomId);
+    
+    auto shortcut = shortcuts.find(action);
+    if (shortcut != shortcuts.end() || ((action == "go" || action == "move") && !target.empty())) {
+        ActorMessage move(ActorMessage::Kind::MOVE, this);
+        move.text = shortcut != shortcuts.end() ? shortcut->second : target;
+        for (const std::string& keyName : player.getItemNames()) {
+            Item* item = player.findItem(keyName);
+            if (item && item->getType() == ItemType::KEY) {
+                move.keys.push_back(keyName);
+            }
+        }
+        room->post(std::move(move));
+    } else if (action == "take" || action == "get") {
+        ActorMessage take(ActorMessage::Kind::TAKE, this);
+        take.text = target;
+        room->post(std::move(take));
+    } else if (action == "drop") {
+        std::unique_ptr<Item> item = player.removeItem(target);
+        if (!item) {
+            reply("You don't have a " + target + ".");
+            return;
+        }
+        ActorMessage deposit(ActorMessage::Kind::DEPOSIT, this);
+        deposit.item = std::move(item);
+        room->post(std::move(deposit));
+        reply("You drop the " + target + ".");
+    } else if (action == "look" || action == "l") {
+        room->post(ActorMessage(ActorMessage::Kind::LOOK, this));
+    } else if (action == "inventory" || action == "i") {
+        std::string text = "Carrying:";
+        for (const std::string& itemName : player.getItemNames()) {
+            text += " " + itemName;
+        }
+        reply(text + " (score " + std::to_string(score) + ")");
+    } else {
+        reply("I don't understand that command.");
+    }
+}
+
+void PlayerActor::countItems(std::map<std::string, int>& counts) const {
+    for (const std::string& itemName : player.getItemNames()) {
+        ++counts[itemName];
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Shared world
+
+SharedWorld::SharedWorld(WorldFile& world, int workerCount)
+    : startRoomId(world.getStartRoomId()), nextPlayerId(1) {
+    if (workerCount <= 0) {
+        workerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        workers.push_back(std::make_unique<ActorWorker>());
+    }
+    
+    for (int regionId = 0; regionId < world.getRegionCount(); ++regionId) {
+        for (int roomId : world.getRegionRooms(regionId)) {
+            roomActors[roomId] = std::make_unique<RoomActor>(*this, workerFor(roomId), world.loadRoom(roomId));
+        }
+    }
+    startWorkers(workerCount);
+}
+
+SharedWorld::~SharedWorld() {
+    for (auto& worker : workers) {
+        worker->stop();
+    }
+}
+
+void SharedWorld::startWorkers(int workerCount) {
+    for (int i = 0; i < workerCount; ++i) {
+        workers[i]->start();
+    }
+}
+
+ActorWorker& SharedWorld::workerFor(int actorId) const {
+    size_t slot = std::hash<int>()(actorId) % workers.size();
+    return *workers[slot];
+}
+
+RoomActor* SharedWorld::findRoomActor(int roomId) const {
+    auto it = roomActors.find(roomId);
+    return (it != roomActors.end()) ? it->second.get() : nullptr;
+}
+
+PlayerActor* SharedWorld::addPlayer(const std::string& name, OutputHandler output) {
+    PlayerActor* actor;
+    {
+        std::lock_guard<std::mutex> lock(playersMutex);
+        int playerId = nextPlayerId++;
+        players.push_back(std::make_unique<PlayerActor>(*this, workerFor(-playerId), name,
+                                                        startRoomId, std::move(output)));
+        actor = players.back().get();
+    }
+    findRoomActor(startRoomId)->post(ActorMessage(ActorMessage::Kind::ENTER, actor));
+    return actor;
+}
+
+void SharedWorld::submit(PlayerActor* player, const std::string& command) {
+    ActorMessage message(ActorMessage::Kind::COMMAND, player);
+    message.text = command;
+    player->post(std::move(message));
+}
+
+void SharedWorld::waitForQuiescence() const {
+    // Read processed before sent: equal totals mean every message sent so far
+    // has been handled, and handling is the only way new messages appear.
+    for (;;) {
+        size_t processed = 0, sent = 0;
+        for (const auto& worker : workers) {
+            processed += worker->processed.load(std::memory_order_acquire);
+        }
+        for (const auto& worker : workers) {
+            sent += worker->sent.load(std::memory_order_acquire);
+        }
+        if (processed == sent) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+std::map<std::string, int> SharedWorld::countItems() const {
+    std::map<std::string, int> counts;
+    for (const auto& entry : roomActors) {
+        entry.second->countItems(counts);
+    }
+    for (const auto& player : players) {
+        player->countItems(counts);
+    }
+    return counts;
+}
@@ -0,0 +1,356 @@
+#include "Simulation.h"
+#include "Serialization.h"
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // Reorders one column by a permutation
+    void permute(std::vector<int32_t>& column, const std::vector<uint32_t>& order) {
+        std::vector<int32_t> sorted(column.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            sorted[i] = column[order[i]];
+        }
+        column.swap(sorted);
+    }
+    
+    // Advances a periodic timer by elapsed ticks and returns how often it fired.
+    // Timers live in (0, period] between calls.
+    inline int32_t fireTimer(int32_t& timer, int32_t period, int32_t elapsed) {
+        int32_t remaining = timer - elapsed;
+        int32_t fired = remaining <= 0 ? 1 + (-remaining) / period : 0;
+        timer = remaining + fired * period;
+        return fired;
+    }
+    
+    bool nameMatches(const std::string& name, const std::string& target) {
+        if (name == target) return true;
+        std::istringstream iss(name);
+        std::string word;
+        while (iss >> word) {
+            if (word == target) return true;
+        }
+        return false;
+    }
+}
+
+WorldSimulation::WorldSimulation() : currentTick(0), indexDirty(false) {
+}
+
+int WorldSimulation::addSpecies(const CreatureSpecies& creature) {
+    species.push_back(creature);
+    return static_cast<int>(species.size()) - 1;
+}
+
+int WorldSimulation::addHazardKind(const HazardKind& hazard) {
+    hazardKinds.push_back(hazard);
+    return static_cast<int>(hazardKinds.size()) - 1;
+}
+
+void WorldSimulation::spawnCreature(int speciesId, int roomId) {
+    const CreatureSpecies& kind = species.at(speciesId);
+    creatureRoom.push_back(roomId);
+    creatureSpecies.push_back(speciesId);
+    creatureHealth.push_back(kind.maxHealth);
+    creatureMaxHealth.push_back(kind.maxHealth);
+    creatureAggression.push_back(kind.aggression);
+    creatureDamage.push_back(kind.damage);
+    creaturePeriod.push_back(std::max(1, kind.attackPeriod));
+    creatureTimer.push_back(std::max(1, kind.attackPeriod));
+    indexDirty = true;
+}
+
+void WorldSimulation::spawnHazard(int kindId, int roomId) {
+    const HazardKind& kind = hazardKinds.at(kindId);
+    hazardRoom.push_back(roomId);
+    hazardKind.push_back(kindId);
+    hazardDamage.push_back(kind.damage);
+    hazardPeriod.push_back(std::max(1, kind.period));
+    hazardTimer.push_back(std::max(1, kind.period));
+    indexDirty = true;
+}
+
+void WorldSimulation::rebuildIndex() {
+    // Sort both entity kinds by room so each room is one contiguous range
+    std::vector<uint32_t> order(creatureRoom.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [this](uint32_t a, uint32_t b) { return creatureRoom[a] < creatureRoom[b]; });
+    for (auto* column : {&creatureRoom, &creatureSpecies, &creatureHealth, &creatureMaxHealth,
+                         &creatureAggression, &creatureDamage, &creaturePeriod, &creatureTimer}) {
+        permute(*column, order);
+    }
+    
+    order.resize(hazardRoom.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [this](uint32_t a, uint32_t b) { return hazardRoom[a] < hazardRoom[b]; });
+    for (auto* column : {&hazardRoom, &hazardKind, &hazardDamage, &hazardPeriod, &hazardTimer}) {
+        permute(*column, order);
+    }
+    
+    for (auto& entry : rooms) {
+        entry.second.creatureBegin = entry.second.creatureEnd = 0;
+        entry.second.hazardBegin = entry.second.hazardEnd = 0;
+    }
+    for (uint32_t i = 0; i < creatureRoom.size(); ++i) {
+        RoomEntities& room = rooms[creatureRoom[i]];
+        if (room.creatureEnd == 0) room.creatureBegin = i;
+        room.creatureEnd = i + 1;
+    }
+    for (uint32_t i = 0; i < hazardRoom.size(); ++i) {
+        RoomEntities& room = rooms[hazardRoom[i]];
+        if (room.hazardEnd == 0) room.hazardBegin = i;
+        room.hazardEnd = i + 1;
+    }
+    indexDirty = false;
+}
+
+WorldSimulation::RoomEntities* WorldSimulation::roomEntities(int roomId) {
+    if (indexDirty) {
+        rebuildIndex();
+    }
+    auto it = rooms.find(roomId);
+    return (it != rooms.end()) ? &it->second : nullptr;
+}
+
+void WorldSimulation::simulateRoom(RoomEntities& room, TickReport* report) {
+    uint64_t elapsedTicks = currentTick - room.lastTick;
+    if (elapsedTicks == 0) {
+        return;
+    }
+    const int32_t elapsed = static_cast<int32_t>(std::min<uint64_t>(elapsedTicks, 1u << 30));
+    
+    // Regeneration counts whole REGEN_PERIOD boundaries crossed, so one lazy
+    // catch-up gives the same result as many small per-tick steps.
+    const int32_t regen = static_cast<int32_t>(currentTick / REGEN_PERIOD - room.lastTick / REGEN_PERIOD);
+    room.lastTick = currentTick;
+    
+    const uint32_t creatureCount = room.creatureEnd - room.creatureBegin;
+    const uint32_t hazardCount = room.hazardEnd - room.hazardBegin;
+    if (firedScratch.size() < creatureCount + hazardCount) {
+        firedScratch.resize(creatureCount + hazardCount);
+    }
+    int32_t* fired = firedScratch.data();
+    int32_t* health = creatureHealth.data() + room.creatureBegin;
+    int32_t* timer = creatureTimer.data() + room.creatureBegin;
+    const int32_t* maxHealth = creatureMaxHealth.data() + room.creatureBegin;
+    const int32_t* aggression = creatureAggression.data() + room.creatureBegin;
+    const int32_t* damage = creatureDamage.data() + room.creatureBegin;
+    const int32_t* period = creaturePeriod.data() + room.creatureBegin;
+    
+    int32_t hits = 0;
+    for (uint32_t i = 0; i < creatureCount; ++i) {
+        int32_t alive = health[i] > 0;
+        int32_t hostile = alive & (aggression[i] >= HOSTILE_AGGRESSION);
+        fired[i] = hostile * fireTimer(timer[i], period[i], elapsed);
+        hits += fired[i] * damage[i];
+        health[i] = std::min(maxHealth[i], health[i] + alive * regen);
+    }
+    
+    int32_t* hazardFired = fired + creatureCount;
+    for (uint32_t i = 0; i < hazardCount; ++i) {
+        uint32_t h = room.hazardBegin + i;
+        hazardFired[i] = fireTimer(hazardTimer[h], hazardPeriod[h], elapsed);
+        hits += hazardFired[i] * hazardDamage[h];
+    }
+    
+    // Without a player nobody is hurt; messages are only built when something struck
+    if (!report || hits == 0) {
+        return;
+    }
+    report->damageToPlayer += hits;
+    for (uint32_t i = 0; i < creatureCount; ++i) {
+        if (fired[i] > 0) {
+            report->messages.push_back("The " + species[creatureSpecies[room.creatureBegin + i]].name +
+                                       " attacks you!");
+        }
+    }
+    for (uint32_t i = 0; i < hazardCount; ++i) {
+        if (hazardFired[i] > 0) {
+            report->messages.push_back(hazardKinds[hazardKind[room.hazardBegin + i]].message);
+        }
+    }
+}
+
+void WorldSimulation::setRoomOccupied(int roomId, bool occupied) {
+    if (indexDirty) {
+        rebuildIndex();
+    }
+    RoomEntities& room = rooms[roomId];
+    simulateRoom(room, nullptr);
+    if (occupied && !room.occupied) {
+        occupiedRooms.push_back(roomId);
+    } else if (!occupied && room.occupied) {
+        occupiedRooms.erase(std::remove(occupiedRooms.begin(), occupiedRooms.end(), roomId), occupiedRooms.end());
+    }
+    room.occupied = occupied;
+}
+
+TickReport WorldSimulation::advance(int ticks) {
+    TickReport report;
+    if (indexDirty) {
+        rebuildIndex();
+    }
+    currentTick += static_cast<uint64_t>(std::max(0, ticks));
+    for (int roomId : occupiedRooms) {
+        simulateRoom(rooms[roomId], &report);
+    }
+    return report;
+}
+
+void WorldSimulation::settleAll() {
+    if (indexDirty) {
+        rebuildIndex();
+    }
+    for (auto& entry : rooms) {
+        if (!entry.second.occupied) {
+            simulateRoom(entry.second, nullptr);
+        }
+    }
+}
+
+int WorldSimulation::findCreature(int roomId, const std::string& name) {
+    RoomEntities* room = roomEntities(roomId);
+    if (!room) {
+        return -1;
+    }
+    for (uint32_t i = room->creatureBegin; i < room->creatureEnd; ++i) {
+        if (creatureHealth[i] > 0 && nameMatches(species[creatureSpecies[i]].name, name)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int WorldSimulation::damageCreature(int creatureIndex, int amount) {
+    int32_t& health = creatureHealth.at(creatureIndex);
+    health = std::max(0, health - std::max(0, amount));
+    creatureAggression[creatureIndex] = 255; // provoked creatures fight back
+    return health;
+}
+
+std::string WorldSimulation::getCreatureName(int creatureIndex) const {
+    return species.at(creatureSpecies.at(creatureIndex)).name;
+}
+
+std::vector<int> WorldSimulation::livingCreatures(int roomId) {
+    std::vector<int> living;
+    RoomEntities* room = roomEntities(roomId);
+    if (room) {
+        for (uint32_t i = room->creatureBegin; i < room->creatureEnd; ++i) {
+            if (creatureHealth[i] > 0) {
+                living.push_back(static_cast<int>(i));
+            }
+        }
+    }
+    return living;
+}
+
+std::vector<std::string> WorldSimulation::describeRoom(int roomId) {
+    std::vector<std::string> lines;
+    RoomEntities* room = roomEntities(roomId);
+    if (!room) {
+        return lines;
+    }
+    for (uint32_t i = room->creatureBegin; i < room->creatureEnd; ++i) {
+        if (creatureHealth[i] > 0) {
+            const std::string& name = species[creatureSpecies[i]].name;
+            lines.push_back(creatureAggression[i] >= HOSTILE_AGGRESSION
+                ? "A " + name + " is here, watching you with hostile eyes."
+                : "A " + name + " is here.");
+        }
+    }
+    for (uint32_t i = room->hazardBegin; i < room->hazardEnd; ++i) {
+        lines.push_back("Danger: " + hazardKinds[hazardKind[i]].name + ".");
+    }
+    return lines;
+}
+
+void WorldSimulation::saveState(ByteWriter& writer) {
+    if (indexDirty) {
+        rebuildIndex();
+    }
+    writer.writeVarint(currentTick);
+    writer.writeVarint(creatureRoom.size());
+    for (size_t i = 0; i < creatureRoom.size(); ++i) {
+        writer.writeInt(creatureHealth[i]);
+        writer.writeInt(creatureAggression[i]);
+        writer.writeInt(creatureTimer[i]);
+    }
+    writer.writeVarint(hazardRoom.size());
+    for (size_t i = 0; i < hazardRoom.size(); ++i) {
+        writer.writeInt(hazardTimer[i]);
+    }
+    writer.writeVarint(rooms.size());
+    for (const auto& entry : rooms) {
+        writer.writeInt(entry.first);
+        writer.writeVarint(entry.second.lastTick);
+        writer.writeByte(entry.second.occupied ? 1 : 0);
+    }
+}
+
+void WorldSimulation::restoreState(ByteReader& reader) {
+    if (indexDirty) {
+        rebuildIndex();
+    }
+    currentTick = reader.readVarint();
+    if (reader.readVarint() != creatureRoom.size()) {
+        throw std::runtime_error("Saved simulation does not match this world's creatures");
+    }
+    for (size_t i = 0; i < creatureRoom.size(); ++i) {
+        creatureHealth[i] = static_cast<int32_t>(reader.readInt());
+        creatureAggression[i] = static_cast<int32_t>(reader.readInt());
+        creatureTimer[i] = static_cast<int32_t>(reader.readInt());
+    }
+    if (reader.readVarint() != hazardRoom.size()) {
+        throw std::runtime_error("Saved simulation does not match this world's hazards");
+    }
+    for (size_t i = 0; i < hazardRoom.size(); ++i) {
+        hazardTimer[i] = static_cast<int32_t>(reader.readInt());
+    }
+    
+    for (auto& entry : rooms) {
+        entry.second.occupied = false;
+    }
+    occupiedRooms.clear();
+    uint64_t roomCount = reader.readVarint();
+    for (uint64_t i = 0; i < roomCount; ++i) {
+        int roomId = static_cast<int>(reader.readInt());
+        RoomEntities& room = rooms[roomId];
+        room.lastTick = reader.readVarint();
+        room.occupied = reader.readByte() != 0;
+        if (room.occupied) {
+            occupiedRooms.push_back(roomId);
+        }
+    }
+}
+
+size_t WorldSimulation::memoryFootprint() const {
+    size_t total = sizeof(*this);
+    for (const CreatureSpecies& creature : species) {
+        total += sizeof(creature) + creature.name.capacity();
+    }
+    for (const HazardKind& hazard : hazardKinds) {
+        total += sizeof(hazard) + hazard.name.capacity() + hazard.message.capacity();
+    }
+    total += (species.capacity() - species.size()) * sizeof(CreatureSpecies);
+    total += (hazardKinds.capacity() - hazardKinds.size()) * sizeof(HazardKind);
+    
+    // Columns
+    const std::vector<int32_t>* columns[] = {
+        &creatureRoom, &creatureSpecies, &creatureHealth, &creatureMaxHealth, &creatureAggression,
+        &creatureDamage, &creaturePeriod, &creatureTimer, &hazardRoom, &hazardKind, &hazardDamage,
+        &hazardPeriod, &hazardTimer, &firedScratch
+    };
+    for (const std::vector<int32_t>* column : columns) {
+        total += column->capacity() * sizeof(int32_t);
+    }
+    
+    // Hash nodes hold a next pointer and the value; buckets are one pointer each
+    total += rooms.size() * (sizeof(void*) + sizeof(std::pair<const int, RoomEntities>)) +
+             rooms.bucket_count() * sizeof(void*);
+    total += occupiedRooms.capacity() * sizeof(int);
+    return total;
+}
@@ -0,0 +1,72 @@
+#include "Spectator.h"
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace {
+    const size_t MAX_IOVECS = 64; // chunks gathered into one send
+}
+
+SpectatorQueue::SpectatorQueue(int socketFd)
+    : fd(socketFd), frontSent(0), queuedBytes(0), skipped(0), progressed(true) {}
+
+bool SpectatorQueue::push(const OutputChunk& chunk) {
+    if (queuedBytes + chunk->size() > MAX_BACKLOG && !chunks.empty()) {
+        if (!progressed) {
+            return false;
+        }
+        // Keep the response being written, so its lines stay whole, and drop the rest
+        size_t keep = frontSent > 0 ? 1 : 0;
+        uint64_t dropped = chunks.size() - keep;
+        chunks.erase(chunks.begin() + static_cast<std::ptrdiff_t>(keep), chunks.end());
+        queuedBytes = keep ? chunks.front()->size() - frontSent : 0;
+        if (dropped > 0) {
+            skipped += dropped;
+            auto note = std::make_shared<const std::string>(
+                "[" + std::to_string(dropped) + " responses skipped]\n");
+            chunks.push_back(note);
+            queuedBytes += note->size();
+        }
+        progressed = false;
+    }
+    chunks.push_back(chunk);
+    queuedBytes += chunk->size();
+    return true;
+}
+
+SpectatorQueue::Send SpectatorQueue::send() {
+    while (!chunks.empty()) {
+        iovec parts[MAX_IOVECS];
+        size_t count = 0;
+        for (auto it = chunks.begin(); it != chunks.end() && count < MAX_IOVECS; ++it, ++count) {
+            size_t offset = count == 0 ? frontSent : 0;
+            parts[count].iov_base = const_cast<char*>((*it)->data() + offset);
+            parts[count].iov_len = (*it)->size() - offset;
+        }
+        msghdr message{};
+        message.msg_iov = parts;
+        message.msg_iovlen = count;
+        ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ? Send::BLOCKED : Send::FAILED;
+        }
+        
+        size_t written = static_cast<size_t>(sent);
+        queuedBytes -= written;
+        progressed = progressed || written > 0;
+        while (written > 0) {
+            size_t rest = chunks.front()->size() - frontSent;
+            if (written < rest) {
+                frontSent += written;
+                break;
+            }
+            written -= rest;
+            chunks.pop_front();
+            frontSent = 0;
+        }
+    }
+    return Send::DONE;
+}
@@ -0,0 +1,178 @@
+#include "Spelling.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+namespace {
+    constexpr size_t MAX_DELETES = 1 + SpellingIndex::PREFIX_LENGTH +
+                                   SpellingIndex::PREFIX_LENGTH * (SpellingIndex::PREFIX_LENGTH - 1) / 2;
+    
+    // Hashes of the word's prefix and of every string left by deleting one
+    // or two of its characters, without duplicates ("book" -> "bok" once).
+    // Only a prefix is used so that long words cost no more than short ones;
+    // the distance check on the whole word weeds out the extra candidates.
+    size_t deleteHashes(std::string_view word, std::array<uint64_t, MAX_DELETES>& hashes) {
+        size_t n = std::min(word.size(), SpellingIndex::PREFIX_LENGTH);
+        auto hashSkipping = [&](size_t first, size_t second) {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t k = 0; k < n; ++k) {
+                if (k != first && k != second) {
+                    hash = (hash ^ static_cast<unsigned char>(word[k])) * 1099511628211ull;
+                }
+            }
+            return hash | 1; // never 0, which marks an empty bucket
+        };
+        
+        size_t count = 0;
+        hashes[count++] = hashSkipping(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            hashes[count++] = hashSkipping(i, n);
+            for (size_t j = i + 1; j < n; ++j) {
+                hashes[count++] = hashSkipping(i, j);
+            }
+        }
+        std::sort(hashes.begin(), hashes.begin() + count);
+        return static_cast<size_t>(std::unique(hashes.begin(), hashes.begin() + count) - hashes.begin());
+    }
+    
+    size_t homeSlot(uint64_t hash, size_t mask) {
+        return static_cast<size_t>(hash ^ (hash >> 29)) & mask; // the low bit of the hash is always set
+    }
+    
+    // Optimal string alignment distance, or limit + 1 once it must exceed
+    // limit. Only the diagonal band |i - j| <= limit can hold smaller values.
+    int editDistance(std::string_view a, std::string_view b, int limit) {
+        int n = static_cast<int>(a.size());
+        int m = static_cast<int>(b.size());
+        if (std::abs(n - m) > limit) return limit + 1;
+        
+        const int beyond = limit + 1;
+        int rows[3][SpellingIndex::MAX_WORD_LENGTH + 1];
+        int* previous2 = rows[0];
+        int* previous = rows[1];
+        int* current = rows[2];
+        for (int j = 0; j <= m; ++j) previous[j] = std::min(j, beyond);
+        
+        for (int i = 1; i <= n; ++i) {
+            int first = std::max(1, i - limit);
+            int last = std::min(m, i + limit);
+            current[first - 1] = first == 1 ? std::min(i, beyond) : beyond;
+            if (last < m) current[last + 1] = beyond;
+            
+            int rowMinimum = beyond;
+            for (int j = first; j <= last; ++j) {
+                int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+                int best = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+                if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+                    best = std::min(best, previous2[j - 2] + 1);
+                }
+                current[j] = std::min(best, beyond);
+                rowMinimum = std::min(rowMinimum, current[j]);
+            }
+            if (rowMinimum > limit) return beyond;
+            std::swap(previous2, previous);
+            std::swap(previous, current);
+        }
+        return previous[m];
+    }
+}
+
+void SpellingIndex::add(std::string_view word) {
+    if (word.empty() || ids.count(word)) return;
+    
+    uint32_t id = static_cast<uint32_t>(words.size());
+    words.emplace_back(word);
+    lengths.push_back(static_cast<uint8_t>(std::min<size_t>(word.size(), 255)));
+    ids.emplace(words.back(), id);
+    if (word.size() > MAX_WORD_LENGTH) return;
+    
+    std::array<uint64_t, MAX_DELETES> hashes;
+    size_t count = deleteHashes(word, hashes);
+    for (size_t i = 0; i < count; ++i) {
+        insert(hashes[i], id);
+    }
+}
+
+void SpellingIndex::insert(uint64_t hash, uint32_t id) {
+    if ((usedBuckets + 1) * 2 > buckets.size()) {
+        grow();
+    }
+    size_t mask = buckets.size() - 1;
+    for (size_t slot = homeSlot(hash, mask);; slot = (slot + 1) & mask) {
+        Bucket& bucket = buckets[slot];
+        if (bucket.hash == 0) {
+            bucket = Bucket{hash, 1, id};
+            ++usedBuckets;
+            return;
+        }
+        if (bucket.hash != hash) continue;
+        
+        if (bucket.count == 1) {
+            overflow.push_back({bucket.value});
+            bucket.value = static_cast<uint32_t>(overflow.size() - 1);
+        }
+        overflow[bucket.value].push_back(id);
+        ++bucket.count;
+        return;
+    }
+}
+
+void SpellingIndex::grow() {
+    std::vector<Bucket> old = std::move(buckets);
+    buckets.assign(std::max<size_t>(old.size() * 2, 1024), Bucket{0, 0, 0});
+    size_t mask = buckets.size() - 1;
+    for (const Bucket& bucket : old) {
+        if (bucket.hash == 0) continue;
+        size_t slot = homeSlot(bucket.hash, mask);
+        while (buckets[slot].hash != 0) {
+            slot = (slot + 1) & mask;
+        }
+        buckets[slot] = bucket;
+    }
+}
+
+std::vector<SpellingIndex::Match> SpellingIndex::lookup(std::string_view input, int maxDistance) const {
+    std::vector<Match> matches;
+    if (input.empty() || input.size() > MAX_WORD_LENGTH || buckets.empty()) return matches;
+    maxDistance = std::clamp(maxDistance, 0, MAX_DISTANCE);
+    
+    // Every word within the distance shares one of these deletes; hash
+    // collisions only add candidates that the distance check rejects
+    std::array<uint64_t, MAX_DELETES> hashes;
+    size_t hashCount = deleteHashes(input, hashes);
+    std::vector<uint32_t> candidates;
+    int inputLength = static_cast<int>(input.size());
+    auto consider = [&](uint32_t id) {
+        if (std::abs(lengths[id] - inputLength) <= maxDistance) {
+            candidates.push_back(id);
+        }
+    };
+    
+    size_t mask = buckets.size() - 1;
+    for (size_t i = 0; i < hashCount; ++i) {
+        for (size_t slot = homeSlot(hashes[i], mask); buckets[slot].hash != 0; slot = (slot + 1) & mask) {
+            const Bucket& bucket = buckets[slot];
+            if (bucket.hash != hashes[i]) continue;
+            if (bucket.count == 1) {
+                consider(bucket.value);
+            } else {
+                for (uint32_t id : overflow[bucket.value]) {
+                    consider(id);
+                }
+            }
+            break;
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    
+    for (uint32_t id : candidates) {
+        int distance = editDistance(input, words[id], maxDistance);
+        if (distance <= maxDistance) {
+            matches.push_back(Match{words[id], distance});
+        }
+    }
+    std::stable_sort(matches.begin(), matches.end(),
+        [](const Match& a, const Match& b) { return a.distance < b.distance; });
+    return matches;
+}
@@ -0,0 +1,160 @@
+#include "StateDelta.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    // Whether from[i] is one more copy of its name than other holds; the lists are a handful of names
+    bool isExtra(const std::vector<std::string>& from, size_t i, const std::vector<std::string>& other) {
+        auto upTo = static_cast<size_t>(std::count(from.begin(), from.begin() + static_cast<std::ptrdiff_t>(i) + 1, from[i]));
+        return upTo > static_cast<size_t>(std::count(other.begin(), other.end(), from[i]));
+    }
+    
+    // The names in from that other lacks, if there are any
+    void writeExtras(JsonWriter& writer, std::string_view name,
+                     const std::vector<std::string>& from, const std::vector<std::string>& other) {
+        bool open = false;
+        for (size_t i = 0; i < from.size(); ++i) {
+            if (!isExtra(from, i, other)) {
+                continue;
+            }
+            if (!open) {
+                writer.beginArray(name);
+                open = true;
+            }
+            writer.element(from[i]);
+        }
+        if (open) {
+            writer.endArray();
+        }
+    }
+    
+    void writeList(JsonWriter& writer, std::string_view name, const std::vector<std::string>& list) {
+        writer.beginArray(name);
+        for (const std::string& element : list) {
+            writer.element(element);
+        }
+        writer.endArray();
+    }
+    
+    // Copies names into list, keeping the strings it already holds for reuse
+    template <typename Names>
+    void assignNames(std::vector<std::string>& list, const Names& names) {
+        list.resize(names.size());
+        size_t i = 0;
+        for (const auto& name : names) {
+            list[i++] = name;
+        }
+    }
+    
+    size_t listFootprint(const std::vector<std::string>& list) {
+        size_t bytes = list.capacity() * sizeof(std::string);
+        for (const std::string& element : list) {
+            bytes += element.capacity();
+        }
+        return bytes;
+    }
+}
+
+void StateSnapshot::capture(const Game& game) {
+    const Player* player = game.getPlayer();
+    room = game.getCurrentRoomId();
+    health = player->getHealth();
+    score = game.getScore();
+    running = game.isRunning();
+    
+    roomItems.clear();
+    exits.clear();
+    lockedExits.clear();
+    if (const Room* current = game.peekCurrentRoom()) {
+        roomItems.resize(current->getItems().size());
+        for (size_t i = 0; i < roomItems.size(); ++i) {
+            roomItems[i] = current->getItems()[i]->getName();
+        }
+        assignNames(exits, current->getAvailableExits());
+        for (const std::string& direction : exits) {
+            if (game.isRoomLocked(current->getExit(direction))) {
+                lockedExits.push_back(direction);
+            }
+        }
+    }
+    inventory.resize(player->getInventory().size());
+    for (size_t i = 0; i < inventory.size(); ++i) {
+        inventory[i] = player->getInventory()[i]->getName();
+    }
+}
+
+size_t StateSnapshot::memoryFootprint() const {
+    return listFootprint(roomItems) + listFootprint(inventory) + listFootprint(exits) + listFootprint(lockedExits);
+}
+
+StateHistory::StateHistory() : latest(0), lastKeyframe(0) {}
+
+void StateHistory::writeUpdate(JsonWriter& writer, const Game& game, uint64_t acked) {
+    uint64_t version = latest + 1;
+    if (latest == 0) {
+        version = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()) + 1;
+    }
+    // The base must still be held, and not in the slot the new version takes
+    bool held = acked != 0 && acked <= latest && acked + KEPT > version &&
+                snapshots[acked % KEPT].version == acked;
+    bool keyframe = !held || version - lastKeyframe >= KEYFRAME_INTERVAL;
+    
+    StateSnapshot& current = snapshots[version % KEPT];
+    current.capture(game);
+    current.version = version;
+    latest = version;
+    writer.field("version", static_cast<long long>(version));
+    
+    if (keyframe) {
+        lastKeyframe = version;
+        writer.field("keyframe", true);
+        writer.field("room", current.room);
+        writer.field("health", current.health);
+        writer.field("score", current.score);
+        writer.field("running", current.running);
+        writeList(writer, "room_items", current.roomItems);
+        writeList(writer, "inventory", current.inventory);
+        writeList(writer, "exits", current.exits);
+        writeList(writer, "locked_exits", current.lockedExits);
+        return;
+    }
+    
+    const StateSnapshot& base = snapshots[acked % KEPT];
+    if (acked != version - 1) {
+        writer.field("base", static_cast<long long>(acked)); // implied when it is the previous version
+    }
+    if (current.room != base.room) {
+        writer.field("room", current.room);
+        writeList(writer, "room_items", current.roomItems);
+        writeList(writer, "exits", current.exits);
+        writeList(writer, "locked_exits", current.lockedExits);
+    } else {
+        writeExtras(writer, "room_items_added", current.roomItems, base.roomItems);
+        writeExtras(writer, "room_items_removed", base.roomItems, current.roomItems);
+        if (current.exits != base.exits) {
+            writeList(writer, "exits", current.exits);
+        }
+        writeExtras(writer, "exits_unlocked", base.lockedExits, current.lockedExits);
+        writeExtras(writer, "exits_locked", current.lockedExits, base.lockedExits);
+    }
+    if (current.health != base.health) {
+        writer.field("health", current.health);
+    }
+    if (current.score != base.score) {
+        writer.field("score", current.score);
+    }
+    if (current.running != base.running) {
+        writer.field("running", current.running);
+    }
+    writeExtras(writer, "inventory_added", current.inventory, base.inventory);
+    writeExtras(writer, "inventory_removed", base.inventory, current.inventory);
+}
+
+size_t StateHistory::memoryFootprint() const {
+    size_t bytes = sizeof(*this);
+    for (const StateSnapshot& snapshot : snapshots) {
+        bytes += snapshot.memoryFootprint();
+    }
+    return bytes;
+}
@@ -0,0 +1,140 @@
+#include "TextStore.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    const size_t MAX_PHRASE_WORDS = 6;
+    const size_t MIN_PHRASE_LENGTH = 8;
+    
+    uint64_t fnv1a(const char* data, size_t length) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+std::string TextStore::trainDictionary(const std::vector<std::string>& samples, size_t maxBytes) {
+    // Count every run of up to MAX_PHRASE_WORDS words, with its trailing space
+    std::unordered_map<std::string_view, size_t> counts;
+    for (const std::string& sample : samples) {
+        std::vector<size_t> wordStarts;
+        for (size_t i = 0; i < sample.size(); ++i) {
+            if (sample[i] != ' ' && (i == 0 || sample[i - 1] == ' ')) {
+                wordStarts.push_back(i);
+            }
+        }
+        wordStarts.push_back(sample.size());
+        for (size_t first = 0; first + 1 < wordStarts.size(); ++first) {
+            for (size_t words = 1; words <= MAX_PHRASE_WORDS && first + words < wordStarts.size(); ++words) {
+                size_t start = wordStarts[first];
+                size_t length = wordStarts[first + words] - start;
+                if (length >= MIN_PHRASE_LENGTH) {
+                    ++counts[std::string_view(sample).substr(start, length)];
+                }
+            }
+        }
+    }
+    
+    // A phrase is worth roughly its length for every repeat after the first
+    std::vector<std::pair<size_t, std::string_view>> ranked;
+    for (const auto& entry : counts) {
+        if (entry.second > 1) {
+            ranked.emplace_back((entry.second - 1) * entry.first.size(), entry.first);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    
+    std::string dictionary;
+    for (const auto& phrase : ranked) {
+        if (dictionary.size() + phrase.second.size() > maxBytes) continue;
+        if (dictionary.find(phrase.second) == std::string::npos) {
+            dictionary.append(phrase.second);
+        }
+    }
+    return dictionary;
+}
+
+TextStore::TextStore(std::string trainedDictionary, size_t cacheBytes)
+    : dictionary(std::move(trainedDictionary)), cacheCapacity(cacheBytes) {
+    stats.dictionaryBytes = dictionary.bytes().size();
+}
+
+uint32_t TextStore::add(std::string_view text) {
+    std::string compressed = dictionary.compress(text);
+    uint64_t hash = fnv1a(compressed.data(), compressed.size());
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    // The codec is deterministic, so equal texts compress to equal bytes
+    std::vector<uint32_t>& candidates = byHash[hash];
+    for (uint32_t id : candidates) {
+        const Entry& entry = entries[id];
+        if (entry.length == compressed.size() &&
+            std::memcmp(arena.data() + entry.offset, compressed.data(), compressed.size()) == 0) {
+            return id;
+        }
+    }
+    
+    uint32_t id = static_cast<uint32_t>(entries.size());
+    entries.push_back(Entry{static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(compressed.size()),
+                            static_cast<uint32_t>(text.size())});
+    arena.append(compressed);
+    candidates.push_back(id);
+    ++stats.texts;
+    stats.rawBytes += text.size();
+    stats.compressedBytes += compressed.size();
+    return id;
+}
+
+std::shared_ptr<const std::string> TextStore::get(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.views;
+    auto cached = cache.find(id);
+    if (cached != cache.end()) {
+        ++stats.cacheHits;
+        lru.splice(lru.begin(), lru, cached->second.lruPosition);
+        return cached->second.text;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    const Entry& entry = entries.at(id);
+    auto text = std::make_shared<const std::string>(
+        dictionary.decompress(std::string_view(arena).substr(entry.offset, entry.length)));
+    stats.decompressNanos += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    
+    lru.push_front(id);
+    cache[id] = CachedText{text, lru.begin()};
+    stats.cachedBytes += text->size();
+    while (stats.cachedBytes > cacheCapacity && lru.size() > 1) {
+        auto evicted = cache.find(lru.back());
+        stats.cachedBytes -= evicted->second.text->size();
+        cache.erase(evicted);
+        lru.pop_back();
+    }
+    return text;
+}
+
+TextStoreStats TextStore::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::string Text::str() const {
+    return store ? *store->get(id) : plain;
+}
+
+bool Text::empty() const {
+    return store ? false : plain.empty();
+}
+
+std::ostream& operator<<(std::ostream& os, const Text& text) {
+    if (text.store) {
+        return os << *text.store->get(text.id);
+    }
+    return os << text.plain;
+}
@@ -0,0 +1,191 @@
+#include "Trace.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    // One span. Fields are relaxed atomics so the exporter may read a slot
+    // while its thread overwrites it; such entries are detected and dropped.
+    struct Slot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> start{0};
+        std::atomic<uint64_t> duration{0};
+        std::atomic<uint64_t> session{0};
+    };
+    
+    struct TraceRing {
+        uint32_t threadId;
+        alignas(64) std::atomic<uint64_t> head{0}; // spans ever written
+        Slot slots[Tracer::RING_SIZE];
+        
+        explicit TraceRing(uint32_t id) : threadId(id) {}
+    };
+    
+    struct Event {
+        const char* name;
+        uint64_t start;
+        uint64_t duration;
+        uint64_t session;
+    };
+    
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<TraceRing>> registry;
+    
+    thread_local TraceRing* localRing = nullptr;
+    thread_local uint64_t sampleState = 0;
+    
+    TraceRing& ringForThread() {
+        if (!localRing) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry.push_back(std::make_shared<TraceRing>(static_cast<uint32_t>(registry.size() + 1)));
+            localRing = registry.back().get();
+        }
+        return *localRing;
+    }
+    
+    // Copies the spans of one ring that were not overwritten during the copy
+    void snapshot(const TraceRing& ring, std::vector<Event>& events) {
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t first = head > Tracer::RING_SIZE ? head - Tracer::RING_SIZE : 0;
+        size_t begin = events.size();
+        for (uint64_t i = first; i < head; ++i) {
+            const Slot& slot = ring.slots[i & (Tracer::RING_SIZE - 1)];
+            events.push_back({slot.name.load(std::memory_order_relaxed),
+                              slot.start.load(std::memory_order_relaxed),
+                              slot.duration.load(std::memory_order_relaxed),
+                              slot.session.load(std::memory_order_relaxed)});
+        }
+        
+        // The writer fills slot head % RING_SIZE before publishing head + 1, so
+        // anything at or below the newest head - RING_SIZE may be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t newest = ring.head.load(std::memory_order_relaxed);
+        if (newest >= first + Tracer::RING_SIZE) {
+            size_t torn = static_cast<size_t>(std::min<uint64_t>(newest - first - Tracer::RING_SIZE + 1, head - first));
+            events.erase(events.begin() + static_cast<std::ptrdiff_t>(begin),
+                         events.begin() + static_cast<std::ptrdiff_t>(begin + torn));
+        }
+    }
+    
+    // Nanoseconds as microseconds with three decimals, the trace format's unit
+    void appendMicros(std::string& out, uint64_t nanos) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), nanos / 1000);
+        out.append(digits, result.ptr);
+        unsigned fraction = static_cast<unsigned>(nanos % 1000);
+        out.push_back('.');
+        out.push_back(static_cast<char>('0' + fraction / 100));
+        out.push_back(static_cast<char>('0' + fraction / 10 % 10));
+        out.push_back(static_cast<char>('0' + fraction % 10));
+    }
+    
+    void appendNumber(std::string& out, uint64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+}
+
+const std::chrono::steady_clock::time_point Tracer::epoch = std::chrono::steady_clock::now();
+std::atomic<uint32_t> Tracer::sampleThreshold{0};
+
+void Tracer::setSampleRate(double rate) {
+    if (rate <= 0) {
+        sampleThreshold = 0;
+    } else if (rate >= 1) {
+        sampleThreshold = UINT32_MAX;
+    } else {
+        sampleThreshold = static_cast<uint32_t>(rate * 4294967296.0);
+    }
+}
+
+bool Tracer::sampled() {
+    // xorshift64 per thread, seeded from the thread's storage address and the clock
+    if (sampleState == 0) {
+        sampleState = (reinterpret_cast<uintptr_t>(&sampleState) ^ now()) | 1;
+    }
+    sampleState ^= sampleState << 13;
+    sampleState ^= sampleState >> 7;
+    sampleState ^= sampleState << 17;
+    return static_cast<uint32_t>(sampleState >> 32) < sampleThreshold.load(std::memory_order_relaxed);
+}
+
+void Tracer::prepareThread() {
+    ringForThread();
+}
+
+void Tracer::record(const char* name, uint64_t start, uint64_t end) {
+    TraceRing& ring = ringForThread();
+    uint64_t index = ring.head.load(std::memory_order_relaxed);
+    Slot& slot = ring.slots[index & (RING_SIZE - 1)];
+    // Orders the previous head store before these slot stores, so an exporter
+    // that sees any of them also sees that this slot is being rewritten
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(end - start, std::memory_order_relaxed);
+    slot.session.store(activeSession, std::memory_order_relaxed);
+    ring.head.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::exportJson(std::ostream& os) {
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        rings = registry;
+    }
+    
+    std::string pid = std::to_string(getpid());
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    std::vector<Event> events;
+    for (const auto& ring : rings) {
+        events.clear();
+        snapshot(*ring, events);
+        
+        if (!first) out.push_back(',');
+        first = false;
+        out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":").append(pid);
+        out.append(",\"tid\":");
+        appendNumber(out, ring->threadId);
+        out.append(",\"args\":{\"name\":\"thread ");
+        appendNumber(out, ring->threadId);
+        out.append("\"}}");
+        
+        for (const Event& event : events) {
+            // Span names are literals from the code, so they need no escaping
+            out.append(",{\"name\":\"").append(event.name ? event.name : "?");
+            out.append("\",\"ph\":\"X\",\"ts\":");
+            appendMicros(out, event.start);
+            out.append(",\"dur\":");
+            appendMicros(out, event.duration);
+            out.append(",\"pid\":").append(pid);
+            out.append(",\"tid\":");
+            appendNumber(out, ring->threadId);
+            out.append(",\"args\":{\"session\":");
+            appendNumber(out, event.session);
+            out.append("}}");
+        }
+        os.write(out.data(), static_cast<std::streamsize>(out.size()));
+        out.clear();
+    }
+    out.append("]}\n");
+    os.write(out.data(), static_cast<std::streamsize>(out.size()));
+}
+
+void Tracer::exportFile(const std::string& path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot write trace file: " + path);
+    }
+    exportJson(file);
+    if (!file) {
+        throw std::runtime_error("Failed writing trace file: " + path);
+    }
+}
@@ -0,0 +1,837 @@
+#include "WorldAnalyzer.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const uint32_t NONE = UINT32_MAX;
+    const size_t KEY_ORDER_KEPT = 20;
+    const size_t SEQUENTIAL_LEVEL = 4096; // search levels smaller than this stay on one thread
+    
+    // Threads that run one task at a time, each call with its own index;
+    // the calling thread takes index 0. Kept for the whole analysis so a
+    // search with thousands of levels does not start thousands of threads.
+    class ThreadTeam {
+    private:
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        const std::function<void(unsigned)>* task = nullptr;
+        uint64_t generation = 0;
+        unsigned running = 0;
+        bool stopping = false;
+        std::exception_ptr failure;
+        
+        void loop(unsigned index) {
+            uint64_t seen = 0;
+            while (true) {
+                const std::function<void(unsigned)>* current;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                    current = task;
+                }
+                try {
+                    (*current)(index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failure = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--running == 0) {
+                    finished.notify_one();
+                }
+            }
+        }
+    
+    public:
+        explicit ThreadTeam(unsigned size) {
+            for (unsigned i = 1; i < size; ++i) {
+                threads.emplace_back(&ThreadTeam::loop, this, i);
+            }
+        }
+        ~ThreadTeam() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        }
+        
+        unsigned size() const { return static_cast<unsigned>(threads.size()) + 1; }
+        
+        // Runs work(index) on every thread and waits for all of them
+        void run(const std::function<void(unsigned)>& work) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                task = &work;
+                running = static_cast<unsigned>(threads.size());
+                ++generation;
+            }
+            wake.notify_all();
+            try {
+                work(0);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                failure = std::current_exception();
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&] { return running == 0; });
+            if (failure) {
+                std::exception_ptr error = failure;
+                failure = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+    };
+    
+    // Part of count handled by one of parts threads
+    std::pair<size_t, size_t> share(size_t count, unsigned part, unsigned parts) {
+        return {count * part / parts, count * (part + 1) / parts};
+    }
+    
+    class MappedFile {
+    private:
+        const char* data = nullptr;
+        size_t size = 0;
+    
+    public:
+        explicit MappedFile(const std::string& path) {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot open world file: " + path);
+            }
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0) {
+                size = static_cast<size_t>(info.st_size);
+                void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED) {
+                    close(fd);
+                    throw std::runtime_error("Cannot map world file: " + path);
+                }
+                data = static_cast<const char*>(mapping);
+                madvise(mapping, size, MADV_SEQUENTIAL);
+            }
+            close(fd);
+        }
+        ~MappedFile() {
+            if (data) {
+                munmap(const_cast<char*>(data), size);
+            }
+        }
+        
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        
+        std::string_view text() const { return std::string_view(data ? data : "", size); }
+    };
+    
+    // Without surrounding blanks, including a CRLF file's '\r', as WorldFile trims them
+    std::string_view trimBlanks(std::string_view text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos) return {};
+        return text.substr(first, text.find_last_not_of(" \t\r") + 1 - first);
+    }
+    
+    // A whole field as a number, blanks around it allowed, as WorldFile reads it
+    bool parseInt(std::string_view text, int& value) {
+        text = trimBlanks(text);
+        if (text.empty()) return false;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+    
+    // Whole rooms of the file, parsed by one thread. Names point into the mapping.
+    struct Slice {
+        std::string_view text;
+        std::vector<int> roomIds;
+        std::vector<size_t> exitEnd;                              // per room, into exitTargets
+        std::vector<int> exitTargets;
+        std::vector<std::string_view> locks;                      // per room; empty when open
+        std::vector<std::pair<uint32_t, std::string_view>> items; // takeable items by room in the slice
+        int startRoomId = -1;
+        size_t lines = 0;
+        size_t errorLine = 0; // within the slice; 0 when it parsed
+        std::string error;
+        
+        // Filled once every slice is parsed
+        size_t roomBase = 0;
+        size_t exitBase = 0;
+        std::vector<size_t> resolvedEnd;
+        std::vector<uint32_t> resolved;
+        std::vector<std::pair<uint32_t, uint32_t>> holdings; // room, key id
+        size_t missingExits = 0;
+        std::vector<WorldAnalyzer::Finding> missingExamples;
+    };
+    
+    void parseSlice(Slice& slice) {
+        const char* cursor = slice.text.data();
+        const char* end = cursor + slice.text.size();
+        auto fail = [&slice](std::string message) {
+            slice.error = std::move(message);
+            slice.errorLine = slice.lines;
+        };
+        
+        while (cursor < end) {
+            const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+            const char* lineEnd = newline ? newline : end;
+            std::string_view line(cursor, static_cast<size_t>(lineEnd - cursor));
+            cursor = newline ? newline + 1 : end;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            ++slice.lines;
+            if (line.empty() || line[0] == '#') continue;
+            
+            size_t space = line.find(' ');
+            std::string_view keyword = line.substr(0, space);
+            std::string_view rest = space == std::string_view::npos ? std::string_view() : line.substr(space + 1);
+            bool inRoom = !slice.roomIds.empty();
+            if (keyword == "room") {
+                int roomId;
+                if (!parseInt(rest.substr(0, rest.find('|')), roomId)) {
+                    return fail("room needs id|name|description");
+                }
+                slice.roomIds.push_back(roomId);
+                slice.exitEnd.push_back(slice.exitTargets.size());
+                slice.locks.emplace_back();
+            } else if (keyword == "exit") {
+                size_t bar = rest.find('|');
+                int target;
+                if (!inRoom || bar == std::string_view::npos || !parseInt(rest.substr(bar + 1), target)) {
+                    return fail("exit needs a room and direction|room id");
+                }
+                slice.exitTargets.push_back(target);
+                slice.exitEnd.back() = slice.exitTargets.size();
+            } else if (keyword == "lock") {
+                if (!inRoom) return fail("lock needs a room");
+                slice.locks.back() = trimBlanks(rest);
+            } else if (keyword == "item") {
+                if (!inRoom) return fail("item needs a room and type|name");
+                // type|name|description|value|flags|param; only takeable items open locks
+                std::string_view fields[5];
+                size_t fieldCount = 0;
+                size_t from = 0;
+                while (fieldCount < 5) {
+                    size_t bar = rest.find('|', from);
+                    fields[fieldCount++] = rest.substr(from, bar == std::string_view::npos ? bar : bar - from);
+                    if (bar == std::string_view::npos) break;
+                    from = bar + 1;
+                }
+                if (fieldCount == 5 && fields[4].find('t') != std::string_view::npos) {
+                    slice.items.emplace_back(static_cast<uint32_t>(slice.roomIds.size() - 1), fields[1]);
+                }
+            } else if (keyword == "start") {
+                if (!parseInt(rest, slice.startRoomId)) {
+                    return fail("start needs a room id");
+                }
+            } else if (keyword != "creature" && keyword != "hazard" && keyword != "on") {
+                return fail("unknown directive '" + std::string(keyword) + "'");
+            }
+        }
+    }
+    
+    // Exits as arrays: room i leads to targets[offsets[i]] .. targets[offsets[i + 1]]
+    struct Graph {
+        std::vector<size_t> offsets;
+        std::vector<uint32_t> targets;
+    };
+    
+    // Searches level by level from the rooms in frontier, which must already
+    // be marked in seen. enter(room, thread) decides whether an unmarked
+    // neighbour may be entered; betweenLevels(next) runs on one thread with
+    // the rooms just entered and may add more (marking them).
+    template <typename Enter, typename BetweenLevels>
+    void search(ThreadTeam& team, const Graph& graph, std::vector<uint32_t> frontier,
+                std::vector<uint8_t>& seen, Enter enter, BetweenLevels betweenLevels) {
+        std::vector<std::vector<uint32_t>> found(team.size());
+        std::vector<uint32_t> next;
+        auto expand = [&](unsigned thread, unsigned parts) {
+            std::vector<uint32_t>& local = found[thread];
+            auto [first, last] = share(frontier.size(), thread, parts);
+            for (size_t i = first; i < last; ++i) {
+                uint32_t room = frontier[i];
+                for (size_t e = graph.offsets[room]; e < graph.offsets[room + 1]; ++e) {
+                    uint32_t target = graph.targets[e];
+                    std::atomic_ref<uint8_t> mark(seen[target]);
+                    if (mark.load(std::memory_order_relaxed) || !enter(target, thread)) continue;
+                    if (mark.exchange(1, std::memory_order_relaxed) == 0) {
+                        local.push_back(target);
+                    }
+                }
+            }
+        };
+        std::function<void(unsigned)> parallelExpand = [&](unsigned thread) { expand(thread, team.size()); };
+        
+        while (!frontier.empty()) {
+            if (frontier.size() < SEQUENTIAL_LEVEL || team.size() == 1) {
+                expand(0, 1);
+            } else {
+                team.run(parallelExpand);
+            }
+            next.clear();
+            for (std::vector<uint32_t>& local : found) {
+                next.insert(next.end(), local.begin(), local.end());
+                local.clear();
+            }
+            betweenLevels(next);
+            frontier.swap(next);
+        }
+    }
+    
+    // Rooms reached from start along graph's exits
+    std::vector<uint8_t> reachableFrom(ThreadTeam& team, const Graph& graph, uint32_t start) {
+        std::vector<uint8_t> seen(graph.offsets.size() - 1, 0);
+        seen[start] = 1;
+        search(team, graph, {start}, seen,
+               [](uint32_t, unsigned) { return true; }, [](std::vector<uint32_t>&) {});
+        return seen;
+    }
+    
+    Graph reverse(ThreadTeam& team, const Graph& graph) {
+        size_t rooms = graph.offsets.size() - 1;
+        std::vector<uint32_t> incoming(rooms, 0);
+        std::function<void(unsigned)> countIncoming = [&](unsigned thread) {
+            auto [first, last] = share(graph.targets.size(), thread, team.size());
+            for (size_t e = first; e < last; ++e) {
+                std::atomic_ref<uint32_t>(incoming[graph.targets[e]]).fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+        team.run(countIncoming);
+        
+        Graph reversed;
+        reversed.offsets.resize(rooms + 1);
+        reversed.offsets[0] = 0;
+        for (size_t i = 0; i < rooms; ++i) {
+            reversed.offsets[i + 1] = reversed.offsets[i] + incoming[i];
+        }
+        reversed.targets.resize(graph.targets.size());
+        std::vector<size_t> cursor(reversed.offsets.begin(), reversed.offsets.end() - 1);
+        std::function<void(unsigned)> fill = [&](unsigned thread) {
+            auto [first, last] = share(rooms, thread, team.size());
+            for (size_t room = first; room < last; ++room) {
+                for (size_t e = graph.offsets[room]; e < graph.offsets[room + 1]; ++e) {
+                    size_t slot = std::atomic_ref<size_t>(cursor[graph.targets[e]]).fetch_add(1, std::memory_order_relaxed);
+                    reversed.targets[slot] = static_cast<uint32_t>(room);
+                }
+            }
+        };
+        team.run(fill);
+        return reversed;
+    }
+    
+    // Tarjan's algorithm, without recursion, over the rooms marked in member.
+    // Returns each room's component (NONE outside member); components are
+    // numbered from 0 in the order they complete.
+    std::vector<uint32_t> components(const Graph& graph, const std::vector<uint8_t>& member, uint32_t& componentCount) {
+        size_t rooms = member.size();
+        std::vector<uint32_t> component(rooms, NONE);
+        std::vector<uint32_t> order(rooms, NONE);
+        std::vector<uint32_t> low(rooms, 0);
+        std::vector<uint8_t> onStack(rooms, 0);
+        std::vector<uint32_t> stack;
+        std::vector<std::pair<uint32_t, size_t>> calls; // room, next exit to follow
+        uint32_t counter = 0;
+        componentCount = 0;
+        
+        auto open = [&](uint32_t room) {
+            order[room] = low[room] = counter++;
+            stack.push_back(room);
+            onStack[room] = 1;
+            calls.emplace_back(room, graph.offsets[room]);
+        };
+        for (uint32_t root = 0; root < rooms; ++root) {
+            if (!member[root] || order[root] != NONE) continue;
+            open(root);
+            while (!calls.empty()) {
+                uint32_t room = calls.back().first;
+                size_t exit = calls.back().second;
+                if (exit < graph.offsets[room + 1]) {
+                    calls.back().second = exit + 1;
+                    uint32_t target = graph.targets[exit];
+                    if (!member[target]) continue;
+                    if (order[target] == NONE) {
+                        open(target);
+                    } else if (onStack[target]) {
+                        low[room] = std::min(low[room], order[target]);
+                    }
+                    continue;
+                }
+                
+                if (low[room] == order[room]) {
+                    uint32_t popped;
+                    do {
+                        popped = stack.back();
+                        stack.pop_back();
+                        onStack[popped] = 0;
+                        component[popped] = componentCount;
+                    } while (popped != room);
+                    ++componentCount;
+                }
+                calls.pop_back();
+                if (!calls.empty()) {
+                    uint32_t caller = calls.back().first;
+                    low[caller] = std::min(low[caller], low[room]);
+                }
+            }
+        }
+        return component;
+    }
+}
+
+WorldAnalyzer::WorldAnalyzer(const std::string& worldPath, unsigned threads)
+    : path(worldPath), threadCount(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      roomCount(0), exitCount(0), lockedCount(0), startRoomId(-1), reachableCount(0), openableCount(0),
+      startComponentSize(0), oneWayCount(0), seconds(0), counts{} {
+    auto started = std::chrono::steady_clock::now();
+    analyze();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+void WorldAnalyzer::analyze() {
+    MappedFile file(path);
+    std::string_view text = file.text();
+    ThreadTeam team(threadCount);
+    unsigned parts = team.size();
+    
+    // Parse: slices start at room lines, so every room is whole in one slice
+    std::vector<Slice> slices(parts);
+    size_t begin = 0;
+    for (unsigned i = 0; i < parts; ++i) {
+        size_t end = text.size();
+        if (i + 1 < parts) {
+            size_t at = std::max(begin, text.size() / parts * (i + 1));
+            size_t found = text.find("\nroom ", at == 0 ? 0 : at - 1);
+            end = found == std::string_view::npos ? text.size() : found + 1;
+        }
+        slices[i].text = text.substr(begin, end - begin);
+        begin = end;
+    }
+    std::function<void(unsigned)> parse = [&](unsigned thread) { parseSlice(slices[thread]); };
+    team.run(parse);
+    
+    size_t lineBase = 0;
+    for (Slice& slice : slices) {
+        if (!slice.error.empty()) {
+            throw std::runtime_error(path + ":" + std::to_string(lineBase + slice.errorLine) + ": " + slice.error);
+        }
+        lineBase += slice.lines;
+        slice.roomBase = roomCount;
+        roomCount += slice.roomIds.size();
+        if (slice.startRoomId != -1) {
+            startRoomId = slice.startRoomId; // the last start directive wins, as in WorldFile
+        }
+    }
+    if (roomCount == 0) {
+        throw std::runtime_error(path + ": world has no rooms");
+    }
+    if (roomCount >= NONE) {
+        throw std::runtime_error(path + ": too many rooms to analyze");
+    }
+    if (startRoomId == -1) {
+        for (const Slice& slice : slices) {
+            if (!slice.roomIds.empty()) {
+                startRoomId = slice.roomIds.front();
+                break;
+            }
+        }
+    }
+    
+    std::vector<Finding> examples[PROBLEM_COUNT];
+    auto note = [&](Problem problem, int roomId, int otherId, std::string_view key) {
+        size_t index = static_cast<size_t>(problem);
+        if (counts[index]++ < EXAMPLES_PER_PROBLEM) {
+            examples[index].push_back({problem, roomId, otherId, std::string(key)});
+        }
+    };
+    
+    // Room ids to indices: each slice sorts its own rooms, then sorted runs merge pairwise
+    std::vector<int> roomIds(roomCount);
+    std::vector<std::pair<int, uint32_t>> byId(roomCount);
+    std::function<void(unsigned)> sortSlices = [&](unsigned thread) {
+        Slice& slice = slices[thread];
+        for (size_t i = 0; i < slice.roomIds.size(); ++i) {
+            roomIds[slice.roomBase + i] = slice.roomIds[i];
+            byId[slice.roomBase + i] = {slice.roomIds[i], static_cast<uint32_t>(slice.roomBase + i)};
+        }
+        auto first = byId.begin() + static_cast<std::ptrdiff_t>(slice.roomBase);
+        auto last = first + static_cast<std::ptrdiff_t>(slice.roomIds.size());
+        if (!std::is_sorted(first, last)) {
+            std::sort(first, last); // files usually list rooms in id order
+        }
+    };
+    team.run(sortSlices);
+    auto idOf = [&roomIds](uint32_t room) { return roomIds[room]; };
+    for (unsigned width = 1; width < parts; width *= 2) {
+        std::function<void(unsigned)> merge = [&](unsigned thread) {
+            unsigned left = thread * 2 * width;
+            if (left + width >= parts) return;
+            auto at = [&](unsigned slice) {
+                return byId.begin() + static_cast<std::ptrdiff_t>(slice < parts ? slices[slice].roomBase : roomCount);
+            };
+            std::inplace_merge(at(left), at(left + width), at(std::min(parts, left + 2 * width)));
+        };
+        team.run(merge);
+    }
+    
+    std::vector<uint8_t> duplicate;
+    for (size_t i = 1; i < roomCount; ++i) {
+        if (byId[i].first == byId[i - 1].first) {
+            if (duplicate.empty()) duplicate.assign(roomCount, 0);
+            duplicate[byId[i].second] = 1; // exits lead to the first definition
+            note(Problem::DUPLICATE_ROOM, byId[i].first, 0, {});
+        }
+    }
+    
+    // Dense ids (the usual case) are looked up in a table, others by binary search
+    int64_t lowestId = byId.front().first;
+    int64_t idRange = static_cast<int64_t>(byId.back().first) - lowestId + 1;
+    std::vector<uint32_t> table;
+    if (static_cast<uint64_t>(idRange) <= 4 * roomCount + 64) {
+        table.assign(static_cast<size_t>(idRange), NONE);
+        std::function<void(unsigned)> fillTable = [&](unsigned thread) {
+            auto [first, last] = share(roomCount, thread, parts);
+            for (size_t i = first; i < last; ++i) {
+                if (i == 0 || byId[i - 1].first != byId[i].first) {
+                    table[static_cast<size_t>(byId[i].first - lowestId)] = byId[i].second;
+                }
+            }
+        };
+        team.run(fillTable);
+    }
+    auto lookup = [&](int roomId) -> uint32_t {
+        if (!table.empty()) {
+            int64_t offset = static_cast<int64_t>(roomId) - lowestId;
+            return offset < 0 || offset >= idRange ? NONE : table[static_cast<size_t>(offset)];
+        }
+        auto it = std::lower_bound(byId.begin(), byId.end(), std::make_pair(roomId, uint32_t(0)));
+        return it != byId.end() && it->first == roomId ? it->second : NONE;
+    };
+    uint32_t start = lookup(startRoomId);
+    if (start == NONE) {
+        throw std::runtime_error(path + ": start room " + std::to_string(startRoomId) + " does not exist");
+    }
+    
+    // Lock keys get dense ids; the rooms holding a takeable item of that name are found per slice
+    std::unordered_map<std::string_view, uint32_t> keyIds;
+    std::vector<std::string_view> keyNames;
+    std::vector<uint32_t> lockKey(roomCount, NONE);
+    for (const Slice& slice : slices) {
+        for (size_t i = 0; i < slice.locks.size(); ++i) {
+            if (slice.locks[i].empty()) continue;
+            auto inserted = keyIds.emplace(slice.locks[i], static_cast<uint32_t>(keyNames.size()));
+            if (inserted.second) keyNames.push_back(slice.locks[i]);
+            lockKey[slice.roomBase + i] = inserted.first->second;
+            ++lockedCount;
+        }
+    }
+    
+    std::function<void(unsigned)> resolve = [&](unsigned thread) {
+        Slice& slice = slices[thread];
+        slice.resolvedEnd.resize(slice.roomIds.size());
+        slice.resolved.reserve(slice.exitTargets.size());
+        size_t exit = 0;
+        for (size_t i = 0; i < slice.roomIds.size(); ++i) {
+            for (; exit < slice.exitEnd[i]; ++exit) {
+                uint32_t target = lookup(slice.exitTargets[exit]);
+                if (target != NONE) {
+                    slice.resolved.push_back(target);
+                } else if (slice.missingExits++ < EXAMPLES_PER_PROBLEM) {
+                    slice.missingExamples.push_back({Problem::MISSING_ROOM, slice.roomIds[i], slice.exitTargets[exit], {}});
+                }
+            }
+            slice.resolvedEnd[i] = slice.resolved.size();
+        }
+        std::vector<int>().swap(slice.exitTargets);
+        
+        for (const auto& item : slice.items) {
+            auto key = keyIds.find(item.second);
+            if (key != keyIds.end()) {
+                slice.holdings.emplace_back(static_cast<uint32_t>(slice.roomBase + item.first), key->second);
+            }
+        }
+    };
+    team.run(resolve);
+    
+    Graph graph;
+    graph.offsets.resize(roomCount + 1);
+    graph.offsets[0] = 0;
+    for (Slice& slice : slices) {
+        slice.exitBase = exitCount;
+        exitCount += slice.resolved.size();
+        counts[static_cast<size_t>(Problem::MISSING_ROOM)] += slice.missingExits;
+        for (Finding& finding : slice.missingExamples) {
+            if (examples[static_cast<size_t>(Problem::MISSING_ROOM)].size() < EXAMPLES_PER_PROBLEM) {
+                examples[static_cast<size_t>(Problem::MISSING_ROOM)].push_back(std::move(finding));
+            }
+        }
+    }
+    graph.targets.resize(exitCount);
+    std::function<void(unsigned)> gather = [&](unsigned thread) {
+        Slice& slice = slices[thread];
+        for (size_t i = 0; i < slice.roomIds.size(); ++i) {
+            graph.offsets[slice.roomBase + i + 1] = slice.exitBase + slice.resolvedEnd[i];
+        }
+        std::copy(slice.resolved.begin(), slice.resolved.end(),
+                  graph.targets.begin() + static_cast<std::ptrdiff_t>(slice.exitBase));
+        std::vector<uint32_t>().swap(slice.resolved);
+    };
+    team.run(gather);
+    
+    // Keys held per room, and the first room holding each key
+    std::vector<std::pair<uint32_t, uint32_t>> holdings;
+    for (Slice& slice : slices) {
+        holdings.insert(holdings.end(), slice.holdings.begin(), slice.holdings.end());
+    }
+    std::vector<uint32_t> keyHolder(keyNames.size(), NONE);
+    std::vector<uint8_t> holdsKey(roomCount, 0);
+    for (const auto& holding : holdings) {
+        if (keyHolder[holding.second] == NONE) keyHolder[holding.second] = holding.first;
+        holdsKey[holding.first] = 1;
+    }
+    
+    // Reachability with every lock open
+    std::vector<uint8_t> reachable = reachableFrom(team, graph, start);
+    
+    // Reachability opening each lock only once its key has been picked up.
+    // Locked rooms met before their key wait on it; picking the key up lets them in.
+    std::vector<uint8_t> entered(roomCount, 0);
+    std::vector<uint8_t> parked(roomCount, 0);
+    std::vector<uint8_t> keyReady(keyNames.size(), 0);
+    std::vector<std::vector<uint32_t>> waiting(keyNames.size());
+    std::vector<std::vector<uint32_t>> blocked(parts);
+    size_t moves = 0;
+    auto pickUp = [&](std::vector<uint32_t>& rooms) {
+        for (size_t i = 0; i < rooms.size(); ++i) {
+            if (!holdsKey[rooms[i]]) continue;
+            auto held = std::lower_bound(holdings.begin(), holdings.end(), std::make_pair(rooms[i], uint32_t(0)));
+            for (; held != holdings.end() && held->first == rooms[i]; ++held) {
+                uint32_t key = held->second;
+                if (keyReady[key]) continue;
+                keyReady[key] = 1;
+                if (keyOrder.size() < KEY_ORDER_KEPT) {
+                    keyOrder.push_back({std::string(keyNames[key]), idOf(rooms[i]), moves});
+                }
+                for (uint32_t room : waiting[key]) {
+                    if (!entered[room]) {
+                        entered[room] = 1;
+                        rooms.push_back(room);
+                    }
+                }
+                std::vector<uint32_t>().swap(waiting[key]);
+            }
+        }
+    };
+    entered[start] = 1;
+    std::vector<uint32_t> first{start};
+    pickUp(first);
+    search(team, graph, first, entered,
+        [&](uint32_t room, unsigned thread) {
+            uint32_t key = lockKey[room];
+            if (key == NONE || keyReady[key]) return true;
+            if (std::atomic_ref<uint8_t>(parked[room]).exchange(1, std::memory_order_relaxed) == 0) {
+                blocked[thread].push_back(room);
+            }
+            return false;
+        },
+        [&](std::vector<uint32_t>& next) {
+            ++moves;
+            for (std::vector<uint32_t>& rooms : blocked) {
+                for (uint32_t room : rooms) {
+                    waiting[lockKey[room]].push_back(room);
+                }
+                rooms.clear();
+            }
+            pickUp(next);
+        });
+    
+    // The start room's component: reachable from it and able to get back to it
+    std::vector<uint8_t> returns = reachableFrom(team, reverse(team, graph), start);
+    std::vector<uint8_t> oneWay(roomCount, 0);
+    for (size_t i = 0; i < roomCount; ++i) {
+        reachableCount += reachable[i];
+        openableCount += entered[i];
+        startComponentSize += reachable[i] & returns[i];
+        oneWay[i] = reachable[i] & !returns[i];
+        oneWayCount += oneWay[i];
+    }
+    
+    // Per room problems, counted per thread over contiguous ranges so examples stay in file order
+    struct Tally {
+        std::array<size_t, PROBLEM_COUNT> counts{};
+        std::vector<Finding> examples;
+    };
+    std::vector<Tally> tallies(parts);
+    std::function<void(unsigned)> classify = [&](unsigned thread) {
+        Tally& tally = tallies[thread];
+        auto add = [&](Problem problem, size_t room, int otherId, std::string_view key) {
+            if (tally.counts[static_cast<size_t>(problem)]++ < EXAMPLES_PER_PROBLEM) {
+                tally.examples.push_back({problem, idOf(static_cast<uint32_t>(room)), otherId, std::string(key)});
+            }
+        };
+        auto [first, last] = share(roomCount, thread, parts);
+        for (size_t room = first; room < last; ++room) {
+            if (!duplicate.empty() && duplicate[room]) continue;
+            uint32_t key = lockKey[room];
+            if (key != NONE && keyHolder[key] == NONE) {
+                add(Problem::MISSING_KEY, room, 0, keyNames[key]);
+            }
+            if (!reachable[room]) {
+                add(Problem::UNREACHABLE, room, 0, {});
+            } else if (!entered[room]) {
+                if (key != NONE && keyHolder[key] != NONE && !keyReady[key]) {
+                    add(Problem::KEY_BEHIND_DOOR, room, idOf(keyHolder[key]), keyNames[key]);
+                } else if (key == NONE || keyReady[key]) {
+                    add(Problem::LOCKED_OUT, room, 0, {});
+                }
+            }
+        }
+    };
+    team.run(classify);
+    for (Tally& tally : tallies) {
+        for (size_t problem = 0; problem < PROBLEM_COUNT; ++problem) {
+            counts[problem] += tally.counts[problem];
+        }
+        for (Finding& finding : tally.examples) {
+            std::vector<Finding>& kept = examples[static_cast<size_t>(finding.problem)];
+            if (kept.size() < EXAMPLES_PER_PROBLEM) kept.push_back(std::move(finding));
+        }
+    }
+    
+    // One-way rooms group into components; those no exit leaves are dead ends
+    if (oneWayCount > 0) {
+        uint32_t componentCount;
+        std::vector<uint32_t> component = components(graph, oneWay, componentCount);
+        std::vector<uint8_t> leaves(componentCount, 0);
+        std::vector<uint32_t> size(componentCount, 0);
+        std::vector<uint32_t> firstRoom(componentCount, NONE);
+        for (uint32_t room = 0; room < roomCount; ++room) {
+            uint32_t own = component[room];
+            if (own == NONE) continue;
+            ++size[own];
+            if (firstRoom[own] == NONE) firstRoom[own] = room;
+            for (size_t e = graph.offsets[room]; e < graph.offsets[room + 1]; ++e) {
+                if (component[graph.targets[e]] != own) leaves[own] = 1;
+            }
+        }
+        std::vector<uint32_t> deadEnds;
+        for (uint32_t c = 0; c < componentCount; ++c) {
+            if (!leaves[c]) deadEnds.push_back(c);
+        }
+        std::sort(deadEnds.begin(), deadEnds.end(),
+                  [&](uint32_t a, uint32_t b) { return firstRoom[a] < firstRoom[b]; });
+        for (uint32_t c : deadEnds) {
+            note(Problem::DEAD_END, idOf(firstRoom[c]), static_cast<int>(size[c]), {});
+        }
+    }
+    
+    for (auto& kept : examples) {
+        findings.insert(findings.end(), std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()));
+    }
+}
+
+bool WorldAnalyzer::hasErrors() const {
+    for (size_t problem = 0; problem < PROBLEM_COUNT; ++problem) {
+        if (counts[problem] && static_cast<Problem>(problem) != Problem::DEAD_END) return true;
+    }
+    return false;
+}
+
+const char* WorldAnalyzer::problemName(Problem problem) {
+    switch (problem) {
+        case Problem::DUPLICATE_ROOM: return "duplicate room";
+        case Problem::MISSING_ROOM: return "missing room";
+        case Problem::UNREACHABLE: return "unreachable";
+        case Problem::MISSING_KEY: return "missing key";
+        case Problem::KEY_BEHIND_DOOR: return "key behind door";
+        case Problem::LOCKED_OUT: return "locked out";
+        case Problem::DEAD_END: return "dead end";
+        default: return "unknown";
+    }
+}
+
+void WorldAnalyzer::print(std::ostream& os) const {
+    os << path << ": " << roomCount << " rooms, " << exitCount << " exits, " << lockedCount
+       << " locked; checked with " << threadCount << " threads in " << seconds * 1000 << " ms\n";
+    os << "from start room " << startRoomId << ": " << reachableCount << " reachable, "
+       << openableCount << " with locks opened in key order, " << startComponentSize
+       << " in its strongly connected component, " << oneWayCount << " one-way\n";
+    if (!keyOrder.empty()) {
+        os << "keys in pickup order:";
+        for (size_t i = 0; i < keyOrder.size(); ++i) {
+            os << (i ? ", " : " ") << keyOrder[i].key << " (room " << keyOrder[i].roomId
+               << ", " << keyOrder[i].moves << " moves)";
+        }
+        os << (keyOrder.size() == KEY_ORDER_KEPT ? ", ...\n" : "\n");
+    }
+    
+    size_t errors = 0;
+    for (size_t problem = 0; problem < PROBLEM_COUNT; ++problem) {
+        if (counts[problem] == 0) continue;
+        Problem kind = static_cast<Problem>(problem);
+        if (kind != Problem::DEAD_END) errors += counts[problem];
+        os << problemName(kind) << ": " << counts[problem] << "\n";
+        for (const Finding& finding : findings) {
+            if (finding.problem != kind) continue;
+            os << "  room " << finding.roomId;
+            switch (kind) {
+                case Problem::DUPLICATE_ROOM:
+                    os << " is defined again";
+                    break;
+                case Problem::MISSING_ROOM:
+                    os << ": exit to missing room " << finding.otherId;
+                    break;
+                case Problem::UNREACHABLE:
+                    os << ": no exits lead there from the start room";
+                    break;
+                case Problem::MISSING_KEY:
+                    os << ": locked with '" << finding.key << "', but no room holds one that can be taken";
+                    break;
+                case Problem::KEY_BEHIND_DOOR:
+                    if (finding.otherId == finding.roomId) {
+                        os << ": its key '" << finding.key << "' is inside it";
+                    } else {
+                        os << ": its key '" << finding.key << "' (in room " << finding.otherId
+                           << ") lies behind locks that cannot be opened first";
+                    }
+                    break;
+                case Problem::LOCKED_OUT:
+                    os << ": only reachable through locks that cannot be opened";
+                    break;
+                default:
+                    if (finding.otherId > 1) {
+                        os << " (" << finding.otherId << " rooms)";
+                    }
+                    os << ": no way out, or back to the start room";
+                    break;
+            }
+            os << "\n";
+        }
+        if (counts[problem] > EXAMPLES_PER_PROBLEM) {
+            os << "  ... and " << counts[problem] - EXAMPLES_PER_PROBLEM << " more\n";
+        }
+    }
+    if (errors == 0) {
+        os << (counts[static_cast<size_t>(Problem::DEAD_END)] ? "no errors\n" : "no problems found\n");
+    } else {
+        os << errors << " errors\n";
+    }
+}
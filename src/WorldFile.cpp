@@ -0,0 +1,332 @@
+#include "WorldFile.h"
+#include <algorithm>
+#include <charconv>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // Enough text to find the recurring phrases without training on the whole file
+    const size_t TEXT_SAMPLE_BYTES = 256 * 1024;
+    
+    std::vector<std::string> splitFields(const std::string& text) {
+        std::vector<std::string> fields;
+        std::string field;
+        std::istringstream iss(text);
+        while (std::getline(iss, field, '|')) {
+            fields.push_back(field);
+        }
+        return fields;
+    }
+    
+    // std::getline that also takes the '\r' of a CRLF line ending off
+    bool readLine(std::istream& in, std::string& line) {
+        if (!std::getline(in, line)) return false;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+    }
+    
+    // Splits "keyword rest of line" into its two parts
+    std::string splitDirective(const std::string& line, std::string& rest) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos) {
+            rest.clear();
+            return line;
+        }
+        rest = line.substr(space + 1);
+        return line.substr(0, space);
+    }
+    
+    // Without surrounding blanks, including a CRLF file's '\r'
+    std::string trimBlanks(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return "";
+        return text.substr(first, text.find_last_not_of(" \t\r") + 1 - first);
+    }
+    
+    bool isSkippable(const std::string& line) {
+        return line.empty() || line[0] == '#';
+    }
+}
+
+WorldFile::WorldFile(const std::string& filePath, size_t roomsPerRegion)
+    : path(filePath), stream(filePath, std::ios::binary), startRoomId(-1),
+      itemNames(std::make_shared<SpellingIndex>()), scripts(std::make_shared<ScriptBook>()) {
+    if (!stream) {
+        throw std::runtime_error("Cannot open world file: " + filePath);
+    }
+    std::vector<std::string> textSamples;
+    buildIndex(textSamples);
+    textStore = std::make_shared<TextStore>(TextStore::trainDictionary(textSamples));
+    partitionRegions(std::max<size_t>(roomsPerRegion, 1));
+}
+
+void WorldFile::parseError(const std::string& message, size_t lineNumber) const {
+    throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": " + message);
+}
+
+int WorldFile::parseNumber(const std::string& text, const std::string& what, size_t lineNumber) const {
+    // Surrounding blanks (and a CRLF file's '\r') are allowed, anything else is not
+    size_t first = text.find_first_not_of(" \t\r");
+    size_t last = text.find_last_not_of(" \t\r");
+    const char* begin = text.data() + (first == std::string::npos ? text.size() : first);
+    const char* end = text.data() + (last == std::string::npos ? text.size() : last + 1);
+    int value = 0;
+    auto result = std::from_chars(begin, end, value);
+    if (begin == end || result.ec != std::errc() || result.ptr != end) {
+        parseError(what + " '" + text + "' is not a number", lineNumber);
+    }
+    return value;
+}
+
+void WorldFile::buildIndex(std::vector<std::string>& textSamples) {
+    std::string line, rest;
+    size_t lineNumber = 0;
+    size_t sampledBytes = 0;
+    auto sample = [&](const std::string& text) {
+        if (sampledBytes < TEXT_SAMPLE_BYTES && !text.empty()) {
+            sampledBytes += text.size();
+            textSamples.push_back(text);
+        }
+    };
+    RoomIndex* current = nullptr;
+    int firstRoomId = -1;
+    int lastRoomId = -1;
+    std::string lastItemName; // of the current room, for on directives
+    
+    std::streamoff offset = stream.tellg();
+    while (readLine(stream, line)) {
+        ++lineNumber;
+        std::streamoff lineOffset = offset;
+        offset = stream.tellg();
+        if (isSkippable(line)) continue;
+        
+        std::string keyword = splitDirective(line, rest);
+        if (keyword == "room") {
+            std::vector<std::string> fields = splitFields(rest);
+            if (fields.size() < 3) parseError("room needs id|name|description", lineNumber);
+            int roomId = parseNumber(fields[0], "room id", lineNumber);
+            if (index.count(roomId)) parseError("duplicate room " + fields[0], lineNumber);
+            current = &index[roomId];
+            lastRoomId = roomId;
+            current->offset = lineOffset;
+            current->region = -1;
+            if (firstRoomId == -1) firstRoomId = roomId;
+            if (fields.size() >= 4) sample(fields[3]);
+            lastItemName.clear();
+        } else if (keyword == "item") {
+            std::vector<std::string> fields = splitFields(rest);
+            if (!current || fields.size() < 2) parseError("item needs a room and type|name", lineNumber);
+            if (fields.size() >= 4 && !fields[3].empty()) parseNumber(fields[3], "item value", lineNumber);
+            ItemType type = ItemType::GENERIC;
+            try {
+                type = parseItemType(fields[0]);
+            } catch (const std::runtime_error& e) {
+                parseError(e.what(), lineNumber);
+            }
+            // Rooms load lazily, so anything loadRoom() would parse is checked here
+            bool numericParam = type == ItemType::WEAPON || type == ItemType::CONSUMABLE || type == ItemType::TREASURE;
+            if (numericParam && fields.size() >= 6 && !fields[5].empty()) {
+                parseNumber(fields[5], fields[0] + " parameter", lineNumber);
+            }
+            itemNames->add(fields[1]);
+            lastItemName = fields[1];
+            if (fields.size() >= 3) sample(fields[2]);
+        } else if (keyword == "exit") {
+            std::vector<std::string> fields = splitFields(rest);
+            if (!current || fields.size() != 2) parseError("exit needs a room and direction|room id", lineNumber);
+            current->neighbours.push_back(parseNumber(fields[1], "exit target", lineNumber));
+        } else if (keyword == "creature") {
+            std::vector<std::string> fields = splitFields(rest);
+            if (!current || fields.size() != 5) parseError("creature needs name|health|damage|period|aggression", lineNumber);
+            auto known = std::find_if(species.begin(), species.end(),
+                [&fields](const CreatureSpecies& kind) { return kind.name == fields[0]; });
+            if (known == species.end()) {
+                species.push_back({fields[0], parseNumber(fields[1], "creature health", lineNumber),
+                                   parseNumber(fields[2], "creature damage", lineNumber),
+                                   parseNumber(fields[3], "creature period", lineNumber),
+                                   parseNumber(fields[4], "creature aggression", lineNumber)});
+                known = species.end() - 1;
+            }
+            creatureSpawns.emplace_back(lastRoomId, static_cast<int>(known - species.begin()));
+        } else if (keyword == "hazard") {
+            std::vector<std::string> fields = splitFields(rest);
+            if (!current || fields.size() != 4) parseError("hazard needs name|message|damage|period", lineNumber);
+            auto known = std::find_if(hazardKinds.begin(), hazardKinds.end(),
+                [&fields](const HazardKind& kind) { return kind.name == fields[0]; });
+            if (known == hazardKinds.end()) {
+                hazardKinds.push_back({fields[0], fields[1], parseNumber(fields[2], "hazard damage", lineNumber),
+                                       parseNumber(fields[3], "hazard period", lineNumber)});
+                known = hazardKinds.end() - 1;
+            }
+            hazardSpawns.emplace_back(lastRoomId, static_cast<int>(known - hazardKinds.begin()));
+        } else if (keyword == "on") {
+            size_t separator = rest.find('|');
+            ScriptEvent event;
+            if (!current || separator == std::string::npos || !parseScriptEvent(rest.substr(0, separator), event)) {
+                parseError("on needs a room and use|take|enter|examine followed by |script", lineNumber);
+            }
+            Script script = [&] {
+                try {
+                    return Script::compile(std::string_view(rest).substr(separator + 1));
+                } catch (const std::runtime_error& e) {
+                    parseError(e.what(), lineNumber);
+                }
+            }();
+            if (event == ScriptEvent::ENTER) {
+                scripts->addEnterScript(lastRoomId, std::move(script));
+            } else if (lastItemName.empty()) {
+                parseError("on " + rest.substr(0, separator) + " must follow an item", lineNumber);
+            } else {
+                scripts->addItemScript(event, lastItemName, std::move(script));
+            }
+        } else if (keyword == "start") {
+            startRoomId = parseNumber(rest, "start room", lineNumber);
+        } else if (keyword == "lock") {
+            if (!current) parseError("lock needs a room", lineNumber);
+            current->locked = true;
+        } else {
+            parseError("unknown directive '" + keyword + "'", lineNumber);
+        }
+    }
+    
+    if (index.empty()) {
+        throw std::runtime_error(path + ": world has no rooms");
+    }
+    if (startRoomId == -1) {
+        startRoomId = firstRoomId;
+    }
+    if (!hasRoom(startRoomId)) {
+        throw std::runtime_error(path + ": start room " + std::to_string(startRoomId) + " does not exist");
+    }
+    stream.clear();
+}
+
+void WorldFile::partitionRegions(size_t roomsPerRegion) {
+    // Grow each region breadth-first along exits so that neighbouring rooms
+    // share a region and a walk through the world touches few regions.
+    std::vector<int> roomIds;
+    roomIds.reserve(index.size());
+    for (const auto& entry : index) {
+        roomIds.push_back(entry.first);
+    }
+    std::sort(roomIds.begin(), roomIds.end());
+    
+    for (int seed : roomIds) {
+        if (index[seed].region != -1) continue;
+        
+        int regionId = static_cast<int>(regions.size());
+        regions.emplace_back();
+        std::vector<int>& members = regions.back();
+        std::queue<int> frontier;
+        frontier.push(seed);
+        index[seed].region = regionId;
+        
+        while (!frontier.empty() && members.size() < roomsPerRegion) {
+            int roomId = frontier.front();
+            frontier.pop();
+            members.push_back(roomId);
+            for (int next : index[roomId].neighbours) {
+                auto it = index.find(next);
+                if (it != index.end() && it->second.region == -1 &&
+                    members.size() + frontier.size() < roomsPerRegion) {
+                    it->second.region = regionId;
+                    frontier.push(next);
+                }
+            }
+        }
+    }
+}
+
+int WorldFile::getRegion(int roomId) const {
+    auto it = index.find(roomId);
+    return (it != index.end()) ? it->second.region : -1;
+}
+
+bool WorldFile::isLocked(int roomId) const {
+    auto it = index.find(roomId);
+    return it != index.end() && it->second.locked;
+}
+
+const std::vector<int>& WorldFile::getNeighbours(int roomId) const {
+    static const std::vector<int> none;
+    auto it = index.find(roomId);
+    return (it != index.end()) ? it->second.neighbours : none;
+}
+
+std::unique_ptr<Room> WorldFile::loadRoom(int roomId) {
+    auto it = index.find(roomId);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    
+    stream.clear();
+    stream.seekg(it->second.offset);
+    
+    // The first load of a room compresses its descriptions into the store;
+    // later loads reuse the stored ids in the same order.
+    RoomIndex& entry = it->second;
+    size_t nextText = 0;
+    auto storedText = [&](const std::string& text) {
+        if (!entry.textsStored) {
+            entry.texts.push_back(textStore->add(text));
+        }
+        return Text(textStore, entry.texts.at(nextText++));
+    };
+    
+    std::string line, rest;
+    readLine(stream, line);
+    std::vector<std::string> fields = splitFields(splitDirective(line, rest) == "room" ? rest : "");
+    std::unique_ptr<Room> room = std::make_unique<Room>(roomId, fields.at(1), fields.at(2));
+    if (fields.size() >= 4 && !fields[3].empty()) {
+        room->setLongDescription(storedText(fields[3]));
+    }
+    
+    while (readLine(stream, line)) {
+        if (isSkippable(line)) continue;
+        std::string keyword = splitDirective(line, rest);
+        if (keyword == "room") break;
+        
+        if (keyword == "exit") {
+            fields = splitFields(rest);
+            room->addExit(fields[0], std::stoi(fields[1]));
+        } else if (keyword == "lock") {
+            room->setLocked(true);
+            room->setUnlockKey(trimBlanks(rest));
+        } else if (keyword == "item") {
+            fields = splitFields(rest);
+            fields.resize(6);
+            std::unique_ptr<Item> item = createItem(parseItemType(fields[0]), fields[1], "", fields[5]);
+            if (!fields[2].empty()) {
+                item->setDescription(storedText(fields[2]));
+            }
+            item->setCanTake(fields[4].find('t') != std::string::npos);
+            item->setCanUse(fields[4].find('u') != std::string::npos);
+            if (!fields[3].empty()) {
+                item->setValue(std::stoi(fields[3]));
+            }
+            room->addItem(std::move(item));
+        }
+    }
+    
+    entry.textsStored = true;
+    room->clearModified();
+    return room;
+}
+
+
+void WorldFile::populate(WorldSimulation& simulation) const {
+    std::vector<int> speciesIds, hazardIds;
+    for (const CreatureSpecies& kind : species) {
+        speciesIds.push_back(simulation.addSpecies(kind));
+    }
+    for (const HazardKind& kind : hazardKinds) {
+        hazardIds.push_back(simulation.addHazardKind(kind));
+    }
+    for (const auto& spawn : creatureSpawns) {
+        simulation.spawnCreature(speciesIds[spawn.second], spawn.first);
+    }
+    for (const auto& spawn : hazardSpawns) {
+        simulation.spawnHazard(hazardIds[spawn.second], spawn.first);
+    }
+}
\ No newline at end of file
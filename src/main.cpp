@@ -1,7 +1,34 @@
+#include <algorithm>
 #include <iostream>
-#include <cstdlib>
-#include <ctime>
+#include <random>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
 #include "Game.h"
+#include "Protocol.h"
+#include "Server.h"
+#include "SharedWorld.h"
+#include "Trace.h"
+#include "WorldAnalyzer.h"
+#include <csignal>
+
+namespace {
+    GameServer* runningServer = nullptr;
+    
+    void stopServer(int) {
+        if (runningServer) {
+            runningServer->stop();
+        }
+    }
+    
+    void requestServerStats(int) {
+        if (runningServer) {
+            runningServer->requestStats();
+        }
+    }
+}
 
 void displayTitle() {
     std::cout << "\n";
@@ -27,22 +54,195 @@ void displayIntro() {
     std::cout << "\n";
 }
 
-int main() {
-    // Seed random number generator
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+// Plays many players in one shared world. Each input line is
+// "<player>: <command>"; a player joins the first time its name appears,
+// and every reply is printed as it arrives, prefixed with "[<player>]".
+void runSharedWorld(const std::string& worldPath, int workerCount) {
+    WorldFile worldFile(worldPath);
+    SharedWorld world(worldFile, workerCount);
+    std::mutex outputMutex;
+    std::map<std::string, PlayerActor*> players;
     
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos || colon == 0) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << "Lines are <player>: <command>\n";
+            continue;
+        }
+        std::string name = line.substr(0, colon);
+        PlayerActor*& player = players[name];
+        if (!player) {
+            player = world.addPlayer(name, [&outputMutex, name](const std::string& text) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << "[" << name << "] " << text << "\n";
+            });
+        }
+        world.submit(player, line.substr(colon + 1));
+    }
+    world.waitForQuiescence();
+    std::cout << std::flush;
+}
+
+int main(int argc, char* argv[]) {
     try {
+        // Optional world file: --world <path> [--region-budget <bytes>]
+        // Machine clients: --json [--name <player name>]
+        // High scores: --leaderboard <file>; gameplay statistics: --analytics <file>
+        // Server: --listen <socket path> [--workers <n>] [--pool <games>]
+        //         [--hibernate-after <seconds>] [--spill <file prefix>]
+        //         [--control <socket path>] (admin and migration, see tools/drain.cpp)
+        //         [--spectate <socket path>] (read-only watchers of live sessions)
+        // Span tracing: --trace <file> [--trace-sample <fraction of commands>]
+        // Random numbers: --seed <n> (default: a fresh one); a game replays from its seed and commands
+        // Check a world file and exit: --check <world file> [--workers <threads>]
+        // Many players in one world, "<player>: <command>" per line: --shared <world file> [--workers <threads>]
+        std::string worldPath;
+        std::string leaderboardPath;
+        std::string analyticsPath;
+        std::string playerName;
+        std::string listenPath;
+        int workerCount = 0;
+        size_t poolSize = 64;
+        double hibernateAfter = 0;
+        std::string spillPath;
+        std::string tracePath;
+        std::string controlPath;
+        std::string spectatePath;
+        std::string checkPath;
+        std::string sharedPath;
+        std::optional<uint64_t> seed;
+        double traceSample = 1.0;
+        size_t regionBudget = 8 * 1024 * 1024;
+        bool jsonProtocol = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--world" && i + 1 < argc) {
+                worldPath = argv[++i];
+            } else if (arg == "--region-budget" && i + 1 < argc) {
+                regionBudget = std::stoul(argv[++i]);
+            } else if (arg == "--json") {
+                jsonProtocol = true;
+            } else if (arg == "--name" && i + 1 < argc) {
+                playerName = argv[++i];
+            } else if (arg == "--leaderboard" && i + 1 < argc) {
+                leaderboardPath = argv[++i];
+            } else if (arg == "--analytics" && i + 1 < argc) {
+                analyticsPath = argv[++i];
+            } else if (arg == "--listen" && i + 1 < argc) {
+                listenPath = argv[++i];
+            } else if (arg == "--workers" && i + 1 < argc) {
+                workerCount = std::stoi(argv[++i]);
+            } else if (arg == "--pool" && i + 1 < argc) {
+                poolSize = std::stoul(argv[++i]);
+            } else if (arg == "--hibernate-after" && i + 1 < argc) {
+                hibernateAfter = std::stod(argv[++i]);
+            } else if (arg == "--spill" && i + 1 < argc) {
+                spillPath = argv[++i];
+            } else if (arg == "--control" && i + 1 < argc) {
+                controlPath = argv[++i];
+            } else if (arg == "--spectate" && i + 1 < argc) {
+                spectatePath = argv[++i];
+            } else if (arg == "--seed" && i + 1 < argc) {
+                seed = std::stoull(argv[++i]);
+            } else if (arg == "--check" && i + 1 < argc) {
+                checkPath = argv[++i];
+            } else if (arg == "--shared" && i + 1 < argc) {
+                sharedPath = argv[++i];
+            } else if (arg == "--trace" && i + 1 < argc) {
+                tracePath = argv[++i];
+            } else if (arg == "--trace-sample" && i + 1 < argc) {
+                traceSample = std::stod(argv[++i]);
+            }
+        }
+        
+        if (!checkPath.empty()) {
+            WorldAnalyzer analyzer(checkPath, static_cast<unsigned>(std::max(workerCount, 0)));
+            analyzer.print(std::cout);
+            return analyzer.hasErrors() ? 1 : 0;
+        }
+        
+        if (!sharedPath.empty()) {
+            runSharedWorld(sharedPath, workerCount);
+            return 0;
+        }
+        
+        if (!tracePath.empty()) {
+            Tracer::setSampleRate(traceSample);
+        }
+        if (!seed) {
+            std::random_device device;
+            seed = (static_cast<uint64_t>(device()) << 32) | device();
+        }
+        
+        Leaderboard leaderboard(leaderboardPath);
+        std::unique_ptr<Analytics> analytics;
+        if (!analyticsPath.empty()) {
+            analytics = std::make_unique<Analytics>(analyticsPath);
+        }
+        
+        if (!listenPath.empty()) {
+            if (!worldPath.empty()) {
+                throw std::runtime_error("--listen serves the built-in island; it cannot be combined with --world");
+            }
+            SessionPool pool(poolSize, poolSize * 16);
+            GameServer server(listenPath, pool, &leaderboard, analytics.get());
+            if (hibernateAfter > 0) {
+                server.setHibernation(hibernateAfter, spillPath);
+            }
+            server.setTraceFile(tracePath);
+            server.setSeed(*seed);
+            if (!controlPath.empty()) {
+                server.setControlSocket(controlPath);
+            }
+            if (!spectatePath.empty()) {
+                server.setSpectatorSocket(spectatePath);
+            }
+            runningServer = &server;
+            std::signal(SIGINT, stopServer);
+            std::signal(SIGTERM, stopServer);
+            std::signal(SIGUSR1, requestServerStats);
+            std::cerr << "Serving on " << listenPath << " (seed " << *seed << ", server id " << server.getServerId() << ")\n";
+            server.run(workerCount);
+            server.printStats(std::cerr);
+            runningServer = nullptr;
+            if (!tracePath.empty()) {
+                Tracer::exportFile(tracePath);
+            }
+            return 0;
+        }
+        
+        std::unique_ptr<Game> game = worldPath.empty()
+            ? std::make_unique<Game>()
+            : std::make_unique<Game>(worldPath, regionBudget);
+        game->setLeaderboard(&leaderboard);
+        game->setAnalytics(analytics.get());
+        game->setSeed(*seed);
+        
+        if (jsonProtocol) {
+            std::ios::sync_with_stdio(false);
+            game->begin(playerName);
+            runJsonProtocol(*game, std::cin, std::cout);
+            if (!tracePath.empty()) {
+                Tracer::exportFile(tracePath);
+            }
+            return 0;
+        }
+        
         displayTitle();
         displayIntro();
         
-        // Create and start the game
-        Game game;
-        game.startGame();
+        // Start the game
+        game->startGame();
+        if (!tracePath.empty()) {
+            Tracer::exportFile(tracePath);
+        }
         
         std::cout << "\nThank you for playing Journey of the Forgotten Island!\n";
         std::cout << "Press Enter to exit...";
         std::cin.get();
-        
+    
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
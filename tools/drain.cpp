@@ -0,0 +1,144 @@
+// Drains game servers (forgotten_island --listen <path> --control <path>)
+// into another one: every session, client connection included, moves to
+// the target server without the client noticing. Each source server moves
+// its sessions on all of its workers in parallel; several sources are
+// drained concurrently.
+//
+//   drain --to <target control socket> --from <control socket> [--from ...] [--stop]
+//   drain --stats <control socket>
+//
+// --stop shuts each source down once it has been drained.
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    const int REPLY_TIMEOUT_SECONDS = 60;
+    const size_t MAX_REPLY = 64 * 1024;
+    
+    std::mutex outputMutex;
+    
+    // A connection to a control socket; commands and replies are single packets
+    class ControlConnection {
+    private:
+        int fd;
+        std::string path;
+    
+    public:
+        explicit ControlConnection(const std::string& socketPath) : fd(-1), path(socketPath) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Socket path too long: " + path);
+            }
+            std::strcpy(address.sun_path, path.c_str());
+            fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+            }
+            timeval timeout{};
+            timeout.tv_sec = REPLY_TIMEOUT_SECONDS;
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+                std::string error = std::strerror(errno);
+                close(fd);
+                throw std::runtime_error("Cannot connect to " + path + ": " + error);
+            }
+        }
+        
+        ~ControlConnection() { close(fd); }
+        
+        ControlConnection(const ControlConnection&) = delete;
+        ControlConnection& operator=(const ControlConnection&) = delete;
+        
+        std::string request(const std::string& command) {
+            if (send(fd, command.data(), command.size(), MSG_NOSIGNAL) < 0) {
+                throw std::runtime_error(path + ": " + std::strerror(errno));
+            }
+            std::string reply(MAX_REPLY, '\0');
+            ssize_t received = recv(fd, reply.data(), reply.size(), 0);
+            if (received <= 0) {
+                throw std::runtime_error(path + ": " + (received == 0 ? "connection closed" : std::strerror(errno)));
+            }
+            reply.resize(static_cast<size_t>(received));
+            while (!reply.empty() && reply.back() == '\n') {
+                reply.pop_back();
+            }
+            return reply;
+        }
+    };
+    
+    bool drainOne(const std::string& source, const std::string& target, bool stopAfter) {
+        try {
+            ControlConnection control(source);
+            std::string reply = control.request("drain " + target);
+            if (stopAfter && reply.rfind("error", 0) != 0) {
+                control.request("stop");
+            }
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << source << ": " << reply << (stopAfter ? ", stopped" : "") << "\n";
+            return reply.rfind("error", 0) != 0;
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cerr << source << ": " << e.what() << "\n";
+            return false;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string target;
+    std::string statsPath;
+    std::vector<std::string> sources;
+    bool stopAfter = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--to" && hasValue) target = argv[++i];
+        else if (arg == "--from" && hasValue) sources.push_back(argv[++i]);
+        else if (arg == "--stats" && hasValue) statsPath = argv[++i];
+        else if (arg == "--stop") stopAfter = true;
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    
+    if (!statsPath.empty()) {
+        try {
+            ControlConnection control(statsPath);
+            std::cout << control.request("stats") << "\n";
+            return 0;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (target.empty() || sources.empty()) {
+        std::cerr << "Usage: drain --to <target control socket> --from <control socket> [--from ...] [--stop]\n"
+                  << "       drain --stats <control socket>\n";
+        return 1;
+    }
+    
+    std::vector<std::thread> threads;
+    std::vector<char> succeeded(sources.size(), 0);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        threads.emplace_back([&, i] { succeeded[i] = drainOne(sources[i], target, stopAfter); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (char ok : succeeded) {
+        if (!ok) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,475 @@
+// Load generator for the game server (forgotten_island --listen <path>).
+//
+// Opens many client connections and drives each with a policy built from
+// the game's own verbs. Requests are paced open-loop: every connection has
+// a schedule of intended send times (think time apart) that does not wait
+// for replies, and latency is measured from the intended time. A stalled
+// server therefore shows up as tail latency instead of as fewer requests
+// (coordinated omission).
+//
+//   loadgen --socket /tmp/island.sock [--connections 1000] [--duration 10]
+//           [--think-ms 1000] [--think exp|fixed] [--policy random|script]
+//           [--script file] [--seed 1]
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        std::string socketPath;
+        int connections = 100;
+        double durationSeconds = 10;
+        double thinkMs = 1000;
+        bool exponentialThink = true;
+        bool scripted = false;
+        std::vector<std::string> script;
+        unsigned seed = 1;
+    };
+    
+    // Log-linear latency histogram in microseconds (about 3% resolution)
+    class Histogram {
+    private:
+        static constexpr int SUB_BITS = 5;
+        static constexpr uint64_t SUB = 1u << SUB_BITS;
+        std::vector<uint64_t> buckets;
+        uint64_t total = 0;
+        uint64_t maxValue = 0;
+        
+        static size_t indexOf(uint64_t value) {
+            if (value < 2 * SUB) return static_cast<size_t>(value);
+            int msb = 63 - __builtin_clzll(value);
+            int shift = msb - SUB_BITS;
+            return static_cast<size_t>(2 * SUB + (shift - 1) * SUB + ((value >> shift) - SUB));
+        }
+        
+        static uint64_t valueOf(size_t index) {
+            if (index < 2 * SUB) return index;
+            size_t shift = (index - 2 * SUB) / SUB + 1;
+            return (SUB + (index - 2 * SUB) % SUB) << shift;
+        }
+    
+    public:
+        Histogram() : buckets(indexOf(UINT64_C(1) << 40) + 1, 0) {}
+        
+        void record(uint64_t value) {
+            value = std::min(value, UINT64_C(1) << 40);
+            ++buckets[indexOf(value)];
+            ++total;
+            maxValue = std::max(maxValue, value);
+        }
+        
+        uint64_t percentile(double p) const {
+            uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                seen += buckets[i];
+                if (seen >= std::max<uint64_t>(rank, 1)) return valueOf(i);
+            }
+            return maxValue;
+        }
+        
+        uint64_t count() const { return total; }
+        uint64_t max() const { return maxValue; }
+    };
+    
+    struct Client {
+        int fd = -1;
+        bool connected = false;
+        std::string input;
+        std::string output;
+        std::deque<Clock::time_point> outstanding; // intended send times, in reply order
+        Clock::time_point nextSend;
+        long long nextId = 1;
+        size_t scriptStep = 0;
+        std::vector<std::string> roomItems;
+        std::vector<std::string> inventory;
+        bool gameOver = false;
+    };
+    
+    struct Stats {
+        uint64_t sent = 0;
+        uint64_t replies = 0;
+        uint64_t connectErrors = 0;
+        uint64_t lostReplies = 0; // connection dropped with requests in flight
+        uint64_t afterGameOver = 0; // pipelined past the end of a game; never answered
+        uint64_t sessions = 0;
+        std::map<std::string, uint64_t> statuses;
+        Histogram latency;
+    };
+    
+    const char* DIRECTIONS[] = {"north", "south", "east", "west", "up", "down"};
+    const char* CREATURES[] = {"boar", "bats", "guardian"};
+    const char* DEFAULT_SCRIPT[] = {
+        "take seashell", "west", "west", "take rusty key", "north",
+        "take temple key", "north", "east", "take ancient treasure"
+    };
+    
+    // Values of a JSON string array field, e.g. "inventory":["a","b"]
+    std::vector<std::string> stringArray(const std::string& reply, const std::string& key) {
+        std::vector<std::string> values;
+        size_t pos = reply.find("\"" + key + "\":[");
+        if (pos == std::string::npos) return values;
+        pos += key.size() + 4;
+        while (pos < reply.size() && reply[pos] == '"') {
+            size_t end = reply.find('"', pos + 1);
+            if (end == std::string::npos) break;
+            values.push_back(reply.substr(pos + 1, end - pos - 1));
+            pos = end + 1;
+            if (pos < reply.size() && reply[pos] == ',') ++pos;
+        }
+        return values;
+    }
+    
+    std::string stringField(const std::string& reply, const std::string& key) {
+        size_t pos = reply.find("\"" + key + "\":\"");
+        if (pos == std::string::npos) return "";
+        pos += key.size() + 4;
+        size_t end = reply.find('"', pos);
+        return end == std::string::npos ? "" : reply.substr(pos, end - pos);
+    }
+    
+    class LoadGenerator {
+    private:
+        Options options;
+        std::vector<Client> clients;
+        Stats stats;
+        std::mt19937_64 rng;
+        int epollFd;
+        Clock::time_point startTime;
+        
+        using Timer = std::pair<Clock::time_point, size_t>;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+        
+        Clock::duration thinkTime() {
+            double ms = options.thinkMs;
+            if (options.exponentialThink) {
+                ms = std::exponential_distribution<double>(1.0 / options.thinkMs)(rng);
+            }
+            return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+        }
+        
+        template <size_t N>
+        const char* pick(const char* (&choices)[N]) {
+            return choices[rng() % N];
+        }
+        
+        const std::string& pick(const std::vector<std::string>& choices) {
+            return choices[rng() % choices.size()];
+        }
+        
+        std::string nextCommand(Client& client) {
+            if (options.scripted) {
+                const std::string& command = options.script[client.scriptStep % options.script.size()];
+                ++client.scriptStep;
+                return command;
+            }
+            // Random walk weighted towards moving and picking things up
+            int roll = static_cast<int>(rng() % 100);
+            if (roll < 45) return pick(DIRECTIONS);
+            if (roll < 60 && !client.roomItems.empty()) return "take " + pick(client.roomItems);
+            if (roll < 68) return "look";
+            if (roll < 72) return "inventory";
+            if (roll < 76) return "status";
+            if (roll < 82 && !client.inventory.empty()) return "examine " + pick(client.inventory);
+            if (roll < 88 && !client.inventory.empty()) return "use " + pick(client.inventory);
+            if (roll < 92 && !client.inventory.empty()) return "drop " + pick(client.inventory);
+            if (roll < 97) return std::string("attack ") + pick(CREATURES);
+            return pick(DIRECTIONS);
+        }
+        
+        void connectClient(Client& client) {
+            client.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+            if (client.fd < 0 ||
+                connect(client.fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+                // Backlog full or server gone: retry on the next send
+                ++stats.connectErrors;
+                if (client.fd >= 0) close(client.fd);
+                client.fd = -1;
+                return;
+            }
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = static_cast<uint64_t>(&client - clients.data());
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+            client.connected = true;
+            client.gameOver = false;
+            client.scriptStep = 0;
+            client.roomItems.clear();
+            client.inventory.clear();
+            ++stats.sessions;
+        }
+        
+        void disconnect(Client& client) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+            close(client.fd);
+            client.fd = -1;
+            client.connected = false;
+            client.input.clear();
+            client.output.clear();
+            if (client.gameOver) {
+                stats.afterGameOver += client.outstanding.size();
+            } else {
+                stats.lostReplies += client.outstanding.size();
+            }
+            client.outstanding.clear();
+        }
+        
+        void writePending(Client& client) {
+            while (!client.output.empty()) {
+                ssize_t written = send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+                if (written < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        epoll_event event{};
+                        event.events = EPOLLIN | EPOLLOUT;
+                        event.data.u64 = static_cast<uint64_t>(&client - clients.data());
+                        epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+                    } else {
+                        disconnect(client);
+                    }
+                    return;
+                }
+                client.output.erase(0, static_cast<size_t>(written));
+            }
+        }
+        
+        void sendRequest(Client& client, Clock::time_point intended) {
+            if (client.gameOver && client.connected) {
+                return; // the server is closing this session; wait for it
+            }
+            if (!client.connected) {
+                connectClient(client);
+                if (!client.connected) return;
+            }
+            std::string command = nextCommand(client);
+            client.output += "{\"id\":" + std::to_string(client.nextId++) + ",\"cmd\":\"" + command + "\"}\n";
+            client.outstanding.push_back(intended);
+            ++stats.sent;
+            writePending(client);
+        }
+        
+        void handleReply(Client& client, const std::string& reply, Clock::time_point now) {
+            if (client.outstanding.empty()) return;
+            Clock::time_point intended = client.outstanding.front();
+            client.outstanding.pop_front();
+            ++stats.replies;
+            if (now > startTime) {
+                stats.latency.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - intended).count()));
+            }
+            ++stats.statuses[stringField(reply, "status")];
+            client.roomItems = stringArray(reply, "room_items");
+            client.inventory = stringArray(reply, "inventory");
+            if (reply.find("\"running\":false") != std::string::npos) {
+                client.gameOver = true;
+            }
+        }
+        
+        void handleReadable(Client& client) {
+            char chunk[16 * 1024];
+            while (true) {
+                ssize_t received = read(client.fd, chunk, sizeof(chunk));
+                if (received > 0) {
+                    client.input.append(chunk, static_cast<size_t>(received));
+                    continue;
+                }
+                if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                // Closed by the server: the game ended or it failed
+                Clock::time_point now = Clock::now();
+                processInput(client, now);
+                disconnect(client);
+                return;
+            }
+            processInput(client, Clock::now());
+        }
+        
+        void processInput(Client& client, Clock::time_point now) {
+            size_t start = 0;
+            size_t newline;
+            while ((newline = client.input.find('\n', start)) != std::string::npos) {
+                handleReply(client, client.input.substr(start, newline - start), now);
+                start = newline + 1;
+            }
+            client.input.erase(0, start);
+        }
+    
+    public:
+        explicit LoadGenerator(const Options& opts)
+            : options(opts), clients(static_cast<size_t>(opts.connections)), rng(opts.seed) {
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+        }
+        
+        ~LoadGenerator() {
+            for (Client& client : clients) {
+                if (client.fd >= 0) close(client.fd);
+            }
+            close(epollFd);
+        }
+        
+        void run() {
+            startTime = Clock::now();
+            // Spread the first requests over one think time so clients do not arrive in lockstep
+            for (size_t i = 0; i < clients.size(); ++i) {
+                std::uniform_real_distribution<double> offset(0.0, options.thinkMs);
+                clients[i].nextSend = startTime + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::milli>(offset(rng)));
+                timers.push({clients[i].nextSend, i});
+            }
+            Clock::time_point endTime = startTime + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(options.durationSeconds));
+            Clock::time_point drainDeadline = endTime + std::chrono::seconds(2);
+            
+            std::vector<epoll_event> events(1024);
+            while (true) {
+                Clock::time_point now = Clock::now();
+                
+                // Fire every send whose intended time has come, even if earlier replies are missing
+                while (!timers.empty() && timers.top().first <= now && now < endTime) {
+                    Timer timer = timers.top();
+                    timers.pop();
+                    Client& client = clients[timer.second];
+                    sendRequest(client, timer.first);
+                    client.nextSend = timer.first + thinkTime();
+                    timers.push({client.nextSend, timer.second});
+                }
+                
+                bool sending = now < endTime;
+                if (!sending) {
+                    bool pending = std::any_of(clients.begin(), clients.end(),
+                                               [](const Client& c) { return c.connected && !c.outstanding.empty(); });
+                    if (!pending || now >= drainDeadline) break;
+                }
+                
+                int timeoutMs = 100;
+                if (sending && !timers.empty()) {
+                    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(timers.top().first - now);
+                    timeoutMs = static_cast<int>(std::clamp<long long>(wait.count(), 0, 100));
+                }
+                int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeoutMs);
+                for (int i = 0; i < ready; ++i) {
+                    Client& client = clients[events[i].data.u64];
+                    if (client.fd < 0) continue;
+                    if (events[i].events & EPOLLOUT) {
+                        writePending(client);
+                        if (client.fd >= 0 && client.output.empty()) {
+                            epoll_event event{};
+                            event.events = EPOLLIN;
+                            event.data.u64 = events[i].data.u64;
+                            epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+                        }
+                    }
+                    if (client.fd >= 0 && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                        handleReadable(client);
+                    }
+                }
+            }
+            
+            double elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+            report(elapsed);
+        }
+        
+        void report(double elapsed) const {
+            uint64_t timedOut = 0;
+            for (const Client& client : clients) {
+                timedOut += client.outstanding.size();
+            }
+            uint64_t transportErrors = stats.connectErrors + stats.lostReplies + timedOut;
+            uint64_t ok = stats.statuses.count("ok") ? stats.statuses.at("ok") : 0;
+            double target = options.connections * 1000.0 / options.thinkMs;
+            
+            std::cout << "connections " << options.connections << ", " << elapsed << " s, "
+                      << "target rate " << target << " req/s\n";
+            std::cout << "requests " << stats.sent << ", replies " << stats.replies
+                      << ", throughput " << stats.replies / elapsed << " replies/s"
+                      << ", sessions " << stats.sessions
+                      << ", sent after game over " << stats.afterGameOver << "\n";
+            std::cout << "latency us (from intended send): p50 " << stats.latency.percentile(50)
+                      << "  p90 " << stats.latency.percentile(90)
+                      << "  p99 " << stats.latency.percentile(99)
+                      << "  p99.9 " << stats.latency.percentile(99.9)
+                      << "  max " << stats.latency.max() << "\n";
+            std::cout << "statuses:";
+            for (const auto& entry : stats.statuses) {
+                std::cout << " " << entry.first << "=" << entry.second;
+            }
+            std::cout << "\n";
+            std::cout << "command failure rate " << (stats.replies ? 100.0 * (stats.replies - ok) / stats.replies : 0.0)
+                      << "%, transport errors " << transportErrors
+                      << " (connect " << stats.connectErrors << ", lost " << stats.lostReplies
+                      << ", timed out " << timedOut << "), error rate "
+                      << (stats.sent ? 100.0 * transportErrors / stats.sent : 0.0) << "%\n";
+        }
+    };
+    
+    void raiseFileLimit() {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::string scriptPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue) options.socketPath = argv[++i];
+        else if (arg == "--connections" && hasValue) options.connections = std::stoi(argv[++i]);
+        else if (arg == "--duration" && hasValue) options.durationSeconds = std::stod(argv[++i]);
+        else if (arg == "--think-ms" && hasValue) options.thinkMs = std::stod(argv[++i]);
+        else if (arg == "--think" && hasValue) options.exponentialThink = std::string(argv[++i]) != "fixed";
+        else if (arg == "--policy" && hasValue) options.scripted = std::string(argv[++i]) == "script";
+        else if (arg == "--script" && hasValue) scriptPath = argv[++i];
+        else if (arg == "--seed" && hasValue) options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    if (options.socketPath.empty() || options.connections <= 0 || options.thinkMs <= 0) {
+        std::cerr << "Usage: loadgen --socket <path> [--connections n] [--duration s] [--think-ms ms]\n"
+                  << "               [--think exp|fixed] [--policy random|script] [--script file] [--seed n]\n";
+        return 1;
+    }
+    
+    if (!scriptPath.empty()) {
+        std::ifstream file(scriptPath);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) options.script.push_back(line);
+        }
+        options.scripted = true;
+    }
+    if (options.script.empty()) {
+        options.script.assign(std::begin(DEFAULT_SCRIPT), std::end(DEFAULT_SCRIPT));
+    }
+    
+    raiseFileLimit();
+    LoadGenerator generator(options);
+    generator.run();
+    return 0;
+}
@@ -0,0 +1,539 @@
+// Monte Carlo playtesting for the built-in island.
+//
+// Plays many games in-process on every core, each driven by an agent
+// policy, and aggregates the outcomes: win, death and timeout rates, steps
+// to win, the score distribution and how often each item gets picked up.
+// Each thread keeps one Game and resets it to its pristine state between
+// runs; finished batches are merged into shared histograms as they come.
+// The world advances a fixed number of ticks per command and run <n> draws
+// from its own random streams, so any run replays exactly with --replay n.
+//
+//   playtest [--runs 100000] [--agent random|greedy|keys|all] [--threads n]
+//            [--max-steps 300] [--ticks 5] [--seed 1] [--replay <run>]
+//
+// Agents only see what a player sees (the room's exits, items and
+// creatures, and their inventory) and remember the map they have walked.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Game.h"
+#include "Random.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    const uint64_t BATCH_RUNS = 256;          // runs a thread takes and merges at a time
+    const uint64_t AGENT_STREAM_BIT = 1ull << 63; // agents draw from a different stream than the game
+    const int LOW_HEALTH = 40;
+    
+    struct Options {
+        uint64_t runs = 100000;
+        std::vector<std::string> agents{"random", "greedy", "keys"};
+        unsigned threads = 0;
+        int maxSteps = 300;
+        int ticks = 5;
+        uint64_t seed = 1;
+        int64_t replay = -1;
+    };
+    
+    // Discards game text without formatting cost beyond the stream calls
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+    };
+    
+    // What the player can see this turn
+    struct View {
+        int roomId;
+        std::vector<std::pair<std::string, int>> exits; // direction, room id
+        std::vector<const Item*> items;                 // lying in the room
+        std::vector<std::string> creatures;
+        const Player* player;
+        
+        bool hasWeapon() const { return player->getBestWeapon() != nullptr; }
+    };
+    
+    View look(Game& game) {
+        View view;
+        view.roomId = game.getCurrentRoomId();
+        view.player = game.getPlayer();
+        if (Room* room = game.getCurrentRoom()) {
+            for (const std::string& direction : room->getAvailableExits()) {
+                view.exits.emplace_back(direction, room->getExit(direction));
+            }
+            for (const auto& item : room->getItems()) {
+                view.items.push_back(item.get());
+            }
+        }
+        WorldSimulation& simulation = game.getSimulation();
+        for (int creature : simulation.livingCreatures(view.roomId)) {
+            view.creatures.push_back(simulation.getCreatureName(creature));
+        }
+        return view;
+    }
+    
+    class Agent {
+    public:
+        virtual ~Agent() = default;
+        virtual void reset() {}
+        virtual std::string choose(const View& view, Random& random) = 0;
+        virtual void observe(const View& before, const std::string& command, CommandStatus status) {
+            (void)before; (void)command; (void)status;
+        }
+    };
+    
+    // Any move, take, use or attack the room allows, uniformly
+    class RandomWalk : public Agent {
+    public:
+        std::string choose(const View& view, Random& random) override {
+            std::vector<std::string> options;
+            for (const auto& exit : view.exits) {
+                options.push_back("go " + exit.first);
+            }
+            for (const Item* item : view.items) {
+                if (item->getCanTake()) options.push_back("take " + item->getName());
+            }
+            for (const auto& item : view.player->getInventory()) {
+                if (item->getCanUse()) options.push_back("use " + item->getName());
+            }
+            for (const std::string& creature : view.creatures) {
+                options.push_back("attack " + creature);
+            }
+            if (options.empty()) return "look";
+            return options[random.below(static_cast<uint32_t>(options.size()))];
+        }
+    };
+    
+    // Remembers the rooms walked and the locks met, and heads for the least visited places
+    class Explorer : public Agent {
+    protected:
+        std::map<int, int> visits;
+        std::map<int, std::map<std::string, int>> exits;   // room -> direction -> room
+        std::map<std::pair<int, std::string>, size_t> locks; // exit -> keys carried when it refused
+        std::set<std::string> refused;                      // items that could not be taken
+        bool full = false;                                  // the last take found no room to carry it
+        
+        size_t keysCarried(const View& view) const {
+            return static_cast<size_t>(std::count_if(view.player->getInventory().begin(), view.player->getInventory().end(),
+                [](const auto& item) { return item->getType() == ItemType::KEY; }));
+        }
+        
+        bool blocked(const View& view, const std::string& direction) const {
+            auto lock = locks.find({view.roomId, direction});
+            return lock != locks.end() && lock->second >= keysCarried(view);
+        }
+        
+        // Towards the least visited neighbour; unseen rooms count as unvisited
+        std::string explore(const View& view, Random& random) const {
+            std::vector<std::string> best;
+            int fewest = INT32_MAX;
+            for (const auto& exit : view.exits) {
+                if (blocked(view, exit.first)) continue;
+                auto seen = visits.find(exit.second);
+                int count = seen == visits.end() ? 0 : seen->second;
+                if (count < fewest) {
+                    fewest = count;
+                    best.clear();
+                }
+                if (count == fewest) best.push_back(exit.first);
+            }
+            if (best.empty()) {
+                return view.exits.empty() ? "look" : "go " + view.exits[random.below(static_cast<uint32_t>(view.exits.size()))].first;
+            }
+            return "go " + best[random.below(static_cast<uint32_t>(best.size()))];
+        }
+        
+        std::string heal(const View& view) const {
+            if (view.player->getHealth() >= LOW_HEALTH) return "";
+            for (const auto& item : view.player->getInventory()) {
+                if (item->getType() == ItemType::CONSUMABLE && item->getCanUse()) return "use " + item->getName();
+            }
+            return "";
+        }
+    
+    public:
+        void reset() override {
+            visits.clear();
+            exits.clear();
+            locks.clear();
+            refused.clear();
+            full = false;
+        }
+        
+        void observe(const View& before, const std::string& command, CommandStatus status) override {
+            ++visits[before.roomId];
+            for (const auto& exit : before.exits) {
+                exits[before.roomId][exit.first] = exit.second;
+            }
+            if (command.rfind("go ", 0) == 0) {
+                if (status == CommandStatus::LOCKED) {
+                    locks[{before.roomId, command.substr(3)}] = keysCarried(before);
+                } else if (status == CommandStatus::OK) {
+                    locks.erase({before.roomId, command.substr(3)});
+                }
+            } else if (command.rfind("take ", 0) == 0) {
+                full = status == CommandStatus::INVENTORY_FULL;
+                if (status != CommandStatus::OK && !full) refused.insert(command.substr(5));
+            } else if (command.rfind("drop ", 0) == 0 && status == CommandStatus::OK) {
+                full = false;
+            }
+        }
+    };
+    
+    // Takes the most valuable item in reach, trading the cheapest one carried
+    // for it when the pack is full; fights when armed, else explores
+    class GreedyCollector : public Explorer {
+    public:
+        std::string choose(const View& view, Random& random) override {
+            std::string healing = heal(view);
+            if (!healing.empty()) return healing;
+            const Item* best = nullptr;
+            for (const Item* item : view.items) {
+                if (item->getCanTake() && !refused.count(item->getName()) &&
+                    (!best || item->getValue() > best->getValue())) {
+                    best = item;
+                }
+            }
+            if (best && full) {
+                const Item* cheapest = nullptr;
+                for (const auto& item : view.player->getInventory()) {
+                    if (!cheapest || item->getValue() < cheapest->getValue()) cheapest = item.get();
+                }
+                if (cheapest && cheapest->getValue() < best->getValue()) return "drop " + cheapest->getName();
+                refused.insert(best->getName());
+                full = false;
+                return choose(view, random);
+            }
+            if (best) return "take " + best->getName();
+            if (!view.creatures.empty() && view.hasWeapon()) return "attack " + view.creatures.front();
+            return explore(view, random);
+        }
+    };
+    
+    // Collects keys and treasure and walks back to locks it could not open
+    // once it carries a key it has not tried there
+    class KeySeeker : public Explorer {
+    private:
+        // First step of the shortest known path to a room with a retryable lock
+        std::string towardsLock(const View& view) const {
+            std::map<int, std::string> firstStep;
+            std::queue<int> frontier;
+            frontier.push(view.roomId);
+            firstStep[view.roomId] = "";
+            while (!frontier.empty()) {
+                int room = frontier.front();
+                frontier.pop();
+                for (const auto& lock : locks) {
+                    if (lock.first.first == room && lock.second < keysCarried(view)) {
+                        return room == view.roomId ? "go " + lock.first.second : firstStep[room];
+                    }
+                }
+                auto known = exits.find(room);
+                if (known == exits.end()) continue;
+                for (const auto& exit : known->second) {
+                    if (firstStep.count(exit.second) || locks.count({room, exit.first})) continue;
+                    firstStep[exit.second] = room == view.roomId ? "go " + exit.first : firstStep[room];
+                    frontier.push(exit.second);
+                }
+            }
+            return "";
+        }
+    
+    public:
+        std::string choose(const View& view, Random& random) override {
+            std::string healing = heal(view);
+            if (!healing.empty()) return healing;
+            for (const Item* item : view.items) {
+                ItemType type = item->getType();
+                if (item->getCanTake() && !refused.count(item->getName()) &&
+                    (type == ItemType::KEY || type == ItemType::TREASURE || type == ItemType::WEAPON)) {
+                    return "take " + item->getName();
+                }
+            }
+            std::string lock = towardsLock(view);
+            if (!lock.empty()) return lock;
+            return explore(view, random);
+        }
+    };
+    
+    std::unique_ptr<Agent> makeAgent(const std::string& name) {
+        if (name == "random") return std::make_unique<RandomWalk>();
+        if (name == "greedy") return std::make_unique<GreedyCollector>();
+        if (name == "keys") return std::make_unique<KeySeeker>();
+        throw std::runtime_error("Unknown agent: " + name);
+    }
+    
+    // Fixed-width buckets from zero, with one more for everything beyond
+    class Histogram {
+    private:
+        uint64_t width;
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t largest = 0;
+    
+    public:
+        Histogram(uint64_t bucketWidth, size_t bucketCount) : width(bucketWidth), buckets(bucketCount + 1, 0) {}
+        
+        void add(uint64_t value) {
+            ++buckets[std::min<uint64_t>(value / width, buckets.size() - 1)];
+            ++count;
+            sum += value;
+            largest = std::max(largest, value);
+        }
+        void merge(const Histogram& other) {
+            for (size_t i = 0; i < buckets.size(); ++i) buckets[i] += other.buckets[i];
+            count += other.count;
+            sum += other.sum;
+            largest = std::max(largest, other.largest);
+        }
+        void clear() {
+            std::fill(buckets.begin(), buckets.end(), 0);
+            count = sum = largest = 0;
+        }
+        
+        // The upper edge of the bucket holding the fraction-th value
+        uint64_t percentile(double fraction) const {
+            uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(count));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                seen += buckets[i];
+                if (seen > rank) return std::min(largest, (i + 1) * width - 1);
+            }
+            return largest;
+        }
+        
+        void printSummary(std::ostream& os) const {
+            if (count == 0) {
+                os << "none\n";
+                return;
+            }
+            os << "mean " << static_cast<double>(sum) / static_cast<double>(count) << ", p10 " << percentile(0.1)
+               << ", p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", max " << largest << "\n";
+        }
+        
+        void printBars(std::ostream& os) const {
+            uint64_t tallest = *std::max_element(buckets.begin(), buckets.end());
+            for (size_t i = 0; i < buckets.size() && count > 0; ++i) {
+                if (buckets[i] == 0) continue;
+                std::string range = i + 1 < buckets.size()
+                    ? std::to_string(i * width) + "-" + std::to_string((i + 1) * width - 1)
+                    : std::to_string(i * width) + "+";
+                os << "    " << std::setw(9) << range << " " << std::setw(6) << std::fixed << std::setprecision(2)
+                   << 100.0 * static_cast<double>(buckets[i]) / static_cast<double>(count) << "% "
+                   << std::string(static_cast<size_t>(40 * buckets[i] / tallest), '#') << "\n";
+                os << std::defaultfloat << std::setprecision(6);
+            }
+        }
+    };
+    
+    struct Tally {
+        uint64_t runs = 0;
+        uint64_t wins = 0;
+        uint64_t deaths = 0;
+        uint64_t timeouts = 0;
+        Histogram stepsToWin{10, 50};
+        Histogram score{20, 20};
+        std::map<std::string, uint64_t> pickups; // runs in which the item was picked up
+        
+        void merge(const Tally& other) {
+            runs += other.runs;
+            wins += other.wins;
+            deaths += other.deaths;
+            timeouts += other.timeouts;
+            stepsToWin.merge(other.stepsToWin);
+            score.merge(other.score);
+            for (const auto& entry : other.pickups) pickups[entry.first] += entry.second;
+        }
+        void clear() {
+            runs = wins = deaths = timeouts = 0;
+            stepsToWin.clear();
+            score.clear();
+            pickups.clear();
+        }
+    };
+    
+    // One game from the pristine state; echo, when given, receives the transcript
+    void playRun(Game& game, const std::string& pristine, Agent& agent, const Options& options,
+                 uint64_t run, Tally& tally, std::ostream* echo) {
+        game.restoreState(pristine);
+        game.setSeed(options.seed, run);
+        game.begin("Agent");
+        Random random(options.seed, run | AGENT_STREAM_BIT);
+        agent.reset();
+        
+        std::set<std::string> picked;
+        int steps = 0;
+        while (game.isRunning() && steps < options.maxSteps) {
+            View view = look(game);
+            std::string command = agent.choose(view, random);
+            if (echo) *echo << "> " << command << "\n";
+            CommandStatus status = game.executeCommand(command);
+            ++steps;
+            agent.observe(view, command, status);
+            if (status == CommandStatus::OK && command.rfind("take ", 0) == 0 && game.getPlayer()->hasItem(command.substr(5))) {
+                picked.insert(command.substr(5));
+            }
+        }
+        
+        ++tally.runs;
+        if (!game.getPlayer()->isAlive()) {
+            ++tally.deaths;
+        } else if (game.isRunning()) {
+            ++tally.timeouts;
+        } else {
+            ++tally.wins; // agents never quit, so a game that ended with the player alive was won
+            tally.stepsToWin.add(static_cast<uint64_t>(steps));
+        }
+        tally.score.add(static_cast<uint64_t>(std::max(0, game.getScore())));
+        for (const std::string& item : picked) ++tally.pickups[item];
+    }
+    
+    double percent(uint64_t part, uint64_t whole) {
+        return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+    }
+    
+    // seconds 0 leaves out the timing
+    void report(const std::string& agent, const Tally& tally, double seconds, unsigned threads) {
+        std::cout << std::setprecision(4);
+        std::cout << "agent " << agent << ": " << tally.runs << " runs";
+        if (seconds > 0) {
+            std::cout << " in " << seconds << " s (" << static_cast<uint64_t>(static_cast<double>(tally.runs) / seconds)
+                      << " runs/s on " << threads << " threads)";
+        }
+        std::cout << "\n";
+        std::cout << "  won " << percent(tally.wins, tally.runs) << "%, died " << percent(tally.deaths, tally.runs)
+                  << "%, out of steps " << percent(tally.timeouts, tally.runs) << "%\n";
+        std::cout << "  steps to win: ";
+        tally.stepsToWin.printSummary(std::cout);
+        std::cout << "  score: ";
+        tally.score.printSummary(std::cout);
+        tally.score.printBars(std::cout);
+        
+        std::vector<std::pair<uint64_t, std::string>> items;
+        for (const auto& entry : tally.pickups) items.emplace_back(entry.second, entry.first);
+        std::sort(items.rbegin(), items.rend());
+        std::cout << "  items picked up (share of runs):";
+        for (size_t i = 0; i < items.size(); ++i) {
+            std::cout << (i ? ", " : " ") << items[i].second << " " << percent(items[i].first, tally.runs) << "%";
+        }
+        std::cout << (items.empty() ? " none\n" : "\n");
+    }
+    
+    void runAgent(const std::string& agentName, const Options& options, unsigned threads) {
+        std::atomic<uint64_t> nextRun{0};
+        std::atomic<uint64_t> finished{0};
+        std::mutex totalMutex;
+        Tally total;
+        
+        auto work = [&] {
+            NullBuffer discard;
+            std::ostream sink(&discard);
+            Game game;
+            game.setOutput(sink);
+            game.setTicksPerCommand(options.ticks);
+            const std::string pristine = game.saveState();
+            std::unique_ptr<Agent> agent = makeAgent(agentName);
+            Tally local;
+            while (true) {
+                uint64_t first = nextRun.fetch_add(BATCH_RUNS);
+                if (first >= options.runs) break;
+                uint64_t last = std::min(options.runs, first + BATCH_RUNS);
+                for (uint64_t run = first; run < last; ++run) {
+                    playRun(game, pristine, *agent, options, run, local, nullptr);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(totalMutex);
+                    total.merge(local);
+                }
+                finished += last - first;
+                local.clear();
+            }
+        };
+        
+        auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back(work);
+        }
+        // Progress from the merged batches while the workers play
+        auto nextReport = start + std::chrono::seconds(2);
+        while (finished < options.runs) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (Clock::now() >= nextReport && finished < options.runs) {
+                std::lock_guard<std::mutex> lock(totalMutex);
+                std::cerr << agentName << ": " << total.runs << "/" << options.runs << " runs, won "
+                          << percent(total.wins, total.runs) << "%\n";
+                nextReport += std::chrono::seconds(2);
+            }
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        report(agentName, total, std::chrono::duration<double>(Clock::now() - start).count(), threads);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--runs" && hasValue) options.runs = std::stoull(argv[++i]);
+        else if (arg == "--agent" && hasValue) {
+            std::string agent = argv[++i];
+            if (agent != "all") options.agents = {agent};
+        }
+        else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "--max-steps" && hasValue) options.maxSteps = std::stoi(argv[++i]);
+        else if (arg == "--ticks" && hasValue) options.ticks = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+        else if (arg == "--replay" && hasValue) options.replay = std::stoll(argv[++i]);
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            std::cerr << "Usage: playtest [--runs n] [--agent random|greedy|keys|all] [--threads n]\n"
+                      << "                [--max-steps n] [--ticks n] [--seed n] [--replay run]\n";
+            return 1;
+        }
+    }
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    
+    try {
+        for (const std::string& agent : options.agents) {
+            makeAgent(agent); // reject unknown names before playing
+        }
+        if (options.replay >= 0) {
+            if (options.agents.size() != 1) {
+                throw std::runtime_error("--replay needs one --agent");
+            }
+            Game game;
+            game.setTicksPerCommand(options.ticks);
+            const std::string pristine = game.saveState();
+            std::unique_ptr<Agent> agent = makeAgent(options.agents.front());
+            Tally tally;
+            playRun(game, pristine, *agent, options, static_cast<uint64_t>(options.replay), tally, &std::cout);
+            std::cout << "\n";
+            report(options.agents.front(), tally, 0, 1);
+            return 0;
+        }
+        for (const std::string& agent : options.agents) {
+            runAgent(agent, options, threads);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Item conservation stress test for the shared world (SharedWorld.h).
+//
+// Puts many bots into one shared world and has several threads submit
+// contended commands for them at once: takes and drops of the same items,
+// moves and looks. After every round it waits for the actors to go quiet
+// and audits the world: every item must still exist exactly as many times
+// as when the world was loaded, and every command must have been answered
+// exactly once. Exits with status 1 on the first round that fails.
+//
+//   sharedstress [--world worlds/forgotten_island.world] [--bots 200]
+//                [--commands 200000] [--rounds 20] [--threads n]
+//                [--workers n] [--seed 1]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Random.h"
+#include "SharedWorld.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        std::string worldPath = "worlds/forgotten_island.world";
+        int bots = 200;
+        uint64_t commands = 200000;
+        int rounds = 20;
+        unsigned threads = 0;
+        int workers = 0;
+        uint64_t seed = 1;
+    };
+    
+    const char* const DIRECTIONS[] = {"n", "s", "e", "w", "u", "d"};
+    
+    // A command for one bot: mostly takes and drops of items anyone may be
+    // reaching for, so rooms and players trade the same items constantly
+    std::string pickCommand(Random& random, const std::vector<std::string>& itemNames) {
+        uint32_t roll = random.below(100);
+        if (roll < 40) return "take " + itemNames[random.below(static_cast<uint32_t>(itemNames.size()))];
+        if (roll < 70) return "drop " + itemNames[random.below(static_cast<uint32_t>(itemNames.size()))];
+        if (roll < 90) return DIRECTIONS[random.below(6)];
+        if (roll < 95) return "look";
+        return "inventory";
+    }
+    
+    // Prints every item whose count changed; true when none did
+    bool audit(const std::map<std::string, int>& expected, const std::map<std::string, int>& actual) {
+        bool conserved = true;
+        std::map<std::string, int> names = expected;
+        names.insert(actual.begin(), actual.end());
+        for (const auto& entry : names) {
+            auto want = expected.find(entry.first);
+            auto have = actual.find(entry.first);
+            int wanted = want != expected.end() ? want->second : 0;
+            int found = have != actual.end() ? have->second : 0;
+            if (wanted != found) {
+                std::cout << "  " << entry.first << ": " << found << " (expected " << wanted << ", "
+                          << (found > wanted ? "duplicated" : "lost") << ")\n";
+                conserved = false;
+            }
+        }
+        return conserved;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--world" && hasValue) options.worldPath = argv[++i];
+        else if (arg == "--bots" && hasValue) options.bots = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--commands" && hasValue) options.commands = std::stoull(argv[++i]);
+        else if (arg == "--rounds" && hasValue) options.rounds = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "--workers" && hasValue) options.workers = std::stoi(argv[++i]);
+        else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            std::cerr << "Usage: sharedstress [--world file] [--bots n] [--commands n] [--rounds n]\n"
+                      << "                    [--threads n] [--workers n] [--seed n]\n";
+            return 1;
+        }
+    }
+    unsigned threads = options.threads ? options.threads : std::max(2u, std::thread::hardware_concurrency());
+    
+    try {
+        WorldFile worldFile(options.worldPath);
+        SharedWorld world(worldFile, options.workers);
+        const std::map<std::string, int> expected = world.countItems();
+        std::vector<std::string> itemNames;
+        for (const auto& entry : expected) {
+            itemNames.push_back(entry.first);
+        }
+        if (itemNames.empty()) {
+            throw std::runtime_error("the world has no items to contend for");
+        }
+        
+        std::atomic<uint64_t> replies{0};
+        std::vector<PlayerActor*> bots;
+        for (int i = 0; i < options.bots; ++i) {
+            bots.push_back(world.addPlayer("bot" + std::to_string(i), [&replies](const std::string&) {
+                replies.fetch_add(1, std::memory_order_relaxed);
+            }));
+        }
+        uint64_t answered = static_cast<uint64_t>(options.bots); // each arrival in the start room
+        
+        std::cout << "Shared world: " << world.getRoomCount() << " rooms, " << itemNames.size()
+                  << " item names, " << options.bots << " bots, " << world.getWorkerCount()
+                  << " workers, " << threads << " submitting threads\n";
+        
+        auto start = Clock::now();
+        uint64_t perRound = options.commands / static_cast<uint64_t>(options.rounds);
+        for (int round = 0; round < options.rounds; ++round) {
+            std::vector<std::thread> submitters;
+            for (unsigned t = 0; t < threads; ++t) {
+                uint64_t share = perRound / threads + (t < perRound % threads ? 1 : 0);
+                submitters.emplace_back([&, t, share] {
+                    Random random(options.seed, static_cast<uint64_t>(round) * threads + t);
+                    for (uint64_t n = 0; n < share; ++n) {
+                        PlayerActor* bot = bots[random.below(static_cast<uint32_t>(bots.size()))];
+                        world.submit(bot, pickCommand(random, itemNames));
+                    }
+                });
+            }
+            for (std::thread& submitter : submitters) {
+                submitter.join();
+            }
+            world.waitForQuiescence();
+            answered += perRound;
+            
+            bool conserved = audit(expected, world.countItems());
+            uint64_t replied = replies.load(std::memory_order_relaxed);
+            if (replied != answered) {
+                std::cout << "  " << replied << " replies for " << answered << " commands and arrivals\n";
+            }
+            if (!conserved || replied != answered) {
+                std::cout << "FAILED in round " << round + 1 << " of " << options.rounds << "\n";
+                return 1;
+            }
+        }
+        
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "OK: " << perRound * static_cast<uint64_t>(options.rounds) << " commands in "
+                  << options.rounds << " rounds, every item conserved and every command answered ("
+                  << static_cast<uint64_t>(static_cast<double>(perRound) * options.rounds / std::max(seconds, 1e-9))
+                  << " commands/s)\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
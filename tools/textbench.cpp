@@ -0,0 +1,118 @@
+// Benchmark for compressed world text (TextStore).
+//
+// Loads every room of a world file, which compresses the room and item
+// descriptions against the dictionary trained when the file was indexed,
+// then reports the compression ratio and replays room views drawn from a
+// Zipf distribution (a few rooms are visited far more than the rest) to
+// measure the description cache and the decompression cost per view.
+//
+//   textbench --world <file> [--views 200000] [--zipf 1.0] [--cache-kb 256] [--seed 1]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "Compression.h"
+#include "WorldFile.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string worldPath;
+    size_t views = 200000;
+    double zipf = 1.0;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--world" && hasValue) worldPath = argv[++i];
+        else if (arg == "--views" && hasValue) views = std::stoul(argv[++i]);
+        else if (arg == "--zipf" && hasValue) zipf = std::stod(argv[++i]);
+        else if (arg == "--seed" && hasValue) seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    if (worldPath.empty()) {
+        std::cerr << "Usage: textbench --world <file> [--views n] [--zipf s] [--seed n]\n";
+        return 1;
+    }
+    
+    try {
+        auto start = Clock::now();
+        WorldFile world(worldPath);
+        double indexSeconds = secondsSince(start);
+        
+        std::vector<std::unique_ptr<Room>> rooms;
+        start = Clock::now();
+        for (int region = 0; region < world.getRegionCount(); ++region) {
+            for (int roomId : world.getRegionRooms(region)) {
+                rooms.push_back(world.loadRoom(roomId));
+            }
+        }
+        double loadSeconds = secondsSince(start);
+        
+        // Baseline: the same texts compressed one by one without a dictionary
+        uint64_t plainCompressed = 0;
+        for (const auto& room : rooms) {
+            plainCompressed += lzCompress(room->getDescription()).size();
+        }
+        
+        const TextStore& store = world.getTextStore();
+        TextStoreStats loaded = store.getStats();
+        
+        std::vector<double> weights(rooms.size());
+        for (size_t i = 0; i < weights.size(); ++i) {
+            weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), zipf);
+        }
+        std::mt19937 rng(seed);
+        std::shuffle(rooms.begin(), rooms.end(), rng); // the hot rooms are not the first ones in the file
+        std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+        
+        size_t shownBytes = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < views; ++i) {
+            shownBytes += rooms[pick(rng)]->getDescription().size();
+        }
+        double viewSeconds = secondsSince(start);
+        TextStoreStats viewed = store.getStats();
+        
+        uint64_t stored = loaded.compressedBytes + loaded.dictionaryBytes;
+        uint64_t viewCount = viewed.views - loaded.views;
+        uint64_t hits = viewed.cacheHits - loaded.cacheHits;
+        uint64_t misses = viewCount - hits;
+        uint64_t missNanos = viewed.decompressNanos - loaded.decompressNanos;
+        
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "World:        " << world.getRoomCount() << " rooms, indexed in " << indexSeconds * 1000
+                  << " ms, all loaded in " << loadSeconds * 1000 << " ms\n";
+        std::cout << "Texts:        " << loaded.texts << " distinct, " << loaded.rawBytes << " bytes raw\n";
+        std::cout << "Stored:       " << loaded.compressedBytes << " bytes + " << loaded.dictionaryBytes
+                  << " bytes dictionary, ratio " << static_cast<double>(loaded.rawBytes) / std::max<uint64_t>(stored, 1)
+                  << "x\n";
+        std::cout << "No dictionary: " << plainCompressed << " bytes for the room texts alone\n";
+        std::cout << "Views:        " << viewCount << " (zipf " << zipf << "), " << shownBytes << " bytes shown, "
+                  << viewSeconds * 1e9 / std::max<uint64_t>(viewCount, 1) << " ns per view\n";
+        std::cout << "Cache:        " << 100.0 * hits / std::max<uint64_t>(viewCount, 1) << "% hits, "
+                  << viewed.cachedBytes << " bytes held\n";
+        std::cout << "Decompress:   " << static_cast<double>(missNanos) / std::max<uint64_t>(misses, 1)
+                  << " ns per miss, " << static_cast<double>(missNanos) / std::max<uint64_t>(viewCount, 1)
+                  << " ns per view on average\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}